@@ -1,6 +1,8 @@
 /* eslint-env jest */
 /* eslint-disable @typescript-eslint/no-var-requires */
 
+const fs = require('fs')
+const os = require('os')
 const path = require('path')
 const util = require('util')
 const exec = util.promisify(require('child_process').exec)
@@ -27,6 +29,16 @@ const cli = async args => {
   }
 }
 
+// encode blocks one after the other, as in a binary ledger
+const encodeBlocks = blocks => {
+  const ledger = Buffer.alloc(blocks.length * nano.STATE_BLOCK_LENGTH)
+  blocks.forEach((block, index) =>
+    nano.encodeBlock(block, ledger, index * nano.STATE_BLOCK_LENGTH)
+  )
+
+  return ledger
+}
+
 describe('check', () => {
   test('seed', async () => {
     expect.assertions(6)
@@ -195,6 +207,139 @@ describe('convert', () => {
   })
 })
 
+describe('compute', () => {
+  const HASH =
+    'b9cb6b51b8eb869af085c4c03e7dc539943d0bdde13b21436b687c9c7ea56cb0'
+  const WORK = '0000000000010600'
+
+  test('work', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(`compute work --hash ${HASH}`)
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(WORK)
+    expect(stderr).toBe('')
+  })
+
+  test('work with threads', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      `compute work --hash ${HASH} --threads 2`
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(WORK)
+    expect(stderr).toBe('')
+  })
+
+  test('work with processes', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      `compute work --hash ${HASH} --processes 2`
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(WORK)
+    expect(stderr).toBe('')
+  })
+
+  test('work in batch', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      'compute work --batch --threads 2 < ' +
+        path.join(__dirname, 'data/hashes.txt')
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(`${HASH} ${WORK}\n${HASH} ${WORK}`)
+    expect(stderr).toBe('')
+  })
+
+  test('work in batch with processes', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      'compute work --batch --processes 2 < ' +
+        path.join(__dirname, 'data/hashes.txt')
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(`${HASH} ${WORK}\n${HASH} ${WORK}`)
+    expect(stderr).toBe('')
+  })
+
+  describe('weights', () => {
+    const BLOCKS_PATH = path.join(__dirname, 'data/blocks.ndjson')
+    const LEDGER_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-weights.bin')
+    const blocks = fs
+      .readFileSync(BLOCKS_PATH, 'utf8')
+      .trim()
+      .split('\n')
+      .map(line => {
+        const { secretKey, data } = JSON.parse(line)
+        return nano.createBlock(secretKey, data).block
+      })
+
+    beforeAll(() => {
+      fs.writeFileSync(LEDGER_PATH, encodeBlocks(blocks))
+    })
+
+    afterAll(() => fs.unlinkSync(LEDGER_PATH))
+
+    test('ledger', async () => {
+      expect.assertions(3)
+      const { stdout, stderr, code } = await cli(
+        `compute weights --path ${LEDGER_PATH} --format binary`
+      )
+      expect(code).toBe(0)
+      // the representative of the empty account has no weight
+      expect(stdout.trimRight()).toBe(
+        `${blocks[2].representative} 3829201371931432594706\n` +
+          `${blocks[0].representative} 881686`
+      )
+      expect(stderr).toMatch(
+        /^3 accounts, 3829201371931433476392 raw of 340282366920938463463374607431768211455 raw/
+      )
+    })
+
+    test('ledger over the supply', async () => {
+      expect.assertions(2)
+      const { stderr, code } = await cli(
+        `compute weights --path ${LEDGER_PATH} --format binary --supply 1000`
+      )
+      expect(code).toBe(1)
+      expect(stderr).toMatch(/the total exceeds the supply/)
+    })
+  })
+})
+
+describe('hash', () => {
+  // longer than a 16 MiB read, and not a multiple of a BLAKE2bp stripe
+  const FILE_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-hash-file')
+  const FILE_HASH =
+    'fa8e90bd125d4539f8a5d06e26a0b5f53182ab551b5f94c5a513f538cab4320c'
+
+  beforeAll(() => {
+    const data = Buffer.alloc(17000000)
+    for (let i = 0; i < data.length; i++) data[i] = (i * 7) & 0xff
+    fs.writeFileSync(FILE_PATH, data)
+  })
+
+  afterAll(() => fs.unlinkSync(FILE_PATH))
+
+  test('file', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(`hash file --path ${FILE_PATH}`)
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(`${FILE_HASH}  ${FILE_PATH}`)
+    expect(stderr).toMatch(/^17\.0 MB in .* MB\/s/)
+  })
+
+  test('file with threads', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      `hash file --path ${FILE_PATH} --threads`
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight()).toBe(`${FILE_HASH}  ${FILE_PATH}`)
+    expect(stderr).toMatch(/^17\.0 MB in .* MB\/s/)
+  })
+})
+
 describe('sign', () => {
   test('block', async () => {
     expect.assertions(3)
@@ -230,6 +375,158 @@ describe('verify', () => {
       expect(stderr).toBe('')
     }
   })
+
+  describe('ledger', () => {
+    const BLOCKS_PATH = path.join(__dirname, 'data/blocks.ndjson')
+    const NDJSON_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-ledger')
+    const BINARY_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-ledger.bin')
+    const SNAPSHOT_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-snapshot')
+    const INVALID_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-invalid')
+    const blocks = fs
+      .readFileSync(BLOCKS_PATH, 'utf8')
+      .trim()
+      .split('\n')
+      .map(line => {
+        const { secretKey, data } = JSON.parse(line)
+        return nano.createBlock(secretKey, data)
+      })
+
+    beforeAll(() => {
+      fs.writeFileSync(
+        NDJSON_PATH,
+        blocks.map(block => JSON.stringify(block)).join('\n') + '\n'
+      )
+
+      // the work of the last block is zeroed
+      const ledger = encodeBlocks(blocks.map(({ block }) => block))
+      ledger.fill(0, ledger.length - 8)
+      fs.writeFileSync(BINARY_PATH, ledger)
+    })
+
+    afterAll(() => {
+      fs.unlinkSync(NDJSON_PATH)
+      fs.unlinkSync(BINARY_PATH)
+      if (fs.existsSync(SNAPSHOT_PATH)) fs.unlinkSync(SNAPSHOT_PATH)
+      if (fs.existsSync(INVALID_PATH)) fs.unlinkSync(INVALID_PATH)
+    })
+
+    test('ndjson', async () => {
+      expect.assertions(3)
+      const { stdout, stderr, code } = await cli('verify ledger < ' + NDJSON_PATH)
+      expect(code).toBe(0)
+      expect(stdout).toBe('')
+      expect(stderr).toMatch(/^3 blocks in .* blocks\/s, 0 failures/)
+    })
+
+    test('ndjson with invalid lines', async () => {
+      expect.assertions(4)
+      const lines = fs.readFileSync(NDJSON_PATH, 'utf8').split('\n')
+      fs.writeFileSync(
+        INVALID_PATH,
+        [lines[0], '{}', ...lines.slice(1)].join('\n')
+      )
+      const offset = lines[0].length + 1
+
+      const failed = await cli('verify ledger < ' + INVALID_PATH)
+      expect(failed.stderr).toMatch(`Block is not valid at offset ${offset}`)
+
+      const { stdout, stderr, code } = await cli(
+        'verify ledger --skip-invalid < ' + INVALID_PATH
+      )
+      expect(code).toBe(1)
+      expect(stdout).toBe('')
+      expect(stderr).toMatch(
+        new RegExp(
+          `^Block is not valid at offset ${offset}\n3 blocks in .* 1 failures`
+        )
+      )
+    })
+
+    test('binary with threads', async () => {
+      expect.assertions(3)
+      const { stdout, stderr, code } = await cli(
+        `verify ledger --path ${BINARY_PATH} --format binary --threads 2`
+      )
+      expect(code).toBe(1)
+      expect(stdout.trimRight()).toBe(`2 ${blocks[2].hash} work`)
+      expect(stderr).toMatch(/^3 blocks in .* blocks\/s, 1 failures/)
+    })
+
+    test('binary with thresholds', async () => {
+      expect.assertions(3)
+      const { stdout, stderr, code } = await cli(
+        `verify ledger --path ${BINARY_PATH} --format binary --threshold 0000000000000000 --receive-threshold 0000000000000000`
+      )
+      expect(code).toBe(0)
+      expect(stdout).toBe('')
+      expect(stderr).toMatch(/^3 blocks in .* blocks\/s, 0 failures/)
+    })
+
+    test('snapshot', async () => {
+      expect.assertions(5)
+      const created = await cli(
+        `create snapshot --path ${BINARY_PATH} --format binary --output ${SNAPSHOT_PATH}`
+      )
+      expect(created.code).toBe(0)
+      expect(created.stderr).toMatch(/^3 blocks, 648 bytes to \d+ bytes/)
+
+      const { stdout, stderr, code } = await cli(
+        `verify ledger --path ${SNAPSHOT_PATH} --format snapshot`
+      )
+      expect(code).toBe(1)
+      expect(stdout.trimRight()).toBe(`2 ${blocks[2].hash} work`)
+      expect(stderr).toMatch(/^3 blocks in .* blocks\/s, 1 failures/)
+    })
+  })
+})
+
+describe('scan', () => {
+  const BLOCKS_PATH = path.join(__dirname, 'data/blocks.ndjson')
+  const LEDGER_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-scan.bin')
+  const KEYS_PATH = path.join(os.tmpdir(), 'nanocurrency-cli-scan-keys')
+  const blocks = fs
+    .readFileSync(BLOCKS_PATH, 'utf8')
+    .trim()
+    .split('\n')
+    .map(line => {
+      const { secretKey, data } = JSON.parse(line)
+      return nano.createBlock(secretKey, data)
+    })
+  const DESTINATION = blocks[2].block.link_as_account
+
+  beforeAll(() => {
+    fs.writeFileSync(LEDGER_PATH, encodeBlocks(blocks.map(({ block }) => block)))
+    // an address, and a public key nothing is sent to
+    fs.writeFileSync(KEYS_PATH, `${DESTINATION}\n${'0'.repeat(63)}1\n`)
+  })
+
+  afterAll(() => {
+    fs.unlinkSync(LEDGER_PATH)
+    fs.unlinkSync(KEYS_PATH)
+  })
+
+  test('ledger', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      `scan ledger --keys ${KEYS_PATH} --path ${LEDGER_PATH} --format binary`
+    )
+    expect(code).toBe(0)
+    // the previous block of the sender is not in the ledger
+    expect(stdout.trimRight()).toBe(
+      `2 ${blocks[2].hash} ${DESTINATION} unknown`
+    )
+    expect(stderr).toMatch(/^3 blocks in .* blocks\/s/)
+  })
+
+  test('ledger with missing keys', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      `scan ledger --keys ${KEYS_PATH}.missing --path ${LEDGER_PATH} --format binary`
+    )
+    expect(code).toBe(1)
+    expect(stdout).toBe('')
+    expect(stderr).toMatch('no such file or directory')
+  })
 })
 
 describe('validate', () => {
@@ -304,6 +601,37 @@ describe('derive', () => {
 })
 
 describe('create', () => {
+  const BLOCKS_PATH = path.join(__dirname, 'data/blocks.ndjson')
+  const expectedBlocks = () =>
+    fs
+      .readFileSync(BLOCKS_PATH, 'utf8')
+      .trim()
+      .split('\n')
+      .map(line => {
+        const { secretKey, data } = JSON.parse(line)
+        return JSON.stringify(nano.createBlock(secretKey, data))
+      })
+
+  test('blocks', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      'create blocks < ' + BLOCKS_PATH
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight().split('\n')).toEqual(expectedBlocks())
+    expect(stderr).toBe('')
+  })
+
+  test('blocks with threads', async () => {
+    expect.assertions(3)
+    const { stdout, stderr, code } = await cli(
+      'create blocks --threads 2 < ' + BLOCKS_PATH
+    )
+    expect(code).toBe(0)
+    expect(stdout.trimRight().split('\n')).toEqual(expectedBlocks())
+    expect(stderr).toBe('')
+  })
+
   test('block', async () => {
     expect.assertions(3)
     const { stdout, stderr, code } = await cli(
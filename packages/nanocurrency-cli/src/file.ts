@@ -0,0 +1,156 @@
+import { promises as fs } from 'fs'
+import * as nanocurrency from 'nanocurrency'
+import { createWorkerCaller, spawnWorker, WorkerResponse } from './pool'
+
+/** BLAKE2bp has four leaves, so it cannot be spread on more threads. */
+const BLAKE2BP_LEAVES = 4
+/** Large sequential reads, a multiple of the 512 bytes BLAKE2bp stripe. */
+const CHUNK_LENGTH = 16 * 1024 * 1024
+
+/** Hash file parameters. */
+export interface HashFileParams {
+  /** The length of the hash, between 1 and 64 bytes */
+  outputLength: number
+  /** Whether to hash each leaf on its own worker thread */
+  threads: boolean
+}
+
+/** A file hash, and the count of bytes hashed. */
+export interface FileHash {
+  hash: string
+  length: number
+}
+
+/** The leaves fed by the same chunks, wherever they are hashed. */
+interface Leaves {
+  update(data: Uint8Array): Promise<void>
+  digest(): Promise<Uint8Array[]>
+  close(): void
+}
+
+async function createLocalLeaves(outputLength: number): Promise<Leaves> {
+  const leaves: nanocurrency.Blake2bpLeaf[] = []
+  for (let index = 0; index < BLAKE2BP_LEAVES; index++) {
+    leaves.push(await nanocurrency.createBlake2bpLeaf(outputLength, index))
+  }
+
+  return {
+    update: async data => {
+      for (const leaf of leaves) leaf.update(data)
+    },
+    digest: async () => leaves.map(leaf => leaf.digest()),
+    close: () => undefined,
+  }
+}
+
+async function createThreadLeaves(outputLength: number): Promise<Leaves> {
+  const workers = Array.from({ length: BLAKE2BP_LEAVES }, () =>
+    spawnWorker('thread')
+  )
+  const calls = workers.map(createWorkerCaller)
+  const close = (): void => {
+    for (const worker of workers) worker.terminate()
+  }
+
+  try {
+    await Promise.all(
+      calls.map((call, index) =>
+        call({ type: 'blake2bp-init', outputLength, index })
+      )
+    )
+  } catch (err) {
+    close()
+    throw err
+  }
+
+  return {
+    update: async data => {
+      await Promise.all(
+        calls.map(call => call({ type: 'blake2bp-update', data }))
+      )
+    },
+    digest: async () => {
+      const responses = await Promise.all(
+        calls.map(call => call({ type: 'blake2bp-digest' }))
+      )
+
+      return responses.map((response: WorkerResponse) => {
+        if (response.type !== 'blake2bp' || response.leafHash === null) {
+          throw new Error('Leaf hash is not valid')
+        }
+
+        return Buffer.from(response.leafHash, 'hex')
+      })
+    },
+    close,
+  }
+}
+
+async function readChunk(
+  file: fs.FileHandle,
+  dst: Uint8Array
+): Promise<number> {
+  let length = 0
+
+  while (length < dst.length) {
+    const { bytesRead } = await file.read(dst, length, dst.length - length)
+    if (bytesRead === 0) break
+    length += bytesRead
+  }
+
+  return length
+}
+
+/**
+ * Compute the BLAKE2bp hash of a file. The next chunk of the file is read
+ * while the current one is hashed, and with threads the chunks are shared
+ * with the workers rather than copied.
+ *
+ * @param path - The path of the file
+ * @param params - Parameters
+ * @returns Hash, in hexadecimal format, and the file length
+ */
+export async function hashFile(
+  path: string,
+  params: HashFileParams
+): Promise<FileHash> {
+  const file = await fs.open(path, 'r')
+  const leaves = await (params.threads
+    ? createThreadLeaves(params.outputLength)
+    : createLocalLeaves(params.outputLength))
+
+  try {
+    const buffers = params.threads
+      ? [0, 1].map(() => new Uint8Array(new SharedArrayBuffer(CHUNK_LENGTH)))
+      : [0, 1].map(() => new Uint8Array(CHUNK_LENGTH))
+
+    let current = 0
+    let chunkLength = await readChunk(file, buffers[current])
+    let length = 0
+
+    while (chunkLength > 0) {
+      // a short chunk is the last one
+      const reading =
+        chunkLength === CHUNK_LENGTH
+          ? readChunk(file, buffers[1 - current])
+          : Promise.resolve(0)
+      await leaves.update(buffers[current].subarray(0, chunkLength))
+      const nextLength = await reading
+
+      length += chunkLength
+      current = 1 - current
+      chunkLength = nextLength
+    }
+
+    const leafHashes = await leaves.digest()
+    const hash = await nanocurrency.blake2bpRoot(
+      leafHashes,
+      params.outputLength
+    )
+
+    return { hash: Buffer.from(hash).toString('hex'), length }
+  } finally {
+    leaves.close()
+    await file.close()
+  }
+}
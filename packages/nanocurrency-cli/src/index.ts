@@ -1,6 +1,17 @@
 #!/usr/bin/env node
+import * as fs from 'fs'
+import * as readline from 'readline'
 import * as yargs from 'yargs'
 import * as nanocurrency from 'nanocurrency'
+import { hashFile } from './file'
+import {
+  aggregateLedgerStream,
+  LedgerFormat,
+  scanLedgerStream,
+  verifyLedgerStream,
+  writeLedgerSnapshot,
+} from './ledger'
+import { createBlocksInParallel, createWorkPool } from './pool'
 
 const wrapSubcommand = (yargs: yargs.Argv): yargs.Argv =>
   yargs
@@ -12,6 +23,23 @@ const wrapSubcommand = (yargs: yargs.Argv): yargs.Argv =>
     .version(false)
     .wrap(null)
 
+const readLines = (input: NodeJS.ReadableStream): Promise<string[]> =>
+  new Promise((resolve, reject) => {
+    const lines: string[] = []
+    // a missing or unreadable file fails the command, rather than the process
+    input.on('error', reject)
+    readline
+      .createInterface({ input })
+      .on('line', line => {
+        if (line.trim() !== '') lines.push(line.trim())
+      })
+      .on('close', () => resolve(lines))
+  })
+
+const checkWorkerCount = (count: number | undefined): boolean =>
+  typeof count === 'undefined' ||
+  (Number.isInteger(count) && count >= 1 && count <= 255)
+
 yargs
   .usage('usage: $0 <command>')
   .command(
@@ -194,91 +222,415 @@ yargs
       )
     )
   })
-  .command('compute', 'compute a [work]', yargs => {
+  .command('compute', 'compute a [work|weights]', yargs => {
     return wrapSubcommand(
-      yargs.usage('usage: $0 compute <item>').command(
-        'work',
-        'compute a work',
+      yargs
+        .usage('usage: $0 compute <item>')
+        .command(
+          'work',
+          'compute a work',
+          yargs => {
+            return yargs
+              .usage('usage: $0 compute work [options]')
+              .option('hash', {
+                describe: 'block hash to compute a work for',
+                type: 'string',
+              })
+              .option('batch', {
+                describe:
+                  'read block hashes from stdin, one per line, and print "<hash> <work>" lines',
+                type: 'boolean',
+                default: false,
+                conflicts: 'hash',
+              })
+              .option('threads', {
+                describe:
+                  'count of worker threads to spread the computation on',
+                type: 'number',
+                conflicts: 'processes',
+              })
+              .option('processes', {
+                describe: 'count of processes to spread the computation on',
+                type: 'number',
+              })
+              .check(argv => {
+                if (!argv.batch && typeof argv.hash === 'undefined') {
+                  throw new Error('Missing required argument: hash')
+                }
+                if (!checkWorkerCount(argv.threads)) {
+                  throw new Error(
+                    'Threads must be an integer between 1 and 255'
+                  )
+                }
+                if (!checkWorkerCount(argv.processes)) {
+                  throw new Error(
+                    'Processes must be an integer between 1 and 255'
+                  )
+                }
+
+                return true
+              })
+          },
+          async argv => {
+            const hashes = argv.batch
+              ? await readLines(process.stdin)
+              : [argv.hash as string]
+
+            const workerCount = argv.threads ?? argv.processes
+            const kind =
+              typeof argv.threads !== 'undefined' ? 'thread' : 'process'
+
+            // the same workers compute the work of every hash
+            const pool =
+              typeof workerCount === 'undefined'
+                ? null
+                : createWorkPool({ kind, workerCount })
+
+            try {
+              for (const hash of hashes) {
+                let work: string | null
+                if (pool === null) {
+                  work = await nanocurrency.computeWork(hash)
+                } else {
+                  if (!nanocurrency.checkHash(hash)) {
+                    throw new Error('Hash is not valid')
+                  }
+                  work = await pool.computeWork(hash)
+                }
+
+                console.log(argv.batch ? `${hash} ${work}` : work)
+              }
+            } finally {
+              if (pool !== null) pool.terminate()
+            }
+          }
+        )
+        .command(
+          'weights',
+          'compute the voting weight of every representative, and check the total of the balances against the supply',
+          yargs => {
+            return yargs
+              .usage('usage: $0 compute weights [options]')
+              .option('path', {
+                describe: 'path of the ledger export. Defaults to stdin',
+                type: 'string',
+              })
+              .option('format', {
+                describe:
+                  'JSON blocks one per line, 216 bytes binary blocks back to back, or a snapshot',
+                choices: ['ndjson', 'binary', 'snapshot'],
+                default: 'ndjson',
+              })
+              .option('supply', {
+                describe: 'supply to check the total against, in raw',
+                type: 'string',
+              })
+              .epilogue(
+                'the latest block of every account sets its balance and representative. Prints "<representative> <weight>" lines from the heaviest representative, and the totals on stderr'
+              )
+          },
+          async argv => {
+            const input =
+              typeof argv.path === 'undefined'
+                ? process.stdin
+                : fs.createReadStream(argv.path)
+
+            const report = await aggregateLedgerStream(input, {
+              format: argv.format as LedgerFormat,
+              supply: argv.supply,
+            })
+            for (const { representative, weight } of report.weights) {
+              console.log(`${representative} ${weight}`)
+            }
+
+            const { accountCount, total, supply, unaccounted } = report
+            console.error(
+              `${accountCount} accounts, ${total} raw of ${supply} raw, ${unaccounted} raw receivable or burned`
+            )
+            if (report.exceedsSupply) {
+              console.error('the total exceeds the supply')
+              process.exitCode = 1
+            }
+          }
+        )
+    )
+  })
+  .command('hash', 'hash a [file]', yargs => {
+    return wrapSubcommand(
+      yargs.usage('usage: $0 hash <item>').command(
+        'file',
+        'hash a file with BLAKE2bp, and print the throughput on stderr',
         yargs => {
           return yargs
-            .usage('usage: $0 compute work [options]')
-            .option('hash', {
+            .usage('usage: $0 hash file [options]')
+            .option('path', {
               demandOption: true,
-              describe: 'block hash to compute a work for',
+              describe: 'path of the file to hash',
               type: 'string',
             })
+            .option('length', {
+              describe: 'length of the hash, in bytes',
+              type: 'number',
+              default: 32,
+            })
+            .option('threads', {
+              describe: 'hash each of the four BLAKE2bp leaves on a thread',
+              type: 'boolean',
+              default: false,
+            })
         },
         async argv => {
-          const work = await nanocurrency.computeWork(argv.hash)
-          console.log(work)
+          const start = Date.now()
+          const { hash, length } = await hashFile(argv.path, {
+            outputLength: argv.length,
+            threads: argv.threads,
+          })
+          const seconds = Math.max(Date.now() - start, 1) / 1000
+          const megabytes = length / 1e6
+          const throughput = (megabytes / seconds).toFixed(1)
+
+          console.log(`${hash}  ${argv.path}`)
+          console.error(
+            `${megabytes.toFixed(1)} MB in ${seconds.toFixed(2)} s, ${throughput} MB/s`
+          )
         }
       )
     )
   })
-  .command('sign', 'sign a [block]', yargs => {
+  .command('scan', 'scan a [ledger]', yargs => {
     return wrapSubcommand(
-      yargs.usage('usage: $0 sign <item>').command(
-        'block',
-        'sign a block',
+      yargs.usage('usage: $0 scan <item>').command(
+        'ledger',
+        'find the blocks of a ledger export sending to a set of accounts',
         yargs => {
           return yargs
-            .usage('usage: $0 sign block [options]')
-            .option('secret', {
+            .usage('usage: $0 scan ledger [options]')
+            .option('keys', {
               demandOption: true,
-              describe: 'secret key to sign the block with',
+              describe:
+                'path of the accounts to find the receivable blocks of, one public key or address per line',
               type: 'string',
             })
-            .option('hash', {
-              demandOption: true,
-              describe: 'hash of the block to sign',
+            .option('path', {
+              describe: 'path of the ledger export. Defaults to stdin',
               type: 'string',
             })
+            .option('format', {
+              describe:
+                'JSON blocks one per line, 216 bytes binary blocks back to back, or a snapshot',
+              choices: ['ndjson', 'binary', 'snapshot'],
+              default: 'ndjson',
+            })
+            .epilogue(
+              'prints "<index> <hash> <destination> <amount>" lines for the receivable blocks, the amount in raw or "unknown" when the previous block of the sender is not in the ledger, and the throughput on stderr'
+            )
         },
         async argv => {
-          const signature = await nanocurrency.signBlock({
-            hash: argv.hash,
-            secretKey: argv.secret,
+          const lines = await readLines(fs.createReadStream(argv.keys))
+          const publicKeys = lines.map(line =>
+            nanocurrency.checkAddress(line)
+              ? nanocurrency.derivePublicKey(line)
+              : line
+          )
+          const input =
+            typeof argv.path === 'undefined'
+              ? process.stdin
+              : fs.createReadStream(argv.path)
+
+          const start = Date.now()
+          const blockCount = await scanLedgerStream(input, {
+            format: argv.format as LedgerFormat,
+            publicKeys,
+            onReceivable: ({ index, hash, destination, amount }) =>
+              console.log(
+                `${index} ${hash} ${destination} ${amount ?? 'unknown'}`
+              ),
           })
-          console.log(signature)
+          const seconds = Math.max(Date.now() - start, 1) / 1000
+          const throughput = (blockCount / seconds).toFixed(0)
+
+          console.error(
+            `${blockCount} blocks in ${seconds.toFixed(2)} s, ${throughput} blocks/s`
+          )
         }
       )
     )
   })
-  .command('verify', 'verify a [block]', yargs => {
+  .command('sign', 'sign a [block]', yargs => {
     return wrapSubcommand(
-      yargs.usage('usage: $0 verify <item>').command(
+      yargs.usage('usage: $0 sign <item>').command(
         'block',
-        'verify a block',
+        'sign a block',
         yargs => {
           return yargs
-            .usage('usage: $0 verify block [options]')
-            .option('public', {
+            .usage('usage: $0 sign block [options]')
+            .option('secret', {
               demandOption: true,
-              describe: 'public key to verify the signature against',
+              describe: 'secret key to sign the block with',
               type: 'string',
             })
             .option('hash', {
               demandOption: true,
-              describe: 'hash of the block to verify',
-              type: 'string',
-            })
-            .option('signature', {
-              demandOption: true,
-              describe: 'signature to verify',
+              describe: 'hash of the block to sign',
               type: 'string',
             })
         },
         async argv => {
-          const valid = await nanocurrency.verifyBlock({
+          const signature = await nanocurrency.signBlock({
             hash: argv.hash,
-            publicKey: argv.public,
-            signature: argv.signature,
+            secretKey: argv.secret,
           })
-          console.log(valid)
+          console.log(signature)
         }
       )
     )
   })
+  .command('verify', 'verify a [block|ledger]', yargs => {
+    return wrapSubcommand(
+      yargs
+        .usage('usage: $0 verify <item>')
+        .command(
+          'block',
+          'verify a block',
+          yargs => {
+            return yargs
+              .usage('usage: $0 verify block [options]')
+              .option('public', {
+                demandOption: true,
+                describe: 'public key to verify the signature against',
+                type: 'string',
+              })
+              .option('hash', {
+                demandOption: true,
+                describe: 'hash of the block to verify',
+                type: 'string',
+              })
+              .option('signature', {
+                demandOption: true,
+                describe: 'signature to verify',
+                type: 'string',
+              })
+          },
+          async argv => {
+            const valid = await nanocurrency.verifyBlock({
+              hash: argv.hash,
+              publicKey: argv.public,
+              signature: argv.signature,
+            })
+            console.log(valid)
+          }
+        )
+        .command(
+          'ledger',
+          'verify the hash, signature and work of every block of a ledger export',
+          yargs => {
+            return yargs
+              .usage('usage: $0 verify ledger [options]')
+              .option('path', {
+                describe: 'path of the ledger export. Defaults to stdin',
+                type: 'string',
+              })
+              .option('format', {
+                describe:
+                  'JSON blocks one per line, 216 bytes binary blocks back to back, or a snapshot',
+                choices: ['ndjson', 'binary', 'snapshot'],
+                default: 'ndjson',
+              })
+              .option('threshold', {
+                describe:
+                  'work threshold of send and change blocks. Defaults to ffffffc000000000',
+                type: 'string',
+              })
+              .option('receive-threshold', {
+                describe:
+                  'work threshold of open and receive blocks. Defaults to the threshold',
+                type: 'string',
+              })
+              .option('epoch-signer', {
+                describe:
+                  'public key signing epoch blocks, repeatable. Defaults to the epoch signers of the live network',
+                type: 'string',
+                array: true,
+              })
+              .option('skip-invalid', {
+                describe:
+                  'skip the JSON lines that are not valid blocks, counted as failures, rather than stopping on the first one',
+                type: 'boolean',
+                default: false,
+              })
+              .option('threads', {
+                describe:
+                  'count of worker threads to spread the verification on',
+                type: 'number',
+                conflicts: 'processes',
+              })
+              .option('processes', {
+                describe: 'count of processes to spread the verification on',
+                type: 'number',
+              })
+              .check(argv => {
+                if (!checkWorkerCount(argv.threads)) {
+                  throw new Error(
+                    'Threads must be an integer between 1 and 255'
+                  )
+                }
+                if (!checkWorkerCount(argv.processes)) {
+                  throw new Error(
+                    'Processes must be an integer between 1 and 255'
+                  )
+                }
+
+                return true
+              })
+              .epilogue(
+                'prints "<index> <hash> <reason>" lines for the failing blocks, and the throughput on stderr'
+              )
+          },
+          async argv => {
+            const input =
+              typeof argv.path === 'undefined'
+                ? process.stdin
+                : fs.createReadStream(argv.path)
+            const workerCount = argv.threads ?? argv.processes
+            const kind =
+              typeof argv.threads !== 'undefined' ? 'thread' : 'process'
+
+            const start = Date.now()
+            let invalidCount = 0
+            const report = await verifyLedgerStream(input, {
+              format: argv.format as LedgerFormat,
+              kind,
+              workerCount,
+              threshold: argv.threshold,
+              receiveThreshold: argv['receive-threshold'],
+              epochSigners: argv['epoch-signer'],
+              onInvalidLine: argv['skip-invalid']
+                ? offset => {
+                    console.error(`Block is not valid at offset ${offset}`)
+                    invalidCount++
+                  }
+                : undefined,
+              // failures are printed as soon as their batch is verified
+              onProgress: (report, failures) => {
+                for (const failure of failures) {
+                  console.log(
+                    `${failure.index} ${failure.hash} ${failure.reason}`
+                  )
+                }
+              },
+            })
+            const seconds = Math.max(Date.now() - start, 1) / 1000
+            const throughput = (report.blockCount / seconds).toFixed(0)
+            const failureCount = report.failureCount + invalidCount
+
+            console.error(
+              `${report.blockCount} blocks in ${seconds.toFixed(2)} s, ${throughput} blocks/s, ${failureCount} failures`
+            )
+            if (failureCount > 0) process.exitCode = 1
+          }
+        )
+    )
+  })
   .command('validate', 'validate a [work]', yargs => {
     return wrapSubcommand(
       yargs.usage('usage: $0 validate <item>').command(
@@ -384,58 +736,153 @@ yargs
         )
     )
   })
-  .command('create', 'create a [block]', yargs => {
+  .command('create', 'create a [block|blocks|snapshot]', yargs => {
     return wrapSubcommand(
-      yargs.usage('usage: $0 create <item>').command(
-        'block',
-        'create a block',
-        yargs => {
-          return yargs
-            .usage('usage: $0 create block [options]')
-            .option('secret', {
-              demandOption: true,
-              describe: 'secret key to sign the block with',
-              type: 'string',
-            })
-            .option('balance', {
-              demandOption: true,
-              describe: 'resulting balance',
-              type: 'string',
-            })
-            .option('link', {
-              demandOption: true,
-              describe:
-                'link block hash or link address, in hexadecimal or address format',
-              type: 'string',
-            })
-            .option('previous', {
-              demandOption: true,
-              describe:
-                'hash of the previous block on the account chain, in hexadecimal format',
-              type: 'string',
-            })
-            .option('representative', {
-              demandOption: true,
-              describe: 'representative address',
-              type: 'string',
+      yargs
+        .usage('usage: $0 create <item>')
+        .command(
+          'block',
+          'create a block',
+          yargs => {
+            return yargs
+              .usage('usage: $0 create block [options]')
+              .option('secret', {
+                demandOption: true,
+                describe: 'secret key to sign the block with',
+                type: 'string',
+              })
+              .option('balance', {
+                demandOption: true,
+                describe: 'resulting balance',
+                type: 'string',
+              })
+              .option('link', {
+                demandOption: true,
+                describe:
+                  'link block hash or link address, in hexadecimal or address format',
+                type: 'string',
+              })
+              .option('previous', {
+                demandOption: true,
+                describe:
+                  'hash of the previous block on the account chain, in hexadecimal format',
+                type: 'string',
+              })
+              .option('representative', {
+                demandOption: true,
+                describe: 'representative address',
+                type: 'string',
+              })
+              .option('work', {
+                demandOption: true,
+                describe: 'work to use',
+                type: 'string',
+              })
+          },
+          async argv => {
+            const block = nanocurrency.createBlock(argv.secret, {
+              balance: argv.balance,
+              link: argv.link,
+              previous: argv.previous,
+              representative: argv.representative,
+              work: argv.work,
             })
-            .option('work', {
-              demandOption: true,
-              describe: 'work to use',
-              type: 'string',
+            console.log(JSON.stringify(block))
+          }
+        )
+        .command(
+          'blocks',
+          'create blocks in bulk',
+          yargs => {
+            return yargs
+              .usage('usage: $0 create blocks [options]')
+              .option('threads', {
+                describe: 'count of worker threads to spread the creation on',
+                type: 'number',
+                conflicts: 'processes',
+              })
+              .option('processes', {
+                describe: 'count of processes to spread the creation on',
+                type: 'number',
+              })
+              .check(argv => {
+                if (!checkWorkerCount(argv.threads)) {
+                  throw new Error(
+                    'Threads must be an integer between 1 and 255'
+                  )
+                }
+                if (!checkWorkerCount(argv.processes)) {
+                  throw new Error(
+                    'Processes must be an integer between 1 and 255'
+                  )
+                }
+
+                return true
+              })
+              .epilogue(
+                'reads {"secretKey", "data"} objects from stdin, one per line, and prints the blocks in the same order'
+              )
+          },
+          async argv => {
+            const items = (await readLines(process.stdin)).map(line =>
+              JSON.parse(line)
+            )
+
+            const workerCount = argv.threads ?? argv.processes
+            const kind =
+              typeof argv.threads !== 'undefined' ? 'thread' : 'process'
+            const blocks =
+              typeof workerCount === 'undefined'
+                ? nanocurrency.createBlocks(items)
+                : await createBlocksInParallel(items, { kind, workerCount })
+
+            for (const block of blocks) console.log(JSON.stringify(block))
+          }
+        )
+        .command(
+          'snapshot',
+          'create the compressed columnar snapshot of a ledger export',
+          yargs => {
+            return yargs
+              .usage('usage: $0 create snapshot [options]')
+              .option('path', {
+                describe: 'path of the ledger export. Defaults to stdin',
+                type: 'string',
+              })
+              .option('format', {
+                describe:
+                  'JSON blocks one per line, or 216 bytes binary blocks back to back',
+                choices: ['ndjson', 'binary'],
+                default: 'ndjson',
+              })
+              .option('output', {
+                demandOption: true,
+                describe: 'path of the snapshot',
+                type: 'string',
+              })
+              .epilogue(
+                'prints the count of blocks and the size of the snapshot on stderr'
+              )
+          },
+          async argv => {
+            const input =
+              typeof argv.path === 'undefined'
+                ? process.stdin
+                : fs.createReadStream(argv.path)
+            const output = fs.createWriteStream(argv.output)
+
+            const report = await writeLedgerSnapshot(input, output, {
+              format: argv.format as LedgerFormat,
             })
-        },
-        async argv => {
-          const block = nanocurrency.createBlock(argv.secret, {
-            balance: argv.balance,
-            link: argv.link,
-            previous: argv.previous,
-            representative: argv.representative,
-            work: argv.work,
-          })
-          console.log(JSON.stringify(block))
-        }
-      )
+            await new Promise(resolve => output.end(resolve))
+            const { blockCount, inputLength, outputLength } = report
+            const ratio = (100 * outputLength) / Math.max(inputLength, 1)
+
+            console.error(
+              `${blockCount} blocks, ${inputLength} bytes to ${outputLength} bytes, ${ratio.toFixed(1)} %`
+            )
+          }
+        )
     )
   })
   .demandCommand(1, 'Please specify a command')
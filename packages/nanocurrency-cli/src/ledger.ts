@@ -0,0 +1,234 @@
+import * as nanocurrency from 'nanocurrency'
+import { createBlockVerifierPool, WorkerKind } from './pool'
+
+/** How the blocks of a ledger are written. */
+export type LedgerFormat = 'ndjson' | 'binary' | 'snapshot'
+
+/** Verify ledger parameters. */
+export interface VerifyLedgerParams extends nanocurrency.LedgerRules {
+  /**
+   * JSON blocks, one per line, 216 bytes encoded blocks back to back, or a
+   * snapshot
+   */
+  format: LedgerFormat
+  /** Whether to use threads or processes */
+  kind: WorkerKind
+  /** The count of workers, or undefined to verify on the main thread */
+  workerCount?: number
+  /**
+   * Called with the offset of every JSON line that is not a valid block, the
+   * line being skipped. Defaults to throwing on the first one
+   */
+  onInvalidLine?: (offset: number) => void
+  /** Called once a batch is verified, with its failures */
+  onProgress?: (
+    report: nanocurrency.LedgerReport,
+    failures: nanocurrency.LedgerFailure[]
+  ) => void
+}
+
+/**
+ * Feed a stream to a callback chunk by chunk, pausing the stream until the
+ * callback is done with each chunk, so that it is not read ahead.
+ */
+function consumeStream(
+  input: NodeJS.ReadableStream,
+  onChunk: (chunk: string | Buffer) => Promise<void>
+): Promise<void> {
+  return new Promise((resolve, reject) => {
+    input.on('data', chunk => {
+      input.pause()
+      onChunk(chunk).then(() => input.resume(), reject)
+    })
+    input.on('end', resolve)
+    input.on('error', reject)
+  })
+}
+
+/**
+ * Feed the blocks of a ledger export to a callback, encoded back to back,
+ * whatever the format of the export.
+ */
+async function consumeLedger(
+  input: NodeJS.ReadableStream,
+  format: LedgerFormat,
+  onBlocks: (blocks: Uint8Array) => Promise<void>,
+  onInvalidLine?: (offset: number) => void
+): Promise<void> {
+  if (format === 'binary') {
+    await consumeStream(input, chunk => onBlocks(chunk as Buffer))
+  } else if (format === 'snapshot') {
+    const reader = nanocurrency.createSnapshotReader()
+    await consumeStream(input, async chunk => {
+      for (const segment of reader.update(chunk as Buffer)) {
+        await onBlocks(segment.encode())
+      }
+    })
+    reader.finish()
+  } else {
+    // either blocks, or blocks and their hash as printed by `create blocks`,
+    // encoded in WebAssembly memory without parsing the JSON
+    const parser = await nanocurrency.createBlockParser({ onInvalidLine })
+    await consumeStream(input, async chunk =>
+      onBlocks(parser.update(chunk as Buffer))
+    )
+    await onBlocks(parser.finish())
+  }
+}
+
+/** Write snapshot parameters. */
+export interface WriteSnapshotParams {
+  /** How the blocks of the input are written */
+  format: LedgerFormat
+}
+
+/** The lengths of a ledger export and of its snapshot. */
+export interface SnapshotReport {
+  blockCount: number
+  inputLength: number
+  outputLength: number
+}
+
+/**
+ * Write the snapshot of a ledger export, see `createSnapshotWriter`.
+ *
+ * @param input - The ledger export
+ * @param output - Where to write the snapshot
+ * @param params - Parameters
+ * @returns Report
+ */
+export async function writeLedgerSnapshot(
+  input: NodeJS.ReadableStream,
+  output: NodeJS.WritableStream,
+  params: WriteSnapshotParams
+): Promise<SnapshotReport> {
+  const writer = nanocurrency.createSnapshotWriter()
+  const report = { blockCount: 0, inputLength: 0, outputLength: 0 }
+  input.on('data', chunk => (report.inputLength += chunk.length))
+
+  const write = (bytes: Uint8Array): Promise<void> => {
+    report.outputLength += bytes.length
+    if (bytes.length === 0 || output.write(bytes)) return Promise.resolve()
+
+    return new Promise(resolve => output.once('drain', resolve))
+  }
+
+  let blocksLength = 0
+  await consumeLedger(input, params.format, blocks => {
+    blocksLength += blocks.length
+    return write(writer.update(blocks))
+  })
+  await write(writer.finish())
+  report.blockCount = blocksLength / nanocurrency.STATE_BLOCK_LENGTH
+
+  return report
+}
+
+/** Scan ledger parameters. */
+export interface ScanLedgerParams {
+  /** How the blocks of the ledger are written */
+  format: LedgerFormat
+  /** The public keys of the accounts to find the receivable blocks of */
+  publicKeys: string[]
+  /** Called with every block sending to one of the accounts, in order */
+  onReceivable: (receivable: nanocurrency.Receivable) => void
+}
+
+/**
+ * Find the blocks of a ledger export sending to a set of accounts, see
+ * `createReceivableScanner`.
+ *
+ * @param input - The ledger export
+ * @param params - Parameters
+ * @returns The count of blocks scanned
+ */
+export async function scanLedgerStream(
+  input: NodeJS.ReadableStream,
+  params: ScanLedgerParams
+): Promise<number> {
+  const scanner = nanocurrency.createReceivableScanner(params.publicKeys)
+  let blocksLength = 0
+
+  await consumeLedger(input, params.format, async blocks => {
+    blocksLength += blocks.length
+    scanner.update(blocks).forEach(params.onReceivable)
+  })
+  scanner.finish()
+
+  return blocksLength / nanocurrency.STATE_BLOCK_LENGTH
+}
+
+/** Aggregate ledger parameters. */
+export interface AggregateLedgerParams {
+  /** How the blocks of the ledger are written */
+  format: LedgerFormat
+  /** The supply to check the total of the balances against, in raw */
+  supply?: string
+}
+
+/**
+ * Compute the voting weight of every representative of a ledger export,
+ * see `createWeightAggregator`.
+ *
+ * @param input - The ledger export
+ * @param params - Parameters
+ * @returns Report
+ */
+export async function aggregateLedgerStream(
+  input: NodeJS.ReadableStream,
+  params: AggregateLedgerParams
+): Promise<nanocurrency.WeightReport> {
+  const aggregator = nanocurrency.createWeightAggregator({
+    supply: params.supply,
+  })
+
+  await consumeLedger(input, params.format, async blocks =>
+    aggregator.update(blocks)
+  )
+
+  return aggregator.finish()
+}
+
+/**
+ * Verify the hash, the signature and the work of every block of a ledger
+ * export, streamed in batches to a pool of workers.
+ *
+ * @param input - The ledger export
+ * @param params - Parameters
+ * @returns Report
+ */
+export async function verifyLedgerStream(
+  input: NodeJS.ReadableStream,
+  params: VerifyLedgerParams
+): Promise<nanocurrency.LedgerReport> {
+  const pool =
+    typeof params.workerCount === 'undefined'
+      ? null
+      : createBlockVerifierPool({
+          kind: params.kind,
+          workerCount: params.workerCount,
+        })
+
+  try {
+    const verifier = nanocurrency.createLedgerVerifier({
+      // enough batches in flight to keep every worker busy
+      concurrency: pool ? 2 * (params.workerCount as number) : 1,
+      verifyBatch: pool ? pool.verifyBatch : undefined,
+      threshold: params.threshold,
+      receiveThreshold: params.receiveThreshold,
+      epochSigners: params.epochSigners,
+      onProgress: params.onProgress,
+    })
+
+    await consumeLedger(
+      input,
+      params.format,
+      blocks => verifier.update(blocks),
+      params.onInvalidLine
+    )
+
+    return await verifier.finish()
+  } finally {
+    if (pool) pool.terminate()
+  }
+}
@@ -0,0 +1,287 @@
+import { fork } from 'child_process'
+import * as path from 'path'
+import { Worker } from 'worker_threads'
+import {
+  Block,
+  CreateBlocksItem,
+  LedgerFailure,
+  VerifyBlocksParams,
+} from 'nanocurrency'
+
+/** Whether to spread a job across worker threads or forked processes. */
+export type WorkerKind = 'thread' | 'process'
+
+/** Message sent to a worker. */
+export type WorkerRequest =
+  | {
+      type: 'work'
+      hash: string
+      workerIndex: number
+      workerCount: number
+    }
+  | { type: 'work-cancel' }
+  | { type: 'blake2bp-init'; outputLength: number; index: number }
+  | { type: 'blake2bp-update'; data: Uint8Array }
+  | { type: 'blake2bp-digest' }
+  | {
+      type: 'create-blocks'
+      items: CreateBlocksItem[]
+      workerIndex: number
+      workerCount: number
+    }
+  | { type: 'verify-blocks'; blocks: Uint8Array; params: VerifyBlocksParams }
+
+/** Message sent back by a worker. */
+export type WorkerResponse =
+  | { type: 'work'; work: string | null }
+  | { type: 'blake2bp'; leafHash: string | null }
+  | { type: 'blocks'; blocks: Block[] }
+  | { type: 'failures'; failures: LedgerFailure[] }
+  | { type: 'error'; message: string }
+
+/** A worker thread or a forked process, behind the same interface. */
+export interface PoolWorker {
+  postMessage(message: WorkerRequest): void
+  onMessage(listener: (message: WorkerResponse) => void): void
+  onError(listener: (err: Error) => void): void
+  onExit(listener: (code: number | null) => void): void
+  terminate(): void
+}
+
+/** Send requests to a worker, and wait for their responses in order. */
+export function createWorkerCaller(
+  worker: PoolWorker
+): (message: WorkerRequest) => Promise<WorkerResponse> {
+  let pending: {
+    resolve: (message: WorkerResponse) => void
+    reject: (err: Error) => void
+  }[] = []
+
+  worker.onMessage(message => {
+    const call = pending.shift()
+    if (!call) return
+    if (message.type === 'error') call.reject(new Error(message.message))
+    else call.resolve(message)
+  })
+  worker.onError(err => {
+    for (const call of pending) call.reject(err)
+    pending = []
+  })
+  // a worker dying without an error, killed or out of memory
+  worker.onExit(code => {
+    for (const call of pending) {
+      call.reject(new Error(`Worker exited with code ${code}`))
+    }
+    pending = []
+  })
+
+  return message =>
+    new Promise((resolve, reject) => {
+      pending.push({ resolve, reject })
+      worker.postMessage(message)
+    })
+}
+
+const WORKER_PATH = path.join(__dirname, 'worker.js')
+
+export function spawnWorker(kind: WorkerKind): PoolWorker {
+  if (kind === 'thread') {
+    const worker = new Worker(WORKER_PATH)
+
+    return {
+      postMessage: message => worker.postMessage(message),
+      onMessage: listener => worker.on('message', listener),
+      onError: listener => worker.on('error', listener),
+      onExit: listener => worker.on('exit', listener),
+      terminate: () => {
+        worker.terminate()
+      },
+    }
+  }
+
+  // typed arrays are sent as such, rather than as JSON objects
+  const child = fork(WORKER_PATH, [], { serialization: 'advanced' })
+
+  return {
+    postMessage: message => child.send(message),
+    onMessage: listener => child.on('message', listener),
+    onError: listener => child.on('error', listener),
+    onExit: listener => child.on('exit', listener),
+    terminate: () => {
+      child.kill()
+    },
+  }
+}
+
+/** Parallel work parameters. */
+export interface ParallelWorkParams {
+  /** Whether to use threads or processes */
+  kind: WorkerKind
+  /** The count of workers, between 1 and 255 */
+  workerCount: number
+}
+
+/** Workers computing works, see [[createWorkPool]]. */
+export interface WorkPool {
+  computeWork(hash: string): Promise<string | null>
+  terminate(): void
+}
+
+/**
+ * Spawn workers computing works, each one on its own nonce range. The first
+ * worker to find a work wins, and the others are then cancelled, so that the
+ * same workers compute the work of the next hash.
+ *
+ * @param params - Parameters
+ * @returns Pool
+ */
+export function createWorkPool(params: ParallelWorkParams): WorkPool {
+  const workers: PoolWorker[] = []
+  for (let i = 0; i < params.workerCount; i++) {
+    workers.push(spawnWorker(params.kind))
+  }
+  const calls = workers.map(createWorkerCaller)
+
+  return {
+    computeWork: hash =>
+      new Promise((resolve, reject) => {
+        let pendingCount = workers.length
+        let work: string | null = null
+        let error: Error | null = null
+
+        const cancel = (): void => {
+          for (const worker of workers) {
+            worker.postMessage({ type: 'work-cancel' })
+          }
+        }
+        // every worker is waited for, so that none is still busy on this hash
+        const settle = (): void => {
+          pendingCount--
+          if (pendingCount > 0) return
+          if (error !== null) reject(error)
+          else resolve(work)
+        }
+
+        calls.forEach((call, workerIndex) => {
+          call({
+            type: 'work',
+            hash,
+            workerIndex,
+            workerCount: workers.length,
+          })
+            .then(response => {
+              if (response.type !== 'work') {
+                throw new Error('Work is not valid')
+              }
+              if (response.work !== null && work === null && error === null) {
+                work = response.work
+                cancel()
+              }
+              settle()
+            })
+            .catch((err: Error) => {
+              if (work === null && error === null) {
+                error = err
+                cancel()
+              }
+              settle()
+            })
+        })
+      }),
+    terminate: () => {
+      for (const worker of workers) worker.terminate()
+    },
+  }
+}
+
+/**
+ * Create blocks in bulk by giving each worker its own slice of the items,
+ * so that keys are derived and blocks hashed and signed in parallel.
+ *
+ * @param items - The secret keys and data of the blocks
+ * @param params - Parameters
+ * @returns Blocks, in the order of the items
+ */
+export async function createBlocksInParallel(
+  items: CreateBlocksItem[],
+  params: ParallelWorkParams
+): Promise<Block[]> {
+  const workers: PoolWorker[] = []
+  for (let i = 0; i < params.workerCount; i++) {
+    workers.push(spawnWorker(params.kind))
+  }
+
+  try {
+    // each worker is sent only its own slice, rather than every item
+    const responses = await Promise.all(
+      workers.map((worker, workerIndex) =>
+        createWorkerCaller(worker)({
+          type: 'create-blocks',
+          items: items.slice(
+            Math.floor((items.length * workerIndex) / workers.length),
+            Math.floor((items.length * (workerIndex + 1)) / workers.length)
+          ),
+          workerIndex: 0,
+          workerCount: 1,
+        })
+      )
+    )
+
+    const blocks: Block[] = []
+    for (const response of responses) {
+      if (response.type !== 'blocks') throw new Error('Blocks are not valid')
+      blocks.push(...response.blocks)
+    }
+
+    return blocks
+  } finally {
+    for (const worker of workers) worker.terminate()
+  }
+}
+
+/** Workers verifying batches of blocks, see [[createBlockVerifierPool]]. */
+export interface BlockVerifierPool {
+  verifyBatch(
+    blocks: Uint8Array,
+    params: VerifyBlocksParams
+  ): Promise<LedgerFailure[]>
+  terminate(): void
+}
+
+/**
+ * Spawn workers verifying whole batches of blocks, handed to them in turn.
+ *
+ * @param params - Parameters
+ * @returns Pool
+ */
+export function createBlockVerifierPool(
+  params: ParallelWorkParams
+): BlockVerifierPool {
+  const workers: PoolWorker[] = []
+  for (let i = 0; i < params.workerCount; i++) {
+    workers.push(spawnWorker(params.kind))
+  }
+  const calls = workers.map(createWorkerCaller)
+  let next = 0
+
+  return {
+    verifyBatch: async (blocks, verifyParams) => {
+      const call = calls[next]
+      next = (next + 1) % calls.length
+
+      const response = await call({
+        type: 'verify-blocks',
+        blocks,
+        params: verifyParams,
+      })
+      if (response.type !== 'failures') {
+        throw new Error('Failures are not valid')
+      }
+
+      return response.failures
+    },
+    terminate: () => {
+      for (const worker of workers) worker.terminate()
+    },
+  }
+}
@@ -0,0 +1,75 @@
+import * as nanocurrency from 'nanocurrency'
+import { parentPort } from 'worker_threads'
+import { WorkerRequest, WorkerResponse } from './pool'
+
+// run either as a worker thread or as a forked process
+const send = (message: WorkerResponse): void => {
+  if (parentPort) parentPort.postMessage(message)
+  else if (process.send) process.send(message)
+}
+
+// set by a cancel request, and cleared by the next work request
+let cancelled = false
+
+// the BLAKE2bp leaf this worker hashes, for the whole life of the worker
+let leaf: nanocurrency.Blake2bpLeaf | null = null
+
+const handle = async (request: WorkerRequest): Promise<WorkerResponse> => {
+  if (request.type === 'work') {
+    cancelled = false
+    const work = await nanocurrency.computeWork(request.hash, {
+      workerIndex: request.workerIndex,
+      workerCount: request.workerCount,
+      isCancelled: () => cancelled,
+    })
+    return { type: 'work', work }
+  }
+
+  if (request.type === 'create-blocks') {
+    const blocks = nanocurrency.createBlocks(request.items, {
+      workerIndex: request.workerIndex,
+      workerCount: request.workerCount,
+    })
+    return { type: 'blocks', blocks }
+  }
+
+  if (request.type === 'verify-blocks') {
+    const failures = nanocurrency.verifyBlocks(request.blocks, request.params)
+    return { type: 'failures', failures }
+  }
+
+  if (request.type === 'blake2bp-init') {
+    leaf = await nanocurrency.createBlake2bpLeaf(
+      request.outputLength,
+      request.index
+    )
+    return { type: 'blake2bp', leafHash: null }
+  }
+
+  if (request.type === 'blake2bp-update' && leaf) {
+    leaf.update(request.data)
+    return { type: 'blake2bp', leafHash: null }
+  }
+
+  if (request.type === 'blake2bp-digest' && leaf) {
+    const leafHash = Buffer.from(leaf.digest()).toString('hex')
+    return { type: 'blake2bp', leafHash }
+  }
+
+  throw new Error('Request is not valid')
+}
+
+const onRequest = (request: WorkerRequest): void => {
+  // answered by the work request it cancels
+  if (request.type === 'work-cancel') {
+    cancelled = true
+    return
+  }
+
+  handle(request)
+    .then(send)
+    .catch((err: Error) => send({ type: 'error', message: err.message }))
+}
+
+if (parentPort) parentPort.on('message', onRequest)
+else process.on('message', onRequest)
@@ -4,6 +4,8 @@
 const nano = require('../dist/nanocurrency.cjs')
 const { INVALID_HASHES } = require('./data/invalid')
 
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
 const VALID_WORK = {
   hash: 'b9cb6b51b8eb869af085c4c03e7dc539943d0bdde13b21436b687c9c7ea56cb0',
   work: '0000000000010600',
@@ -15,6 +17,43 @@ describe('computeWork', () => {
     expect(result).toBe(VALID_WORK.work)
   })
 
+  test('reports progress', async () => {
+    const reports = []
+    const result = await nano.computeWork(VALID_WORK.hash, {
+      onProgress: progress => reports.push(progress),
+      progressInterval: 0,
+    })
+    expect(result).toBe(VALID_WORK.work)
+
+    const lastReport = reports[reports.length - 1]
+    expect(lastReport.noncesScanned).toBe(parseInt(VALID_WORK.work, 16) + 1)
+    expect(lastReport.elapsedTime).toBeGreaterThanOrEqual(0)
+    expect(lastReport.hashrate).toBeGreaterThan(0)
+    expect(lastReport.bestDifficulty >= 'ffffffc000000000').toBe(true)
+  })
+
+  test('stops once cancelled', async () => {
+    let checks = 0
+    const result = await nano.computeWork(VALID_WORK.hash, {
+      workThreshold: 'ffffffffffffffff',
+      isCancelled: () => ++checks === 2,
+    })
+    expect(result).toBe(null)
+    expect(checks).toBe(2)
+  })
+
+  test('throws with invalid progress interval', () => {
+    const INVALID_PROGRESS_INTERVALS = ['p', -1, NaN]
+    expect.assertions(INVALID_PROGRESS_INTERVALS.length)
+    for (let invalidProgressInterval of INVALID_PROGRESS_INTERVALS) {
+      expect(
+        nano.computeWork(VALID_WORK.hash, {
+          progressInterval: invalidProgressInterval,
+        })
+      ).rejects.toThrow('Progress interval is not valid')
+    }
+  })
+
   test('throws with invalid hashes', () => {
     expect.assertions(INVALID_HASHES.length)
     for (let invalidHash of INVALID_HASHES) {
@@ -43,3 +82,201 @@ describe('computeWork', () => {
     }
   })
 })
+
+describe('hashBlockPreimage', () => {
+  const toHex = bytes => Buffer.from(bytes).toString('hex').toUpperCase()
+  const createPreimage = validStateBlock =>
+    nano.createBlockPreimage({
+      account: validStateBlock.block.data.account,
+      previous: validStateBlock.block.data.previous,
+      representative: validStateBlock.block.data.representative,
+      balance: validStateBlock.block.data.balance,
+      link: validStateBlock.originalLink,
+    })
+
+  test('creates correct state hash', async () => {
+    for (let validStateBlock of VALID_STATE_BLOCKS) {
+      const preimage = createPreimage(validStateBlock)
+      expect(preimage.length).toBe(176)
+
+      const hash = await nano.hashBlockPreimage(preimage)
+      expect(toHex(hash)).toBe(validStateBlock.block.hash)
+    }
+  })
+
+  test('is used by hashBlock once loaded', async () => {
+    const validStateBlock = VALID_STATE_BLOCKS[0]
+    await nano.hashBlockPreimage(createPreimage(validStateBlock))
+
+    expect(
+      nano.hashBlock({
+        account: validStateBlock.block.data.account,
+        previous: validStateBlock.block.data.previous,
+        representative: validStateBlock.block.data.representative,
+        balance: validStateBlock.block.data.balance,
+        link: validStateBlock.originalLink,
+      })
+    ).toBe(validStateBlock.block.hash)
+  })
+
+  test('throws with invalid preimage', () => {
+    const INVALID_PREIMAGES = ['p', new Uint8Array(175), new Uint8Array(177)]
+    expect.assertions(INVALID_PREIMAGES.length)
+    for (let invalidPreimage of INVALID_PREIMAGES) {
+      expect(nano.hashBlockPreimage(invalidPreimage)).rejects.toThrow(
+        'Preimage is not valid'
+      )
+    }
+  })
+})
+
+describe('hashBlocks', () => {
+  const toHex = bytes => Buffer.from(bytes).toString('hex').toUpperCase()
+  const preimages = VALID_STATE_BLOCKS.map(validStateBlock =>
+    nano.createBlockPreimage({
+      account: validStateBlock.block.data.account,
+      previous: validStateBlock.block.data.previous,
+      representative: validStateBlock.block.data.representative,
+      balance: validStateBlock.block.data.balance,
+      link: validStateBlock.originalLink,
+    })
+  )
+  const packed = Buffer.concat(preimages)
+  const column = (offset, size) =>
+    Buffer.concat(preimages.map(p => p.subarray(offset, offset + size)))
+  const columns = {
+    accounts: column(32, 32),
+    previous: column(64, 32),
+    representatives: column(96, 32),
+    balances: column(128, 16),
+    links: column(144, 32),
+  }
+  const expected = VALID_STATE_BLOCKS.map(b => b.block.hash).join('')
+
+  test('hashes packed preimages', async () => {
+    const hashes = await nano.hashBlocks(new Uint8Array(packed))
+    expect(toHex(hashes)).toBe(expected)
+  })
+
+  test('hashes columns', async () => {
+    const hashes = await nano.hashBlocks(columns)
+    expect(toHex(hashes)).toBe(expected)
+  })
+
+  test('splits blocks between workers', async () => {
+    const hashes = new Uint8Array(VALID_STATE_BLOCKS.length * 32)
+    for (let workerIndex = 0; workerIndex < 3; workerIndex++) {
+      await nano.hashBlocks(columns, { workerIndex, workerCount: 3, hashes })
+    }
+    expect(toHex(hashes)).toBe(expected)
+  })
+
+  test('throws with invalid blocks', () => {
+    const INVALID_BLOCKS = [
+      'p',
+      null,
+      new Uint8Array(175),
+      { ...columns, balances: new Uint8Array(15) },
+      { ...columns, links: undefined },
+    ]
+    expect.assertions(INVALID_BLOCKS.length)
+    for (let invalidBlocks of INVALID_BLOCKS) {
+      expect(nano.hashBlocks(invalidBlocks)).rejects.toThrow(
+        'Blocks are not valid'
+      )
+    }
+  })
+
+  test('throws with invalid hashes', () => {
+    expect.assertions(1)
+    expect(
+      nano.hashBlocks(packed, { hashes: new Uint8Array(32) })
+    ).rejects.toThrow('Hashes are not valid')
+  })
+})
+
+describe('hashBlockSuffixes', () => {
+  const toHex = bytes => Buffer.from(bytes).toString('hex').toUpperCase()
+  const VALID_STATE_BLOCK = VALID_STATE_BLOCKS[0]
+  const preimage = nano.createBlockPreimage({
+    account: VALID_STATE_BLOCK.block.data.account,
+    previous: VALID_STATE_BLOCK.block.data.previous,
+    representative: VALID_STATE_BLOCK.block.data.representative,
+    balance: VALID_STATE_BLOCK.block.data.balance,
+    link: VALID_STATE_BLOCK.originalLink,
+  })
+
+  test('hashes blocks from a midstate', async () => {
+    const midstate = await nano.createBlockMidstate(preimage)
+    expect(midstate.length).toBe(64)
+
+    // the same suffix twice, then with another balance
+    const suffix = preimage.subarray(128)
+    const otherPreimage = Uint8Array.from(preimage)
+    otherPreimage[143] ^= 1
+    const otherSuffix = otherPreimage.subarray(128)
+    const suffixes = Buffer.concat([suffix, suffix, otherSuffix])
+
+    const hashes = await nano.hashBlockSuffixes(midstate, suffixes)
+    const otherHash = await nano.hashBlockPreimage(otherPreimage)
+    expect(toHex(hashes)).toBe(
+      VALID_STATE_BLOCK.block.hash +
+        VALID_STATE_BLOCK.block.hash +
+        toHex(otherHash)
+    )
+  })
+
+  test('throws with invalid preimage', () => {
+    expect.assertions(2)
+    expect(nano.createBlockMidstate(new Uint8Array(127))).rejects.toThrow(
+      'Preimage is not valid'
+    )
+    expect(nano.createBlockMidstate('p')).rejects.toThrow(
+      'Preimage is not valid'
+    )
+  })
+
+  test('throws with invalid midstate or suffixes', () => {
+    expect.assertions(2)
+    expect(
+      nano.hashBlockSuffixes(new Uint8Array(63), new Uint8Array(48))
+    ).rejects.toThrow('Midstate is not valid')
+    expect(
+      nano.hashBlockSuffixes(new Uint8Array(64), new Uint8Array(47))
+    ).rejects.toThrow('Suffixes are not valid')
+  })
+})
+
+describe('blake2bMulti', () => {
+  const { blake2b } = require('blakejs')
+
+  test('hashes like blake2b', async () => {
+    const messages = [0, 1, 32, 127, 128, 129, 300, 32, 32].map(length =>
+      Uint8Array.from({ length }, (_, i) => (i * 7 + length) & 0xff)
+    )
+    for (let outputLength of [5, 32, 64]) {
+      const hashes = await nano.blake2bMulti(messages, outputLength)
+      expect(hashes.map(hash => Buffer.from(hash).toString('hex'))).toEqual(
+        messages.map(message =>
+          Buffer.from(blake2b(message, null, outputLength)).toString('hex')
+        )
+      )
+    }
+  })
+
+  test('throws with invalid parameters', () => {
+    expect.assertions(4)
+    expect(nano.blake2bMulti('p', 32)).rejects.toThrow(
+      'Messages are not valid'
+    )
+    expect(nano.blake2bMulti(['p'], 32)).rejects.toThrow(
+      'Messages are not valid'
+    )
+    expect(nano.blake2bMulti([], 0)).rejects.toThrow(
+      'Output length is not valid'
+    )
+    expect(nano.blake2bMulti([], 65)).rejects.toThrow(
+      'Output length is not valid'
+    )
+  })
+})
@@ -0,0 +1,119 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const { blake2b } = require('blakejs')
+const nano = require('../dist/nanocurrency.cjs')
+
+const toHex = bytes => Buffer.from(bytes).toString('hex')
+const MESSAGE = Uint8Array.from({ length: 300 }, (_, i) => (i * 7) & 0xff)
+
+describe('blake2b context', () => {
+  test('hashes like blake2b', async () => {
+    const context = await nano.createBlake2bContext(32)
+    context.update(MESSAGE.subarray(0, 100)).update(MESSAGE.subarray(100))
+    expect(toHex(context.digest())).toBe(toHex(blake2b(MESSAGE, null, 32)))
+  })
+
+  test('hashes with a key', async () => {
+    const key = MESSAGE.subarray(0, 64)
+    const context = await nano.createBlake2bContext(64, key)
+    context.update(MESSAGE)
+    expect(toHex(context.digest())).toBe(toHex(blake2b(MESSAGE, key, 64)))
+  })
+
+  test('forks from a shared prefix', async () => {
+    const prefix = await nano.createBlake2bContext(32)
+    prefix.update(MESSAGE.subarray(0, 130))
+
+    for (let length of [130, 131, 256, 300]) {
+      const fork = prefix.fork().update(MESSAGE.subarray(130, length))
+      expect(toHex(fork.digest())).toBe(
+        toHex(blake2b(MESSAGE.subarray(0, length), null, 32))
+      )
+    }
+
+    // forks do not alter the prefix, and digests do not consume the context
+    expect(toHex(prefix.digest())).toBe(
+      toHex(blake2b(MESSAGE.subarray(0, 130), null, 32))
+    )
+    expect(toHex(prefix.digest())).toBe(
+      toHex(blake2b(MESSAGE.subarray(0, 130), null, 32))
+    )
+  })
+
+  test('throws with invalid parameters', async () => {
+    expect.assertions(4)
+    await expect(nano.createBlake2bContext(0)).rejects.toThrow(
+      'Output length is not valid'
+    )
+    await expect(nano.createBlake2bContext(65)).rejects.toThrow(
+      'Output length is not valid'
+    )
+    await expect(
+      nano.createBlake2bContext(32, new Uint8Array(65))
+    ).rejects.toThrow('Key is not valid')
+
+    const context = await nano.createBlake2bContext(32)
+    expect(() => context.update('p')).toThrowError('Data is not valid')
+  })
+})
+
+describe('blake2bp', () => {
+  const LONG_MESSAGE = Uint8Array.from(
+    { length: 2000 },
+    (_, i) => (i * 7) & 0xff
+  )
+  const LONG_MESSAGE_HASH =
+    '7891e5aea710551275d5ef92981808bb6cd267c5e2156ea36a463cbb76b29977'
+
+  test('hashes like blake2bp', async () => {
+    expect(toHex(await nano.blake2bp(LONG_MESSAGE, 32))).toBe(LONG_MESSAGE_HASH)
+    expect(toHex(await nano.blake2bp(new Uint8Array(0), 32))).toBe(
+      'e3f5e2e3c4336e2b8eec91ecb154e40c8b1fa34091b286bca5b67d5a7f87ff98'
+    )
+
+    // first vector of blake2bp-kat.txt
+    const key = Uint8Array.from({ length: 64 }, (_, i) => i)
+    expect(toHex(await nano.blake2bp(new Uint8Array(0), 64, key))).toBe(
+      '9d9461073e4eb640a255357b839f394b838c6ff57c9b686a3f76107c1066728f' +
+        '3c9956bd785cbc3bf79dc2ab578c5a0c063b9d9c405848de1dbe821cd05c940a'
+    )
+  })
+
+  test('hashes leaves fed part by part', async () => {
+    const leafHashes = []
+    for (let index = 0; index < 4; index++) {
+      const leaf = await nano.createBlake2bpLeaf(32, index)
+      leaf
+        .update(LONG_MESSAGE.subarray(0, 512))
+        .update(LONG_MESSAGE.subarray(512, 1536))
+        .update(LONG_MESSAGE.subarray(1536))
+      leafHashes.push(leaf.digest())
+    }
+
+    expect(toHex(await nano.blake2bpRoot(leafHashes, 32))).toBe(
+      LONG_MESSAGE_HASH
+    )
+  })
+
+  test('throws with invalid parameters', async () => {
+    expect.assertions(5)
+    await expect(nano.createBlake2bpLeaf(32, 4)).rejects.toThrow(
+      'Index is not valid'
+    )
+    await expect(nano.createBlake2bpLeaf(65, 0)).rejects.toThrow(
+      'Output length is not valid'
+    )
+    await expect(
+      nano.blake2bpRoot([new Uint8Array(64)], 32)
+    ).rejects.toThrow('Leaf hashes are not valid')
+
+    // only the last part can be out of a stripe
+    const leaf = await nano.createBlake2bpLeaf(32, 0)
+    leaf.update(LONG_MESSAGE.subarray(0, 100))
+    expect(() => leaf.update(LONG_MESSAGE)).toThrowError('Data is not valid')
+    // even after an empty part
+    leaf.update(new Uint8Array(0))
+    expect(() => leaf.update(LONG_MESSAGE)).toThrowError('Data is not valid')
+  })
+})
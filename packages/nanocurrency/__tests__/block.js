@@ -32,6 +32,33 @@ describe('state', () => {
     }
   })
 
+  test('derives link_as_account when first read', () => {
+    const receiveBlock = VALID_STATE_BLOCKS.find(
+      validStateBlock => !nano.checkAddress(validStateBlock.originalLink)
+    )
+    const result = nano.createBlock(receiveBlock.secretKey, {
+      work: receiveBlock.block.data.work,
+      previous: receiveBlock.block.data.previous,
+      representative: receiveBlock.block.data.representative,
+      balance: receiveBlock.block.data.balance,
+      link: receiveBlock.originalLink,
+    })
+
+    nano.clearAddressCaches()
+    expect(result.block.link_as_account).toBe(
+      receiveBlock.block.data.link_as_account
+    )
+    expect(result.block.link_as_account).toBe(
+      receiveBlock.block.data.link_as_account
+    )
+    // derived once, then kept on the block rather than read from the cache
+    expect(nano.getAddressCacheStats().addresses).toMatchObject({
+      hits: 0,
+      misses: 1,
+    })
+    expect(Object.keys(result.block)).toContain('link_as_account')
+  })
+
   test('throws with invalid secret key', () => {
     expect.assertions(INVALID_SECRET_KEYS.length)
     for (let invalidSecretKey of INVALID_SECRET_KEYS) {
@@ -133,3 +160,79 @@ describe('state', () => {
     }
   })
 })
+
+describe('bulk', () => {
+  const ITEMS = VALID_STATE_BLOCKS.map(validStateBlock => ({
+    secretKey: validStateBlock.secretKey,
+    data: {
+      work: validStateBlock.block.data.work,
+      previous: validStateBlock.block.data.previous,
+      representative: validStateBlock.block.data.representative,
+      balance: validStateBlock.block.data.balance,
+      link: validStateBlock.originalLink,
+    },
+  }))
+  const EXPECTED = VALID_STATE_BLOCKS.map(validStateBlock => ({
+    hash: validStateBlock.block.hash,
+    block: validStateBlock.block.data,
+  }))
+
+  test('creates blocks in order', () => {
+    expect(nano.createBlocks(ITEMS)).toEqual(EXPECTED)
+  })
+
+  test('creates the slices of workers', () => {
+    const blocks = []
+    for (let workerIndex = 0; workerIndex < 3; workerIndex++) {
+      blocks.push(
+        ...nano.createBlocks(ITEMS, { workerIndex, workerCount: 3 })
+      )
+    }
+
+    expect(blocks).toEqual(EXPECTED)
+  })
+
+  test('attaches precomputed works', () => {
+    const roots = VALID_STATE_BLOCKS.map(validStateBlock => {
+      const previous = validStateBlock.block.data.previous
+      return /^0+$/.test(previous)
+        ? nano.derivePublicKey(validStateBlock.secretKey)
+        : previous.toUpperCase()
+    })
+    // the test blocks do not share a work when they share a root
+    const indexes = roots
+      .map((root, index) => index)
+      .filter(index => roots.indexOf(roots[index]) === index)
+
+    const works = new Map()
+    for (let index of indexes) {
+      works.set(roots[index], VALID_STATE_BLOCKS[index].block.data.work)
+    }
+    const items = indexes.map(index => ({
+      ...ITEMS[index],
+      data: { ...ITEMS[index].data, work: null },
+    }))
+
+    expect(nano.createBlocks(items, { works })).toEqual(
+      indexes.map(index => EXPECTED[index])
+    )
+  })
+
+  test('throws with invalid parameters', () => {
+    expect(() => nano.createBlocks('foo')).toThrowError('Items are not valid')
+    for (let invalidItem of [null, { secretKey: ITEMS[0].secretKey }]) {
+      expect(() => nano.createBlocks([invalidItem])).toThrowError(
+        'Items are not valid'
+      )
+    }
+    expect(() =>
+      nano.createBlocks(ITEMS, { workerIndex: 1, workerCount: 1 })
+    ).toThrowError('Worker parameters are not valid')
+    expect(() => nano.createBlocks(ITEMS, { works: {} })).toThrowError(
+      'Works are not valid'
+    )
+    expect(() =>
+      nano.createBlocks([{ ...ITEMS[0], secretKey: 'foo' }])
+    ).toThrowError('Secret key is not valid')
+  })
+})
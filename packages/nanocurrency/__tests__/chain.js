@@ -0,0 +1,196 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_HASHES } = require('./data/invalid')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+const OPEN_BLOCK = VALID_STATE_BLOCKS[0]
+const SEND_BLOCK = VALID_STATE_BLOCKS[2]
+
+const WORK = '0000000000000000'
+
+describe('account chain', () => {
+  test('opens an account like createBlock', async () => {
+    const roots = []
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async hash => {
+        roots.push(hash)
+        return OPEN_BLOCK.block.data.work
+      },
+    })
+
+    expect(chain.account).toBe(OPEN_BLOCK.block.data.account)
+    expect(roots).toEqual([nano.derivePublicKey(OPEN_BLOCK.secretKey)])
+
+    const block = await chain.append({
+      balance: OPEN_BLOCK.block.data.balance,
+      link: OPEN_BLOCK.originalLink,
+    })
+    expect(block).toEqual({
+      hash: OPEN_BLOCK.block.hash,
+      block: OPEN_BLOCK.block.data,
+    })
+    expect(chain.frontier).toBe(OPEN_BLOCK.block.hash)
+    expect(chain.balance).toBe(OPEN_BLOCK.block.data.balance)
+    // the work of the new frontier is started right away
+    expect(roots[1]).toBe(OPEN_BLOCK.block.hash)
+  })
+
+  test('chains queued blocks', async () => {
+    const roots = []
+    const chain = nano.createAccountChain(SEND_BLOCK.secretKey, {
+      frontier: SEND_BLOCK.block.data.previous,
+      balance: '4000000000000000000000',
+      representative: SEND_BLOCK.block.data.representative,
+      computeWork: async hash => {
+        roots.push(hash)
+        return WORK
+      },
+    })
+
+    const [send, change] = await Promise.all([
+      chain.append({
+        balance: SEND_BLOCK.block.data.balance,
+        link: SEND_BLOCK.originalLink,
+      }),
+      chain.append({
+        balance: SEND_BLOCK.block.data.balance,
+        link: null,
+        representative: SEND_BLOCK.block.data.account,
+      }),
+    ])
+
+    expect(send.block.previous).toBe(SEND_BLOCK.block.data.previous)
+    expect(send.block.link_as_account).toBe(SEND_BLOCK.originalLink)
+    expect(change.block.previous).toBe(send.hash)
+    expect(change.block.representative).toBe(SEND_BLOCK.block.data.account)
+    expect(chain.frontier).toBe(change.hash)
+    expect(chain.representative).toBe(SEND_BLOCK.block.data.account)
+    expect(roots).toEqual([
+      SEND_BLOCK.block.data.previous,
+      send.hash,
+      change.hash,
+    ])
+  })
+
+  test('returns a block without waiting for the next work', async () => {
+    const roots = []
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      // only the work of the open block is ever found
+      computeWork: hash => {
+        roots.push(hash)
+        return roots.length === 1
+          ? Promise.resolve(WORK)
+          : new Promise(() => undefined)
+      },
+    })
+
+    const block = await chain.append({
+      balance: OPEN_BLOCK.block.data.balance,
+      link: OPEN_BLOCK.originalLink,
+    })
+    expect(block.block.work).toBe(WORK)
+    expect(roots).toEqual([
+      nano.derivePublicKey(OPEN_BLOCK.secretKey),
+      block.hash,
+    ])
+  })
+
+  test('retries a failed work', async () => {
+    let failures = 1
+    const chain = nano.createAccountChain(SEND_BLOCK.secretKey, {
+      frontier: SEND_BLOCK.block.data.previous,
+      balance: '4000000000000000000000',
+      representative: SEND_BLOCK.block.data.representative,
+      computeWork: async () => {
+        if (failures-- > 0) throw new Error('Worker has crashed')
+        return WORK
+      },
+    })
+    const data = {
+      balance: SEND_BLOCK.block.data.balance,
+      link: SEND_BLOCK.originalLink,
+    }
+
+    await expect(chain.append(data)).rejects.toThrow('Worker has crashed')
+    expect(chain.frontier).toBe(SEND_BLOCK.block.data.previous)
+    expect((await chain.append(data)).block.work).toBe(WORK)
+  })
+
+  test('retries a work that throws synchronously', async () => {
+    const roots = []
+    const chain = nano.createAccountChain(SEND_BLOCK.secretKey, {
+      frontier: SEND_BLOCK.block.data.previous,
+      balance: '4000000000000000000000',
+      representative: SEND_BLOCK.block.data.representative,
+      computeWork: hash => {
+        roots.push(hash)
+        if (roots.length === 2) throw new Error('Worker has crashed')
+        return Promise.resolve(WORK)
+      },
+    })
+    const data = {
+      balance: SEND_BLOCK.block.data.balance,
+      link: SEND_BLOCK.originalLink,
+    }
+
+    const send = await chain.append(data)
+    expect(chain.frontier).toBe(send.hash)
+
+    // the work of the new frontier failed, and is not taken from the last one
+    await expect(chain.append(data)).rejects.toThrow('Worker has crashed')
+    expect(chain.frontier).toBe(send.hash)
+    const next = await chain.append(data)
+    expect(next.block.previous).toBe(send.hash)
+    expect(roots).toEqual([
+      SEND_BLOCK.block.data.previous,
+      send.hash,
+      send.hash,
+      next.hash,
+    ])
+  })
+
+  test('throws with invalid parameters', async () => {
+    const params = {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async () => WORK,
+    }
+
+    expect(() => nano.createAccountChain('foo', params)).toThrowError(
+      'Secret key is not valid'
+    )
+    for (let invalidHash of INVALID_HASHES) {
+      expect(() =>
+        nano.createAccountChain(OPEN_BLOCK.secretKey, {
+          ...params,
+          frontier: invalidHash,
+        })
+      ).toThrowError('Frontier is not valid')
+    }
+    // the work is left to the caller, to be computed off the calling thread
+    for (let invalidComputeWork of [undefined, 'work']) {
+      expect(() =>
+        nano.createAccountChain(OPEN_BLOCK.secretKey, {
+          ...params,
+          computeWork: invalidComputeWork,
+        })
+      ).toThrowError('Compute work is not valid')
+    }
+
+    // an open block needs a send block hash
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, params)
+    await expect(
+      chain.append({ balance: '1', link: SEND_BLOCK.originalLink })
+    ).rejects.toThrow('Block is impossible')
+    expect(chain.frontier).toBe(null)
+  })
+})
@@ -0,0 +1,174 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_HASHES, INVALID_ADDRESSES } = require('./data/invalid')
+const { encodeBlocks, feed } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+const RANDOM_VALID_STATE_BLOCK = VALID_STATE_BLOCKS[0]
+
+describe('codec', () => {
+  test('encodes and decodes blocks', () => {
+    for (let validStateBlock of VALID_STATE_BLOCKS) {
+      const bytes = nano.encodeBlock(validStateBlock.block.data)
+      expect(bytes.length).toBe(nano.STATE_BLOCK_LENGTH)
+      expect(nano.decodeBlock(bytes)).toEqual(validStateBlock.block.data)
+    }
+  })
+
+  test('views blocks packed in a buffer', () => {
+    const buffer = new Uint8Array(
+      VALID_STATE_BLOCKS.length * nano.STATE_BLOCK_LENGTH
+    )
+    VALID_STATE_BLOCKS.forEach((validStateBlock, index) =>
+      nano.encodeBlock(
+        validStateBlock.block.data,
+        buffer,
+        index * nano.STATE_BLOCK_LENGTH
+      )
+    )
+
+    VALID_STATE_BLOCKS.forEach((validStateBlock, index) => {
+      const data = validStateBlock.block.data
+      const view = nano.viewBlock(buffer, index * nano.STATE_BLOCK_LENGTH)
+      expect(view.account).toBe(data.account)
+      expect(view.previous).toBe(data.previous)
+      expect(view.representative).toBe(data.representative)
+      expect(view.balance).toBe(data.balance)
+      expect(view.link).toBe(data.link)
+      expect(view.signature).toBe(data.signature)
+      expect(view.work).toBe(data.work)
+      expect(view.hash()).toBe(validStateBlock.block.hash)
+
+      // the views share the buffer
+      expect(view.signatureBytes.buffer).toBe(buffer.buffer)
+    })
+  })
+
+  test('encodes a null work as zeroes', () => {
+    const block = { ...RANDOM_VALID_STATE_BLOCK.block.data, work: null }
+    expect(nano.viewBlock(nano.encodeBlock(block)).work).toBe(
+      '0000000000000000'
+    )
+  })
+
+  test('throws with invalid blocks', () => {
+    const block = RANDOM_VALID_STATE_BLOCK.block.data
+
+    for (let invalidAddress of INVALID_ADDRESSES) {
+      expect(() =>
+        nano.encodeBlock({ ...block, account: invalidAddress })
+      ).toThrowError('Account is not valid')
+    }
+    for (let invalidHash of INVALID_HASHES) {
+      expect(() =>
+        nano.encodeBlock({ ...block, previous: invalidHash })
+      ).toThrowError('Previous is not valid')
+    }
+    expect(() => nano.encodeBlock(block, new Uint8Array(215))).toThrowError(
+      'Offset is not valid'
+    )
+    expect(() => nano.viewBlock(new Uint8Array(216), 1)).toThrowError(
+      'Offset is not valid'
+    )
+  })
+})
+
+describe('createBlockParser', () => {
+  test('parses blocks split anywhere', async () => {
+    // blocks, and blocks along with their hash, without a trailing newline
+    const lines = VALID_STATE_BLOCKS.map((validStateBlock, index) =>
+      JSON.stringify(
+        index % 2 === 0 ? validStateBlock.block.data : validStateBlock.block
+      )
+    )
+    const input = Buffer.from(lines.join('\n\n'))
+
+    const parser = await nano.createBlockParser()
+    const chunks = feed(parser, input, 100)
+    chunks.push(parser.finish())
+
+    expect(Buffer.concat(chunks)).toEqual(
+      Buffer.from(
+        encodeBlocks(VALID_STATE_BLOCKS.map(({ block }) => block.data))
+      )
+    )
+  })
+
+  test('parses blocks for verification', async () => {
+    const input = VALID_STATE_BLOCKS.map(
+      ({ block }) => JSON.stringify(block.data) + '\n'
+    ).join('')
+
+    const parser = await nano.createBlockParser()
+    expect(nano.verifyBlocks(parser.update(Buffer.from(input)))).toEqual([])
+    expect(parser.finish().length).toBe(0)
+  })
+
+  test('throws with invalid blocks', async () => {
+    const block = RANDOM_VALID_STATE_BLOCK.block.data
+    const invalidLines = [
+      { ...block, type: 'send' },
+      { ...block, account: INVALID_ADDRESSES[0] },
+      { ...block, previous: INVALID_HASHES[0] },
+      { ...block, balance: '340282366920938463463374607431768211456' },
+      { ...block, work: undefined },
+    ].map(invalidBlock => JSON.stringify(invalidBlock) + '\n')
+
+    for (let invalidLine of invalidLines) {
+      const parser = await nano.createBlockParser()
+      expect(() => parser.update(Buffer.from(invalidLine))).toThrowError(
+        'Block is not valid'
+      )
+    }
+
+    const parser = await nano.createBlockParser()
+    parser.update(Buffer.from(JSON.stringify(block).slice(0, 100)))
+    expect(() => parser.finish()).toThrowError('Block is not valid')
+    expect(() => parser.update('{}')).toThrowError('Chunk is not valid')
+  })
+
+  test('gives the offset of an invalid line', async () => {
+    const validLine = JSON.stringify(VALID_STATE_BLOCKS[0].block.data) + '\n'
+    const parser = await nano.createBlockParser()
+    parser.update(Buffer.from(validLine))
+
+    expect(() => parser.update(Buffer.from(validLine + '{}\n'))).toThrowError(
+      `Block is not valid at offset ${2 * validLine.length}`
+    )
+  })
+
+  test('skips invalid lines', async () => {
+    const lines = VALID_STATE_BLOCKS.map(
+      ({ block }) => JSON.stringify(block.data) + '\n'
+    )
+    // an invalid block, and a line too long to be a block, split anywhere
+    const invalidLine =
+      JSON.stringify({ ...VALID_STATE_BLOCKS[0].block.data, type: 'send' }) +
+      '\n'
+    const longLine = 'x'.repeat(300 * 1024) + '\n'
+    const input = Buffer.from(
+      [lines[0], invalidLine, lines[1], longLine, lines[2]].join('')
+    )
+
+    const offsets = []
+    const parser = await nano.createBlockParser({
+      onInvalidLine: offset => offsets.push(offset),
+    })
+    const chunks = feed(parser, input, 10000)
+    chunks.push(parser.finish())
+
+    expect(Buffer.concat(chunks)).toEqual(
+      Buffer.from(
+        encodeBlocks(
+          VALID_STATE_BLOCKS.slice(0, 3).map(({ block }) => block.data)
+        )
+      )
+    )
+    expect(offsets).toEqual([
+      lines[0].length,
+      lines[0].length + invalidLine.length + lines[1].length,
+    ])
+  })
+})
@@ -0,0 +1,40 @@
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../../dist/nanocurrency.cjs')
+
+// encode blocks one after the other, as in a binary ledger
+const encodeBlocks = blocks => {
+  const encoded = new Uint8Array(blocks.length * nano.STATE_BLOCK_LENGTH)
+  blocks.forEach((block, index) =>
+    nano.encodeBlock(block, encoded, index * nano.STATE_BLOCK_LENGTH)
+  )
+
+  return encoded
+}
+
+// feed a stream by chunks of the given length, and return what it outputs.
+// The chunks of an asynchronous stream are awaited one after the other
+const feed = (stream, bytes, chunkLength) => {
+  const outputs = []
+  const next = offset => {
+    for (; offset < bytes.length; offset += chunkLength) {
+      const output = stream.update(bytes.subarray(offset, offset + chunkLength))
+      if (output instanceof Promise) {
+        return output.then(value => {
+          outputs.push(value)
+          return next(offset + chunkLength)
+        })
+      }
+      outputs.push(output)
+    }
+
+    return outputs
+  }
+
+  return next(0)
+}
+
+module.exports = {
+  encodeBlocks,
+  feed,
+}
@@ -13,6 +13,22 @@ const VALID_STATE_BLOCKS = require('./data/valid_blocks')
 const RANDOM_VALID_STATE_BLOCK = VALID_STATE_BLOCKS[0]
 
 describe('state', () => {
+  test('hashes preimages unchecked', () => {
+    for (let validStateBlock of VALID_STATE_BLOCKS) {
+      const preimage = nano.createBlockPreimage({
+        account: validStateBlock.block.data.account,
+        previous: validStateBlock.block.data.previous,
+        representative: validStateBlock.block.data.representative,
+        balance: validStateBlock.block.data.balance,
+        link: validStateBlock.originalLink,
+      })
+      const hashBytes = nano.unsafeHashBlockBytes(preimage)
+      expect(Buffer.from(hashBytes).toString('hex').toUpperCase()).toBe(
+        validStateBlock.block.hash
+      )
+    }
+  })
+
   test('creates correct state hash', () => {
     expect.assertions(VALID_STATE_BLOCKS.length)
     for (let validStateBlock of VALID_STATE_BLOCKS) {
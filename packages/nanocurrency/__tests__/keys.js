@@ -112,3 +112,81 @@ describe('addresses', () => {
     }
   })
 })
+
+describe('unchecked', () => {
+  const bytes = hex => Uint8Array.from(Buffer.from(hex, 'hex'))
+  const toHex = bytes => Buffer.from(bytes).toString('hex').toUpperCase()
+
+  test('derives from bytes', () => {
+    for (let key of VALID_KEYS) {
+      const secretKeyBytes = nano.unsafeDeriveSecretKey(
+        bytes(key.seed),
+        key.index
+      )
+      expect(toHex(secretKeyBytes)).toBe(key.secretKey)
+
+      const publicKeyBytes = nano.unsafeDerivePublicKey(secretKeyBytes)
+      expect(toHex(publicKeyBytes)).toBe(key.publicKey)
+      expect(nano.unsafeDeriveAddress(publicKeyBytes)).toBe(key.account)
+      expect(
+        nano.unsafeDeriveAddress(publicKeyBytes, { useNanoPrefix: true })
+      ).toBe(key.account.replace('xrb_', 'nano_'))
+    }
+  })
+})
+
+describe('address caches', () => {
+  beforeEach(() => nano.clearAddressCaches())
+
+  test('counts hits and misses', () => {
+    expect(nano.derivePublicKey(RANDOM_VALID_KEY.account)).toBe(
+      RANDOM_VALID_KEY.publicKey
+    )
+    expect(nano.derivePublicKey(RANDOM_VALID_KEY.account)).toBe(
+      RANDOM_VALID_KEY.publicKey
+    )
+    expect(nano.deriveAddress(RANDOM_VALID_KEY.publicKey)).toBe(
+      RANDOM_VALID_KEY.account
+    )
+    expect(
+      nano.deriveAddress(RANDOM_VALID_KEY.publicKey, { useNanoPrefix: true })
+    ).toBe(RANDOM_VALID_KEY.account.replace('xrb_', 'nano_'))
+    expect(nano.deriveAddress(RANDOM_VALID_KEY.publicKey)).toBe(
+      RANDOM_VALID_KEY.account
+    )
+
+    const stats = nano.getAddressCacheStats()
+    expect(stats.publicKeys).toMatchObject({ hits: 1, misses: 1, size: 1 })
+    expect(stats.addresses).toMatchObject({ hits: 1, misses: 2, size: 2 })
+  })
+
+  test('does not cache invalid addresses', () => {
+    for (let invalidAddress of INVALID_ADDRESSES) {
+      expect(nano.checkAddress(invalidAddress)).toBe(false)
+      expect(nano.checkAddress(invalidAddress)).toBe(false)
+    }
+
+    expect(nano.getAddressCacheStats().publicKeys.size).toBe(0)
+  })
+
+  test('evicts the least recently used entries', () => {
+    const { capacity } = nano.getAddressCacheStats().addresses
+    for (let i = 0; i <= capacity; i++) {
+      nano.deriveAddress(i.toString(16).padStart(64, '0'))
+      // used all along, so never evicted
+      nano.deriveAddress(RANDOM_VALID_KEY.publicKey)
+    }
+
+    const stats = nano.getAddressCacheStats().addresses
+    expect(stats.size).toBe(capacity)
+    expect(stats.hits).toBe(capacity)
+
+    // the first key derived is the one evicted
+    nano.deriveAddress(capacity.toString(16).padStart(64, '0'))
+    nano.deriveAddress('0'.padStart(64, '0'))
+    expect(nano.getAddressCacheStats().addresses).toMatchObject({
+      hits: capacity + 1,
+      misses: capacity + 3,
+    })
+  })
+})
@@ -0,0 +1,335 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_HASHES, INVALID_THRESHOLDS } = require('./data/invalid')
+const { encodeBlocks, feed } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
+const encodeLedger = () =>
+  encodeBlocks(VALID_STATE_BLOCKS.map(({ block }) => block.data))
+
+// a bad signature on the second block, and a bad work on the third one
+const encodeTamperedLedger = () => {
+  const ledger = encodeLedger()
+  ledger[nano.STATE_BLOCK_LENGTH + 144] ^= 1
+  ledger.fill(0, 3 * nano.STATE_BLOCK_LENGTH - 8, 3 * nano.STATE_BLOCK_LENGTH)
+
+  return ledger
+}
+
+const TAMPERED_FAILURES = [
+  { index: 1, hash: VALID_STATE_BLOCKS[1].block.hash, reason: 'signature' },
+  { index: 2, hash: VALID_STATE_BLOCKS[2].block.hash, reason: 'work' },
+]
+
+const EPOCH_LINK =
+  '65706F636820763120626C6F636B000000000000000000000000000000000000'
+const EPOCH_SIGNER = nano.deriveSecretKey('0'.repeat(64), 0)
+const NO_THRESHOLD = '0000000000000000'
+
+// an epoch block, with the balance of the block it follows
+const createEpochBlock = (block, secretKey) => {
+  const data = { ...block, link: EPOCH_LINK }
+  const hash = nano.hashBlock(data)
+
+  return {
+    hash,
+    block: { ...data, signature: nano.signBlock({ hash, secretKey }) },
+  }
+}
+
+describe('blocks verification', () => {
+  test('verifies valid blocks', () => {
+    expect(nano.verifyBlocks(encodeLedger())).toEqual([])
+  })
+
+  test('reports the failing blocks', () => {
+    expect(nano.verifyBlocks(encodeTamperedLedger())).toEqual(
+      TAMPERED_FAILURES
+    )
+    expect(
+      nano.verifyBlocks(encodeTamperedLedger(), { firstIndex: 10 })
+    ).toEqual(
+      TAMPERED_FAILURES.map(failure => ({
+        ...failure,
+        index: failure.index + 10,
+      }))
+    )
+  })
+
+  test('verifies the blocks of each worker', () => {
+    const ledger = encodeTamperedLedger()
+    const failures = []
+    for (let workerIndex = 0; workerIndex < 3; workerIndex++) {
+      failures.push(
+        ...nano.verifyBlocks(ledger, { workerIndex, workerCount: 3 })
+      )
+    }
+
+    expect(failures).toEqual(TAMPERED_FAILURES)
+  })
+
+  test('validates receive blocks against their own threshold', () => {
+    const ledger = encodeLedger()
+    const params = {
+      threshold: 'ffffffffffffffff',
+      receiveThreshold: '0000000000000000',
+    }
+
+    const failures = nano.verifyBlocks(ledger, params)
+    expect(failures.length).toBeGreaterThan(0)
+    for (let failure of failures) {
+      expect(failure.reason).toBe('work')
+      // open blocks are always receive blocks
+      expect(VALID_STATE_BLOCKS[failure.index].block.data.previous).not.toBe(
+        '0000000000000000000000000000000000000000000000000000000000000000'
+      )
+    }
+
+    const receives = new Uint8Array(VALID_STATE_BLOCKS.length).fill(1)
+    expect(nano.verifyBlocks(ledger, { ...params, receives })).toEqual([])
+  })
+
+  test('verifies epoch blocks against the epoch signers', () => {
+    const { block, hash } = createEpochBlock(
+      VALID_STATE_BLOCKS[2].block.data,
+      EPOCH_SIGNER
+    )
+    const params = {
+      threshold: NO_THRESHOLD,
+      epochSigners: [nano.derivePublicKey(EPOCH_SIGNER)],
+    }
+    expect(nano.verifyBlocks(nano.encodeBlock(block), params)).toEqual([])
+    // the signers of the live network by default
+    expect(
+      nano.verifyBlocks(nano.encodeBlock(block), { threshold: NO_THRESHOLD })
+    ).toEqual([{ index: 0, hash, reason: 'signature' }])
+
+    // not by the account itself
+    const accountSigned = createEpochBlock(
+      VALID_STATE_BLOCKS[2].block.data,
+      VALID_STATE_BLOCKS[2].secretKey
+    )
+    expect(
+      nano.verifyBlocks(nano.encodeBlock(accountSigned.block), params)
+    ).toEqual([{ index: 0, hash, reason: 'signature' }])
+  })
+
+  test('throws with invalid parameters', () => {
+    expect(() => nano.verifyBlocks(new Uint8Array(215))).toThrowError(
+      'Blocks are not valid'
+    )
+    for (let invalidEpochSigners of ['keys', ['foo']]) {
+      expect(() =>
+        nano.verifyBlocks(encodeLedger(), { epochSigners: invalidEpochSigners })
+      ).toThrowError('Epoch signers are not valid')
+    }
+    expect(() =>
+      nano.verifyBlocks(encodeLedger(), { workerIndex: 1, workerCount: 1 })
+    ).toThrowError('Worker parameters are not valid')
+    for (let invalidThreshold of INVALID_THRESHOLDS) {
+      expect(() =>
+        nano.verifyBlocks(encodeLedger(), { threshold: invalidThreshold })
+      ).toThrowError('Threshold is not valid')
+    }
+  })
+})
+
+describe('ledger verification', () => {
+  test('verifies a ledger fed in chunks', async () => {
+    const ledger = encodeTamperedLedger()
+    const batches = []
+    const failures = []
+    const verifier = nano.createLedgerVerifier({
+      batchLength: 2,
+      concurrency: 2,
+      verifyBatch: async (blocks, params) => {
+        batches.push(params.firstIndex)
+        return nano.verifyBlocks(blocks, params)
+      },
+      onProgress: (report, batchFailures) => failures.push(...batchFailures),
+    })
+
+    // chunks are not aligned on blocks
+    await feed(verifier, ledger, 100)
+    const report = await verifier.finish()
+
+    expect(report).toEqual({
+      blockCount: VALID_STATE_BLOCKS.length,
+      failureCount: TAMPERED_FAILURES.length,
+    })
+    expect(failures).toEqual(TAMPERED_FAILURES)
+    expect(batches.slice(0, 3)).toEqual([0, 2, 4])
+    expect(batches.length).toBe(Math.ceil(VALID_STATE_BLOCKS.length / 2))
+  })
+
+  test('reports the progress in order', async () => {
+    const counts = []
+    const verifier = nano.createLedgerVerifier({
+      batchLength: 4,
+      onProgress: report => counts.push(report.blockCount),
+    })
+
+    await verifier.update(encodeLedger())
+    await verifier.finish()
+
+    expect(counts[0]).toBe(4)
+    expect(counts[counts.length - 1]).toBe(VALID_STATE_BLOCKS.length)
+  })
+
+  test('throws with a truncated ledger', async () => {
+    const verifier = nano.createLedgerVerifier()
+    await verifier.update(encodeLedger().subarray(0, 300))
+
+    await expect(verifier.finish()).rejects.toThrow('Ledger is not valid')
+  })
+
+  test('throws with invalid parameters', () => {
+    expect(() => nano.createLedgerVerifier({ batchLength: 0 })).toThrowError(
+      'Batch length is not valid'
+    )
+    expect(() => nano.createLedgerVerifier({ concurrency: 1.5 })).toThrowError(
+      'Concurrency is not valid'
+    )
+    expect(() =>
+      nano.createLedgerVerifier({ epochSigners: ['foo'] })
+    ).toThrowError('Epoch signers are not valid')
+  })
+})
+
+describe('account chain verification', () => {
+  const OPEN_BLOCK = VALID_STATE_BLOCKS[0]
+  const SEND_BLOCK = VALID_STATE_BLOCKS[2]
+  // the chains are not worked, and validated against a zero threshold
+  const WORK = '0000000000000000'
+  const THRESHOLDS = { threshold: WORK }
+
+  const createChain = async appends => {
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async () => WORK,
+    })
+
+    const blocks = []
+    for (let data of appends) blocks.push((await chain.append(data)).block)
+
+    return blocks
+  }
+
+  const VALID_APPENDS = [
+    { balance: '10', link: SEND_BLOCK.block.hash },
+    { balance: '4', link: SEND_BLOCK.block.data.account },
+    { balance: '4', link: null, representative: SEND_BLOCK.block.data.account },
+    { balance: '7', link: OPEN_BLOCK.block.hash },
+  ]
+
+  test('verifies a valid chain', async () => {
+    const blocks = await createChain(VALID_APPENDS)
+
+    expect(await nano.verifyAccountChain(blocks, THRESHOLDS)).toBe(null)
+
+    // from the middle of the chain, encoded
+    const hash = nano.hashBlock(blocks[1])
+    const encoded = encodeBlocks(blocks.slice(2, 4))
+    expect(
+      await nano.verifyAccountChain(encoded, { ...THRESHOLDS, frontier: hash })
+    ).toBe(null)
+  })
+
+  test('reports a broken link', async () => {
+    const blocks = await createChain(VALID_APPENDS)
+    const unlinked = [blocks[0], blocks[2], blocks[3]]
+
+    expect(await nano.verifyAccountChain(unlinked, THRESHOLDS)).toEqual({
+      index: 1,
+      hash: nano.hashBlock(blocks[2]),
+      reason: 'previous',
+    })
+  })
+
+  test('reports an inconsistent balance', async () => {
+    // a change block raising the balance
+    const blocks = await createChain([
+      VALID_APPENDS[0],
+      { balance: '11', link: null },
+    ])
+
+    expect(await nano.verifyAccountChain(blocks, THRESHOLDS)).toEqual({
+      index: 1,
+      hash: nano.hashBlock(blocks[1]),
+      reason: 'balance',
+    })
+  })
+
+  test('verifies epoch blocks against the epoch signers', async () => {
+    const blocks = await createChain(VALID_APPENDS)
+    const next = { ...blocks[3], previous: nano.hashBlock(blocks[3]) }
+    const params = {
+      ...THRESHOLDS,
+      epochSigners: [nano.derivePublicKey(EPOCH_SIGNER)],
+    }
+
+    const epoch = createEpochBlock(next, EPOCH_SIGNER)
+    expect(
+      await nano.verifyAccountChain([...blocks, epoch.block], params)
+    ).toBe(null)
+
+    const accountSigned = createEpochBlock(next, OPEN_BLOCK.secretKey)
+    expect(
+      await nano.verifyAccountChain([...blocks, accountSigned.block], params)
+    ).toEqual({ index: 4, hash: epoch.hash, reason: 'signature' })
+
+    // an epoch block keeps the balance
+    const spending = createEpochBlock({ ...next, balance: '6' }, EPOCH_SIGNER)
+    expect(
+      await nano.verifyAccountChain([...blocks, spending.block], params)
+    ).toEqual({ index: 4, hash: spending.hash, reason: 'balance' })
+  })
+
+  test('stops on the first failing chunk', async () => {
+    const blocks = await createChain(VALID_APPENDS)
+    blocks[1] = { ...blocks[1], signature: blocks[0].signature }
+
+    const chunks = []
+    const failure = await nano.verifyAccountChain(blocks, {
+      ...THRESHOLDS,
+      chunkLength: 1,
+      concurrency: 1,
+      verifyChunk: async (chunk, params) => {
+        chunks.push(params.firstIndex)
+        return nano.verifyBlocks(chunk, params)
+      },
+    })
+
+    expect(failure).toEqual({
+      index: 1,
+      hash: nano.hashBlock(blocks[1]),
+      reason: 'signature',
+    })
+    expect(chunks).toEqual([0, 1])
+  })
+
+  test('validates the work against the threshold', async () => {
+    const blocks = await createChain(VALID_APPENDS)
+
+    expect((await nano.verifyAccountChain(blocks)).reason).toBe('work')
+  })
+
+  test('throws with invalid parameters', async () => {
+    for (let invalidHash of INVALID_HASHES) {
+      await expect(
+        nano.verifyAccountChain([], { frontier: invalidHash })
+      ).rejects.toThrow('Frontier is not valid')
+    }
+    await expect(nano.verifyAccountChain(new Uint8Array(215))).rejects.toThrow(
+      'Blocks are not valid'
+    )
+    await expect(
+      nano.verifyAccountChain([], { chunkLength: 0 })
+    ).rejects.toThrow('Chunk length is not valid')
+  })
+})
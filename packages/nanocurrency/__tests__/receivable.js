@@ -0,0 +1,109 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_HASHES } = require('./data/invalid')
+const { encodeBlocks, feed } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
+const scan = (scanner, blocks, chunkLength) => {
+  const receivables = [].concat(...feed(scanner, blocks, chunkLength))
+  scanner.finish()
+
+  return receivables
+}
+
+// a wallet of uniform 32 bytes keys
+const SEED = '0'.repeat(64)
+const WALLET = []
+for (let index = 0; index < 1000; index++) {
+  WALLET.push(nano.deriveSecretKey(SEED, index))
+}
+const OTHER_KEY = nano.deriveSecretKey(SEED, 1000)
+
+describe('receivable scanner', () => {
+  const OPEN_BLOCK = VALID_STATE_BLOCKS[0]
+  const SEND_BLOCK = VALID_STATE_BLOCKS[2]
+  let blocks
+
+  beforeAll(async () => {
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async () => '0000000000000000',
+    })
+    const steps = [
+      ['340282366920938463463374607431768211455', SEND_BLOCK.block.hash],
+      ['340282366920938463463374607431768211454', WALLET[17]],
+      ['1000', OTHER_KEY],
+      ['2000', SEND_BLOCK.block.hash],
+      ['0', WALLET[999]],
+    ]
+    blocks = []
+    for (let [balance, link] of steps) {
+      blocks.push((await chain.append({ balance, link })).block)
+    }
+  })
+
+  test('finds the blocks sending to the wallet', () => {
+    for (let chunkLength of [100, nano.STATE_BLOCK_LENGTH, 100000]) {
+      const scanner = nano.createReceivableScanner(WALLET)
+      const receivables = scan(scanner, encodeBlocks(blocks), chunkLength)
+
+      expect(receivables).toEqual([
+        {
+          index: 1,
+          hash: nano.hashBlock(blocks[1]),
+          account: blocks[1].account,
+          destination: nano.deriveAddress(WALLET[17]),
+          amount: '1',
+        },
+        {
+          index: 4,
+          hash: nano.hashBlock(blocks[4]),
+          account: blocks[4].account,
+          destination: nano.deriveAddress(WALLET[999]),
+          amount: '2000',
+        },
+      ])
+    }
+  })
+
+  test('finds the blocks sending to the wallet in a ledger', () => {
+    const ledger = encodeBlocks([
+      ...VALID_STATE_BLOCKS.map(({ block }) => block.data),
+      ...blocks,
+    ])
+    const receivables = scan(nano.createReceivableScanner(WALLET), ledger, 4096)
+
+    expect(receivables.map(({ index }) => index)).toEqual([
+      VALID_STATE_BLOCKS.length + 1,
+      VALID_STATE_BLOCKS.length + 4,
+    ])
+  })
+
+  test('leaves the amount out without the previous block', () => {
+    const scanner = nano.createReceivableScanner(WALLET)
+    const receivables = scan(scanner, encodeBlocks(blocks.slice(1)), 4096)
+
+    expect(receivables.map(({ amount }) => amount)).toEqual([null, '2000'])
+  })
+
+  test('throws with invalid parameters', () => {
+    expect(() => nano.createReceivableScanner('keys')).toThrowError(
+      'Public keys are not valid'
+    )
+    for (let invalidKey of INVALID_HASHES) {
+      expect(() => nano.createReceivableScanner([invalidKey])).toThrowError(
+        'Public key is not valid'
+      )
+    }
+
+    const scanner = nano.createReceivableScanner(WALLET)
+    expect(() => scanner.update('blocks')).toThrowError('Chunk is not valid')
+    scanner.update(new Uint8Array(215))
+    expect(() => scanner.finish()).toThrowError('Blocks are not valid')
+  })
+})
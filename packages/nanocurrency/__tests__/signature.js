@@ -113,3 +113,31 @@ describe('verify', () => {
     }
   })
 })
+
+describe('unchecked', () => {
+  const bytes = hex => Uint8Array.from(Buffer.from(hex, 'hex'))
+  const toHex = bytes => Buffer.from(bytes).toString('hex').toUpperCase()
+
+  test('signs and verifies bytes', () => {
+    for (let block of VALID_BLOCKS) {
+      const hashBytes = bytes(block.block.hash)
+      const signatureBytes = nano.unsafeSignBlock(
+        hashBytes,
+        bytes(block.secretKey)
+      )
+      expect(toHex(signatureBytes)).toBe(block.block.data.signature)
+
+      const publicKeyBytes = bytes(nano.derivePublicKey(block.secretKey))
+      expect(
+        nano.unsafeVerifyBlock(hashBytes, signatureBytes, publicKeyBytes)
+      ).toBe(true)
+      expect(
+        nano.unsafeVerifyBlock(
+          hashBytes,
+          bytes(INVALID_SIGNATURE),
+          publicKeyBytes
+        )
+      ).toBe(false)
+    }
+  })
+})
@@ -0,0 +1,111 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { encodeBlocks, feed } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
+const concat = arrays => new Uint8Array(Buffer.concat(arrays.map(Buffer.from)))
+
+const writeSnapshot = (blocks, segmentLength, chunkLength) => {
+  const writer = nano.createSnapshotWriter({ segmentLength })
+  const outputs = feed(writer, blocks, chunkLength)
+  outputs.push(writer.finish())
+
+  return concat(outputs)
+}
+
+const readSnapshot = (snapshot, chunkLength) => {
+  const reader = nano.createSnapshotReader()
+  const segments = [].concat(...feed(reader, snapshot, chunkLength))
+  reader.finish()
+
+  return segments
+}
+
+const LEDGER = encodeBlocks(VALID_STATE_BLOCKS.map(({ block }) => block.data))
+
+describe('snapshot', () => {
+  test('reads back the blocks written', () => {
+    for (let [segmentLength, chunkLength] of [[1, 100], [7, 1000], [4096, 5]]) {
+      const snapshot = writeSnapshot(LEDGER, segmentLength, chunkLength)
+      const segments = readSnapshot(snapshot, chunkLength)
+
+      expect(segments.length).toBe(
+        Math.ceil(VALID_STATE_BLOCKS.length / segmentLength)
+      )
+      segments.forEach((segment, index) => {
+        expect(segment.firstIndex).toBe(index * segmentLength)
+      })
+      expect(concat(segments.map(segment => segment.encode()))).toEqual(LEDGER)
+    }
+  })
+
+  test('hashes the columns of the segments', async () => {
+    const [segment] = readSnapshot(writeSnapshot(LEDGER, 4096, 4096), 4096)
+    const hashes = await nano.hashBlocks(segment.columns)
+
+    expect(Buffer.from(hashes).toString('hex')).toBe(
+      VALID_STATE_BLOCKS.map(({ block }) => block.hash.toLowerCase()).join('')
+    )
+    expect(segment.signatures.length).toBe(VALID_STATE_BLOCKS.length * 64)
+    expect(segment.works.length).toBe(VALID_STATE_BLOCKS.length * 8)
+  })
+
+  test('writes account chains in less room', async () => {
+    const OPEN_BLOCK = VALID_STATE_BLOCKS[0]
+    const SEND_BLOCK = VALID_STATE_BLOCKS[2]
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async () => '0000000000000000',
+    })
+    const blocks = []
+    for (let balance of ['10', '340282366920938463463374607431768211455']) {
+      blocks.push(
+        (await chain.append({ balance, link: SEND_BLOCK.block.hash })).block
+      )
+    }
+    // sends to the account itself, back to zero
+    for (let balance of ['1000000', '0']) {
+      blocks.push(
+        (await chain.append({ balance, link: OPEN_BLOCK.block.data.account }))
+          .block
+      )
+    }
+
+    const ledger = encodeBlocks(blocks)
+    const snapshot = writeSnapshot(ledger, 4096, 4096)
+    // 288 bytes of signatures and works, 64 of keys, 96 of previous blocks,
+    // 64 of receive links, 42 of balances and 68 of headers, flags and ids
+    expect(snapshot.length).toBe(622)
+    expect(readSnapshot(snapshot, 1)[0].encode()).toEqual(ledger)
+  })
+
+  test('throws with invalid parameters', () => {
+    for (let segmentLength of [0, 1.5, -1]) {
+      expect(() => nano.createSnapshotWriter({ segmentLength })).toThrowError(
+        'Segment length is not valid'
+      )
+    }
+
+    const writer = nano.createSnapshotWriter()
+    expect(() => writer.update('blocks')).toThrowError('Chunk is not valid')
+    writer.update(LEDGER.subarray(0, 215))
+    expect(() => writer.finish()).toThrowError('Blocks are not valid')
+
+    const snapshot = writeSnapshot(LEDGER, 4096, 4096)
+    const INVALID_SNAPSHOTS = [
+      new Uint8Array(0),
+      LEDGER,
+      snapshot.subarray(0, snapshot.length - 1),
+    ]
+    for (let invalidSnapshot of INVALID_SNAPSHOTS) {
+      expect(() => readSnapshot(invalidSnapshot, 4096)).toThrowError(
+        'Snapshot is not valid'
+      )
+    }
+  })
+})
@@ -0,0 +1,131 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_HASHES } = require('./data/invalid')
+const { encodeBlocks } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
+const LEDGER = encodeBlocks(VALID_STATE_BLOCKS.map(({ block }) => block.data))
+
+// the index of the first three blocks, as written by the native block-store
+const NATIVE_INDEX =
+  '4e42534901000000030000000800000030b313950fe441f009649dbbef093dc7968a970e' +
+  '56dadc3e50b1e23a481c5ac60e1c50db1ee1c0a8876ac22e6c472be4c86e7316409016fe' +
+  '4fb0f0e100a79feefa5ea85833eb7d2618de2898c15e9812a9f2395f83a49e6086ad7015' +
+  '65506ce60000000000000000000000000100000000000000030000000000000000000000' +
+  '000000000200000000000000'
+
+const MISSING_HASH =
+  '0000000000000000000000000000000000000000000000000000000000000000'
+
+describe('block store', () => {
+  test('finds every block by hash', async () => {
+    const store = nano.openBlockStore(
+      LEDGER,
+      await nano.createBlockStoreIndex(LEDGER)
+    )
+
+    expect(store.blockCount).toBe(VALID_STATE_BLOCKS.length)
+    VALID_STATE_BLOCKS.forEach(({ block }, index) => {
+      expect(store.indexOf(block.hash)).toBe(index)
+      expect(store.indexOf(block.hash.toLowerCase())).toBe(index)
+      expect(store.get(block.hash).hash()).toBe(block.hash)
+      expect(store.hashAt(index)).toBe(block.hash)
+    })
+    expect(store.indexOf(MISSING_HASH)).toBe(-1)
+    expect(store.get(MISSING_HASH)).toBe(null)
+  })
+
+  test('writes the index of the native tool', async () => {
+    const blocks = LEDGER.subarray(0, 3 * nano.STATE_BLOCK_LENGTH)
+    const index = await nano.createBlockStoreIndex(blocks)
+
+    expect(Buffer.from(index).toString('hex')).toBe(NATIVE_INDEX)
+    const store = nano.openBlockStore(blocks, Buffer.from(NATIVE_INDEX, 'hex'))
+    expect(store.indexOf(VALID_STATE_BLOCKS[2].block.hash)).toBe(2)
+  })
+
+  test('iterates over the blocks', async () => {
+    const store = nano.openBlockStore(
+      LEDGER,
+      await nano.createBlockStoreIndex(LEDGER)
+    )
+
+    const hashes = []
+    store.forEach((block, index) => {
+      hashes.push(block.hash())
+      return index < 2 ? undefined : false
+    })
+    expect(hashes).toEqual(
+      VALID_STATE_BLOCKS.slice(0, 3).map(({ block }) => block.hash)
+    )
+    expect(store.at(1).account).toBe(VALID_STATE_BLOCKS[1].block.data.account)
+  })
+
+  test('follows account chains', async () => {
+    const OPEN_BLOCK = VALID_STATE_BLOCKS[0]
+    const SEND_BLOCK = VALID_STATE_BLOCKS[2]
+    const chain = nano.createAccountChain(OPEN_BLOCK.secretKey, {
+      frontier: null,
+      balance: '0',
+      representative: OPEN_BLOCK.block.data.representative,
+      computeWork: async () => '0000000000000000',
+    })
+    const blocks = []
+    for (let balance of ['10', '4', '7']) {
+      blocks.push(
+        (await chain.append({ balance, link: SEND_BLOCK.block.hash })).block
+      )
+    }
+
+    // the chain interleaved with other blocks, and out of order
+    const ledger = encodeBlocks([
+      VALID_STATE_BLOCKS[1].block.data,
+      blocks[2],
+      blocks[0],
+      VALID_STATE_BLOCKS[3].block.data,
+      blocks[1],
+    ])
+    const store = nano.openBlockStore(
+      ledger,
+      await nano.createBlockStoreIndex(ledger)
+    )
+
+    for (let block of blocks) {
+      expect(store.getAccountChain(nano.hashBlock(block))).toEqual([2, 4, 1])
+    }
+    expect(store.previousOf(2)).toBe(-1)
+    expect(store.previousOf(4)).toBe(2)
+    expect(store.successorOf(4)).toBe(1)
+    expect(store.successorOf(1)).toBe(-1)
+    expect(store.getAccountChain(MISSING_HASH)).toEqual([])
+  })
+
+  test('throws with invalid parameters', async () => {
+    const index = await nano.createBlockStoreIndex(LEDGER)
+
+    await expect(
+      nano.createBlockStoreIndex(new Uint8Array(215))
+    ).rejects.toThrow('Blocks are not valid')
+    expect(() =>
+      nano.openBlockStore(LEDGER.subarray(nano.STATE_BLOCK_LENGTH), index)
+    ).toThrowError('Index is not valid')
+    expect(() =>
+      nano.openBlockStore(LEDGER, index.subarray(0, 100))
+    ).toThrowError('Index is not valid')
+
+    const store = nano.openBlockStore(LEDGER, index)
+    for (let invalidHash of INVALID_HASHES) {
+      expect(() => store.indexOf(invalidHash)).toThrowError(
+        'Hash is not valid'
+      )
+    }
+    for (let invalidIndex of [-1, 1.5, VALID_STATE_BLOCKS.length]) {
+      expect(() => store.at(invalidIndex)).toThrowError(
+        'Block index is not valid'
+      )
+    }
+  })
+})
@@ -0,0 +1,105 @@
+/* eslint-env jest */
+/* eslint-disable @typescript-eslint/no-var-requires */
+
+const nano = require('../dist/nanocurrency.cjs')
+const { INVALID_AMOUNTS } = require('./data/invalid')
+const { encodeBlocks, feed } = require('./data/blocks')
+
+const VALID_STATE_BLOCKS = require('./data/valid_blocks')
+
+const MAX_AMOUNT = '340282366920938463463374607431768211455'
+
+const aggregate = (blocks, params, chunkLength = 4096) => {
+  const aggregator = nano.createWeightAggregator(params)
+  feed(aggregator, blocks, chunkLength)
+
+  return aggregator.finish()
+}
+
+describe('weight aggregator', () => {
+  const BLOCK = VALID_STATE_BLOCKS[0].block.data
+  const REPRESENTATIVES = VALID_STATE_BLOCKS.slice(0, 2).map(
+    ({ block }) => block.data.representative
+  )
+  const ACCOUNTS = VALID_STATE_BLOCKS.slice(0, 3).map(
+    ({ block }) => block.data.account
+  )
+  const block = (account, representative, balance) => ({
+    ...BLOCK,
+    account,
+    representative,
+    balance,
+  })
+
+  test('aggregates the latest block of every account', () => {
+    const blocks = encodeBlocks([
+      block(ACCOUNTS[0], REPRESENTATIVES[0], '1000'),
+      block(ACCOUNTS[1], REPRESENTATIVES[0], '1'),
+      // the representative and the balance of the account change
+      block(ACCOUNTS[0], REPRESENTATIVES[1], '4000'),
+      block(ACCOUNTS[2], REPRESENTATIVES[0], '20'),
+    ])
+
+    for (let chunkLength of [100, nano.STATE_BLOCK_LENGTH, 4096]) {
+      expect(aggregate(blocks, { supply: '5000' }, chunkLength)).toEqual({
+        blockCount: 4,
+        accountCount: 3,
+        total: '4021',
+        supply: '5000',
+        exceedsSupply: false,
+        unaccounted: '979',
+        weights: [
+          { representative: REPRESENTATIVES[1], weight: '4000' },
+          { representative: REPRESENTATIVES[0], weight: '21' },
+        ],
+      })
+    }
+  })
+
+  test('sums balances wider than 128 bits', () => {
+    const report = aggregate(
+      encodeBlocks([
+        block(ACCOUNTS[0], REPRESENTATIVES[0], MAX_AMOUNT),
+        block(ACCOUNTS[1], REPRESENTATIVES[0], MAX_AMOUNT),
+        block(ACCOUNTS[2], REPRESENTATIVES[1], '0'),
+      ])
+    )
+
+    expect(report.total).toBe('680564733841876926926749214863536422910')
+    expect(report.supply).toBe(MAX_AMOUNT)
+    expect(report.exceedsSupply).toBe(true)
+    expect(report.unaccounted).toBe('0')
+    // a representative without weight is left out
+    expect(report.weights).toEqual([
+      {
+        representative: REPRESENTATIVES[0],
+        weight: '680564733841876926926749214863536422910',
+      },
+    ])
+  })
+
+  test('aggregates an empty ledger', () => {
+    expect(aggregate(new Uint8Array(0))).toEqual({
+      blockCount: 0,
+      accountCount: 0,
+      total: '0',
+      supply: MAX_AMOUNT,
+      exceedsSupply: false,
+      unaccounted: MAX_AMOUNT,
+      weights: [],
+    })
+  })
+
+  test('throws with invalid parameters', () => {
+    for (let invalidAmount of INVALID_AMOUNTS) {
+      expect(() =>
+        nano.createWeightAggregator({ supply: invalidAmount })
+      ).toThrowError('Supply is not valid')
+    }
+
+    const aggregator = nano.createWeightAggregator()
+    expect(() => aggregator.update('blocks')).toThrowError('Chunk is not valid')
+    aggregator.update(new Uint8Array(215))
+    expect(() => aggregator.finish()).toThrowError('Blocks are not valid')
+  })
+})
@@ -0,0 +1,3 @@
+import Module from './assembly'
+
+export default Module
@@ -1,9 +1,22 @@
 interface Cwrap {
-  (fun: 'emscripten_work', ret: 'string', params: ['string', 'string', 'number', 'number']): (blockHash: string, workThreshold: string, workerIndex: number, workerCount: number) => string
+  (fun: 'emscripten_work_chunk', ret: 'string', params: ['string', 'string', 'number', 'number', 'number', 'number']): (blockHash: string, workThreshold: string, workerIndex: number, workerCount: number, offset: number, count: number) => string
+  (fun: 'emscripten_block_hash', ret: null, params: ['number', 'number']): (preimagePointer: number, hashPointer: number) => void
+  (fun: 'emscripten_block_hash_batch', ret: null, params: ['number', 'number', 'number']): (preimagesPointer: number, count: number, hashesPointer: number) => void
+  (fun: 'emscripten_block_hash_columns', ret: null, params: ['number', 'number', 'number', 'number', 'number', 'number', 'number']): (accountsPointer: number, previousPointer: number, representativesPointer: number, balancesPointer: number, linksPointer: number, count: number, hashesPointer: number) => void
+  (fun: 'emscripten_block_midstate', ret: null, params: ['number', 'number']): (prefixPointer: number, midstatePointer: number) => void
+  (fun: 'emscripten_block_hash_suffixes', ret: null, params: ['number', 'number', 'number', 'number']): (midstatePointer: number, suffixesPointer: number, count: number, hashesPointer: number) => void
+  (fun: 'emscripten_blake2b_multi', ret: 'number', params: ['number', 'number', 'number', 'number', 'number']): (hashesPointer: number, outputLength: number, messagePointersPointer: number, messageLengthsPointer: number, count: number) => number
+  (fun: 'emscripten_blake2b_state_length', ret: 'number', params: []): () => number
+  (fun: 'emscripten_blake2b_init', ret: 'number', params: ['number', 'number', 'number', 'number']): (statePointer: number, outputLength: number, keyPointer: number, keyLength: number) => number
+  (fun: 'emscripten_blake2b_update', ret: 'number', params: ['number', 'number', 'number']): (statePointer: number, dataPointer: number, dataLength: number) => number
+  (fun: 'emscripten_blake2b_final', ret: 'number', params: ['number', 'number']): (statePointer: number, hashPointer: number) => number
 }
 
-declare interface Assembly {
+export interface Assembly {
   cwrap: Cwrap
+  HEAPU8: Uint8Array
+  _malloc(size: number): number
+  _free(pointer: number): void
 }
 
 declare function Module(): Promise<Assembly>
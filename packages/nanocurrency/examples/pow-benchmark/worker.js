@@ -8,7 +8,11 @@ onmessage = async function({ data }) {
 
   postMessage({ type: 'started' });
 
-  const work = await NanoCurrency.computeWork(blockHash, { workerIndex, workerCount });
+  const work = await NanoCurrency.computeWork(blockHash, {
+    workerIndex,
+    workerCount,
+    onProgress: progress => postMessage({ type: 'progress', progress })
+  });
 
   postMessage({ type: 'done', work });
 };
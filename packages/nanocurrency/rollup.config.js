@@ -1,3 +1,4 @@
+import fs from 'fs'
 import autoExternal from 'rollup-plugin-auto-external'
 import typescript from 'rollup-plugin-typescript2'
 import resolve from '@rollup/plugin-node-resolve'
@@ -17,6 +18,19 @@ const LICENSE_BANNER = `
 */
 `.trim()
 
+// the SIMD module, fetched only by runtimes supporting SIMD, is kept out of
+// the bundles and copied next to them
+const simdAssembly = () => ({
+  name: 'simd-assembly',
+  generateBundle() {
+    this.emitFile({
+      type: 'asset',
+      fileName: 'assembly-simd.wasm',
+      source: fs.readFileSync('assembly-simd.wasm'),
+    })
+  },
+})
+
 const outputs = [
   {
     name: 'NanoCurrency',
@@ -41,6 +55,7 @@ const configs = outputs.map((output, index) => {
       autoExternal({
         dependencies: output.format !== 'umd',
       }),
+      simdAssembly(),
     ],
   }
 
@@ -3,52 +3,358 @@
  * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
  * Licensed under GPL-3.0 (https://git.io/vAZsK)
  */
-import loadAssembly from '../assembly'
+import { blake2b } from 'blakejs'
+import loadScalarAssembly, { Assembly } from '../assembly'
+import loadSimdAssembly from '../assembly-simd'
 import { checkHash, checkThreshold } from './check'
+import { concatArrays } from './utils'
 import { DEFAULT_WORK_THRESHOLD } from './work'
 
-type WorkFunction = (
+type WorkChunkFunction = (
   blockHash: string,
   workThreshold: string,
   workerIndex: number,
-  workerCount: number
+  workerCount: number,
+  offset: number,
+  count: number
 ) => string
 
+/** @hidden */
+export const STATE_BLOCK_PREIMAGE_LENGTH = 176
+/** @hidden */
+export const STATE_BLOCK_HASH_LENGTH = 32
+
+/** Preamble, account, previous and representative: the first BLAKE2b block. */
+const STATE_BLOCK_PREFIX_LENGTH = 128
+/** Balance and link. */
+const STATE_BLOCK_SUFFIX_LENGTH =
+  STATE_BLOCK_PREIMAGE_LENGTH - STATE_BLOCK_PREFIX_LENGTH
+const STATE_BLOCK_MIDSTATE_LENGTH = 64
+
+/** Count of blocks hashed by a single call into WebAssembly. */
+const BLOCK_BATCH_SIZE = 4096
+/** @hidden */
+export const BATCH_BUFFER_LENGTH =
+  BLOCK_BATCH_SIZE * (STATE_BLOCK_PREIMAGE_LENGTH + STATE_BLOCK_HASH_LENGTH)
+
+/** Length of an encoded state block, see `STATE_BLOCK_LENGTH` in codec.ts. */
+const ENCODED_BLOCK_LENGTH = 216
+/**
+ * Bytes of JSON parsed by a single call into WebAssembly, far more than a
+ * line: the batch buffer holds the result, this window, then the blocks.
+ */
+const NDJSON_WINDOW_LENGTH = 256 * 1024
+const NDJSON_RESULT_LENGTH = 8
+const NEWLINE = 10
+const NDJSON_BLOCK_CAPACITY = Math.floor(
+  (BATCH_BUFFER_LENGTH - NDJSON_RESULT_LENGTH - NDJSON_WINDOW_LENGTH) /
+    ENCODED_BLOCK_LENGTH
+)
+
+/** The fields of a state block preimage after the preamble, and their size. */
+const BLOCK_COLUMNS: [keyof BlockColumns, number][] = [
+  ['accounts', 32],
+  ['previous', 32],
+  ['representatives', 32],
+  ['balances', 16],
+  ['links', 32],
+]
+
+type Blake2bMultiFunction = (
+  hashesPointer: number,
+  outputLength: number,
+  messagePointersPointer: number,
+  messageLengthsPointer: number,
+  count: number
+) => number
+type Blake2bInitFunction = (
+  statePointer: number,
+  outputLength: number,
+  keyPointer: number,
+  keyLength: number
+) => number
+type Blake2bUpdateFunction = (
+  statePointer: number,
+  dataPointer: number,
+  dataLength: number
+) => number
+type Blake2bFinalFunction = (
+  statePointer: number,
+  hashPointer: number
+) => number
+type Blake2bpLeafInitFunction = (
+  statePointer: number,
+  outputLength: number,
+  index: number,
+  keyPointer: number,
+  keyLength: number
+) => number
+type Blake2bpLeafUpdateFunction = (
+  statePointer: number,
+  index: number,
+  dataPointer: number,
+  dataLength: number
+) => void
+type Blake2bpLeafFinalFunction = (
+  statePointer: number,
+  leafHashPointer: number
+) => number
+type Blake2bpRootFunction = (
+  hashPointer: number,
+  outputLength: number,
+  keyLength: number,
+  leafHashesPointer: number
+) => number
+type BlockHashFunction = (preimagePointer: number, hashPointer: number) => void
+type BlockMidstateFunction = (
+  prefixPointer: number,
+  midstatePointer: number
+) => void
+type BlockHashSuffixesFunction = (
+  midstatePointer: number,
+  suffixesPointer: number,
+  count: number,
+  hashesPointer: number
+) => void
+type BlockHashBatchFunction = (
+  preimagesPointer: number,
+  count: number,
+  hashesPointer: number
+) => void
+type BlockHashColumnsFunction = (
+  accountsPointer: number,
+  previousPointer: number,
+  representativesPointer: number,
+  balancesPointer: number,
+  linksPointer: number,
+  count: number,
+  hashesPointer: number
+) => void
+type NdjsonParseBlocksFunction = (
+  inputPointer: number,
+  inputLength: number,
+  last: number,
+  blocksPointer: number,
+  capacity: number,
+  resultPointer: number
+) => number
+
 interface AssemblyWhenNotLoaded {
   loaded: false
-  work: null
+  workChunk: null
+  blake2bMulti: null
+  blake2bInit: null
+  blake2bUpdate: null
+  blake2bFinal: null
+  blake2bStateLength: null
+  blake2bpLeafInit: null
+  blake2bpLeafUpdate: null
+  blake2bpLeafFinal: null
+  blake2bpRoot: null
+  blockHash: null
+  blockHashBatch: null
+  blockHashColumns: null
+  blockMidstate: null
+  blockHashSuffixes: null
+  ndjsonParseBlocks: null
+  heap: null
+  preimagePointer: null
+  hashPointer: null
+  batchPointer: null
 }
-interface AssemblyWhenLoaded {
+/** @hidden */
+export interface AssemblyWhenLoaded {
   loaded: true
-  work: WorkFunction
+  workChunk: WorkChunkFunction
+  blake2bMulti: Blake2bMultiFunction
+  blake2bInit: Blake2bInitFunction
+  blake2bUpdate: Blake2bUpdateFunction
+  blake2bFinal: Blake2bFinalFunction
+  blake2bStateLength: number
+  blake2bpLeafInit: Blake2bpLeafInitFunction
+  blake2bpLeafUpdate: Blake2bpLeafUpdateFunction
+  blake2bpLeafFinal: Blake2bpLeafFinalFunction
+  blake2bpRoot: Blake2bpRootFunction
+  blockHash: BlockHashFunction
+  blockHashBatch: BlockHashBatchFunction
+  blockHashColumns: BlockHashColumnsFunction
+  blockMidstate: BlockMidstateFunction
+  blockHashSuffixes: BlockHashSuffixesFunction
+  ndjsonParseBlocks: NdjsonParseBlocksFunction
+  /** The module memory */
+  heap: Uint8Array
+  /** Scratch buffers in the module memory, allocated once */
+  preimagePointer: number
+  hashPointer: number
+  /** Room for a batch of preimages (or columns), followed by their hashes */
+  batchPointer: number
 }
 
 const ASSEMBLY: AssemblyWhenNotLoaded | AssemblyWhenLoaded = {
   loaded: false,
-  work: null,
+  workChunk: null,
+  blake2bMulti: null,
+  blake2bInit: null,
+  blake2bUpdate: null,
+  blake2bFinal: null,
+  blake2bStateLength: null,
+  blake2bpLeafInit: null,
+  blake2bpLeafUpdate: null,
+  blake2bpLeafFinal: null,
+  blake2bpRoot: null,
+  blockHash: null,
+  blockHashBatch: null,
+  blockHashColumns: null,
+  blockMidstate: null,
+  blockHashSuffixes: null,
+  ndjsonParseBlocks: null,
+  heap: null,
+  preimagePointer: null,
+  hashPointer: null,
+  batchPointer: null,
 }
 
-function loadWasm(): Promise<AssemblyWhenLoaded> {
+/**
+ * Smallest module using SIMD instructions (`i8x16.popcnt` of an
+ * `i8x16.splat`), only valid for runtimes supporting WebAssembly SIMD.
+ */
+const SIMD_PROBE = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8,
+  0, 65, 0, 253, 15, 253, 98, 11,
+])
+
+function supportsSimd(): boolean {
+  try {
+    return WebAssembly.validate(SIMD_PROBE)
+  } catch (err) {
+    return false
+  }
+}
+
+/** @hidden */
+export function loadWasm(): Promise<AssemblyWhenLoaded> {
   return new Promise((resolve, reject) => {
     if (ASSEMBLY.loaded) {
       return resolve(ASSEMBLY)
     }
 
     try {
-      /* eslint-disable promise/catch-or-return, promise/always-return */
-      loadAssembly().then(assembly => {
+      const onLoad = (assembly: Assembly): void => {
         const loaded = Object.assign(ASSEMBLY, {
           loaded: true,
-          work: assembly.cwrap('emscripten_work', 'string', [
+          workChunk: assembly.cwrap('emscripten_work_chunk', 'string', [
             'string',
             'string',
             'number',
             'number',
+            'number',
+            'number',
+          ]),
+          blake2bMulti: assembly.cwrap('emscripten_blake2b_multi', 'number', [
+            'number',
+            'number',
+            'number',
+            'number',
+            'number',
+          ]),
+          blake2bInit: assembly.cwrap('emscripten_blake2b_init', 'number', [
+            'number',
+            'number',
+            'number',
+            'number',
+          ]),
+          blake2bUpdate: assembly.cwrap('emscripten_blake2b_update', 'number', [
+            'number',
+            'number',
+            'number',
+          ]),
+          blake2bFinal: assembly.cwrap('emscripten_blake2b_final', 'number', [
+            'number',
+            'number',
           ]),
+          blake2bStateLength: assembly.cwrap(
+            'emscripten_blake2b_state_length',
+            'number',
+            []
+          )(),
+          blake2bpLeafInit: assembly.cwrap(
+            'emscripten_blake2bp_leaf_init',
+            'number',
+            ['number', 'number', 'number', 'number', 'number']
+          ),
+          blake2bpLeafUpdate: assembly.cwrap(
+            'emscripten_blake2bp_leaf_update',
+            null,
+            ['number', 'number', 'number', 'number']
+          ),
+          blake2bpLeafFinal: assembly.cwrap(
+            'emscripten_blake2bp_leaf_final',
+            'number',
+            ['number', 'number']
+          ),
+          blake2bpRoot: assembly.cwrap('emscripten_blake2bp_root', 'number', [
+            'number',
+            'number',
+            'number',
+            'number',
+          ]),
+          blockHash: assembly.cwrap('emscripten_block_hash', null, [
+            'number',
+            'number',
+          ]),
+          blockHashBatch: assembly.cwrap('emscripten_block_hash_batch', null, [
+            'number',
+            'number',
+            'number',
+          ]),
+          blockHashColumns: assembly.cwrap(
+            'emscripten_block_hash_columns',
+            null,
+            [
+              'number',
+              'number',
+              'number',
+              'number',
+              'number',
+              'number',
+              'number',
+            ]
+          ),
+          blockMidstate: assembly.cwrap('emscripten_block_midstate', null, [
+            'number',
+            'number',
+          ]),
+          blockHashSuffixes: assembly.cwrap(
+            'emscripten_block_hash_suffixes',
+            null,
+            ['number', 'number', 'number', 'number']
+          ),
+          ndjsonParseBlocks: assembly.cwrap(
+            'emscripten_ndjson_parse_blocks',
+            'number',
+            ['number', 'number', 'number', 'number', 'number', 'number']
+          ),
+          heap: assembly.HEAPU8,
+          preimagePointer: assembly._malloc(STATE_BLOCK_PREIMAGE_LENGTH),
+          hashPointer: assembly._malloc(STATE_BLOCK_HASH_LENGTH),
+          batchPointer: assembly._malloc(BATCH_BUFFER_LENGTH),
         }) as AssemblyWhenLoaded
 
         resolve(loaded)
-      })
+      }
+
+      // the SIMD build uses the SSE implementation of BLAKE2b, and the
+      // scalar build interleaves nonces in its work kernel instead. The SIMD
+      // module is a separate asset, fetched only by runtimes supporting SIMD:
+      // when it cannot be fetched, the scalar module, inlined, is loaded
+      /* eslint-disable promise/catch-or-return, promise/always-return */
+      if (supportsSimd()) {
+        loadSimdAssembly().then(onLoad, () => {
+          loadScalarAssembly().then(onLoad)
+        })
+      } else {
+        loadScalarAssembly().then(onLoad)
+      }
       /* eslint-enable promise/catch-or-return, promise/always-return */
     } catch (err) {
       reject(err)
@@ -56,6 +362,21 @@ function loadWasm(): Promise<AssemblyWhenLoaded> {
   })
 }
 
+/** Count of nonces scanned by a single call into WebAssembly. */
+const WORK_CHUNK_SIZE = 0x40000
+
+/** Work computation progress. */
+export interface WorkProgress {
+  /** The count of nonces scanned so far by this worker */
+  noncesScanned: number
+  /** The time elapsed since the computation started, in milliseconds */
+  elapsedTime: number
+  /** The hashrate since the previous report, in nonces per second */
+  hashrate: number
+  /** The highest work value seen so far, in hexadecimal format */
+  bestDifficulty: string
+}
+
 /** Compute work parameters. */
 export interface ComputeWorkParams {
   /** The current worker index, starting at 0 */
@@ -64,6 +385,16 @@ export interface ComputeWorkParams {
   workerCount?: number
   /** The work threshold, in hex format. Defaults to `ffffffc000000000` */
   workThreshold?: string
+  /** Called periodically while scanning, and once when the computation ends */
+  onProgress?: (progress: WorkProgress) => void
+  /** The minimum time between two progress reports, in milliseconds. Defaults to `1000` */
+  progressInterval?: number
+  /**
+   * Checked between two chunks of nonces, the event loop running in between
+   * so that a message can cancel the computation. The computation returns
+   * `null` once it returns `true`
+   */
+  isCancelled?: () => boolean
 }
 
 /**
@@ -82,6 +413,9 @@ export async function computeWork(
     workerIndex = 0,
     workerCount = 1,
     workThreshold = DEFAULT_WORK_THRESHOLD,
+    onProgress,
+    progressInterval = 1000,
+    isCancelled,
   } = params
 
   const assembly = await loadWasm()
@@ -97,13 +431,583 @@ export async function computeWork(
   ) {
     throw new Error('Worker parameters are not valid')
   }
+  if (typeof progressInterval !== 'number' || !(progressInterval >= 0)) {
+    throw new Error('Progress interval is not valid')
+  }
+
+  const startTime = Date.now()
+  let lastReportTime = startTime
+  let lastReportNonces = 0
+  let noncesScanned = 0
+  let bestDifficulty = '0000000000000000'
+
+  for (;;) {
+    // flag (2) + work (16) + best work value (16) + nonces scanned (8)
+    const chunk = assembly.workChunk(
+      blockHash,
+      workThreshold,
+      workerIndex,
+      workerCount,
+      noncesScanned,
+      WORK_CHUNK_SIZE
+    )
+    const success = chunk[1] === '1'
+    const chunkBestDifficulty = chunk.substr(18, 16)
+    const chunkNoncesScanned = parseInt(chunk.substr(34, 8), 16)
+    // the range of this worker is exhausted
+    const exhausted = !success && chunkNoncesScanned < WORK_CHUNK_SIZE
+
+    noncesScanned += chunkNoncesScanned
+    if (chunkBestDifficulty > bestDifficulty) {
+      bestDifficulty = chunkBestDifficulty
+    }
+
+    if (onProgress) {
+      const now = Date.now()
+      if (success || exhausted || now - lastReportTime >= progressInterval) {
+        const sinceLastReport = Math.max(now - lastReportTime, 1)
+        onProgress({
+          noncesScanned,
+          elapsedTime: now - startTime,
+          hashrate:
+            ((noncesScanned - lastReportNonces) * 1000) / sinceLastReport,
+          bestDifficulty,
+        })
+        lastReportTime = now
+        lastReportNonces = noncesScanned
+      }
+    }
+
+    if (success) return chunk.substr(2, 16)
+    if (exhausted) return null
+
+    if (isCancelled) {
+      await new Promise(resolve => setTimeout(resolve, 0))
+      if (isCancelled()) return null
+    }
+  }
+}
+
+function hashPreimage(
+  assembly: AssemblyWhenLoaded,
+  preimage: Uint8Array
+): Uint8Array {
+  assembly.heap.set(preimage, assembly.preimagePointer)
+  assembly.blockHash(assembly.preimagePointer, assembly.hashPointer)
+
+  return assembly.heap.slice(
+    assembly.hashPointer,
+    assembly.hashPointer + STATE_BLOCK_HASH_LENGTH
+  )
+}
+
+/**
+ * Hash a state block preimage with WebAssembly, or return null if the
+ * WebAssembly module is not loaded yet.
+ *
+ * @hidden
+ */
+export function unsafeHashBlockPreimage(
+  preimage: Uint8Array
+): Uint8Array | null {
+  if (!ASSEMBLY.loaded) return null
+
+  return hashPreimage(ASSEMBLY, preimage)
+}
+
+/**
+ * Hash a packed state block preimage, as created by [[createBlockPreimage]].
+ * Require WebAssembly support.
+ *
+ * Once the WebAssembly module is loaded, [[hashBlock]] and [[createBlock]]
+ * also use it.
+ *
+ * @param preimage - The 176 bytes preimage
+ * @returns Hash, as 32 bytes
+ */
+export async function hashBlockPreimage(
+  preimage: Uint8Array
+): Promise<Uint8Array> {
+  const assembly = await loadWasm()
+
+  if (
+    !(preimage instanceof Uint8Array) ||
+    preimage.length !== STATE_BLOCK_PREIMAGE_LENGTH
+  ) {
+    throw new Error('Preimage is not valid')
+  }
 
-  const work = assembly.work(blockHash, workThreshold, workerIndex, workerCount)
-  const success = work[1] === '1'
+  return hashPreimage(assembly, preimage)
+}
+
+/** State blocks, as one array per field, each block at the same index. */
+export interface BlockColumns {
+  /** The account public keys, 32 bytes each */
+  accounts: Uint8Array
+  /** The previous block hashes, 32 bytes each, zeroes for `open` blocks */
+  previous: Uint8Array
+  /** The representative public keys, 32 bytes each */
+  representatives: Uint8Array
+  /** The balances in raw, 16 bytes each, big endian */
+  balances: Uint8Array
+  /** The links, 32 bytes each */
+  links: Uint8Array
+}
 
-  if (!success) {
-    return null
+/** Hash blocks parameters. */
+export interface HashBlocksParams {
+  /** The current worker index, starting at 0 */
+  workerIndex?: number
+  /** The count of worker */
+  workerCount?: number
+  /** The buffer to write the 32 bytes hashes to, at the index of each block. Defaults to a new buffer */
+  hashes?: Uint8Array
+}
+
+function countBlocks(blocks: Uint8Array | BlockColumns): number {
+  if (blocks instanceof Uint8Array) {
+    if (blocks.length % STATE_BLOCK_PREIMAGE_LENGTH !== 0) return -1
+    return blocks.length / STATE_BLOCK_PREIMAGE_LENGTH
   }
 
-  return work.substr(2)
+  if (typeof blocks !== 'object' || blocks === null) return -1
+
+  let count = -1
+  for (const [field, size] of BLOCK_COLUMNS) {
+    const column = blocks[field]
+    if (!(column instanceof Uint8Array) || column.length % size !== 0) {
+      return -1
+    }
+    if (count === -1) count = column.length / size
+    else if (column.length / size !== count) return -1
+  }
+
+  return count
+}
+
+/**
+ * Check the parameters of a bulk hashing, and select the blocks of the
+ * current worker.
+ */
+function prepareBatch(
+  count: number,
+  params: HashBlocksParams
+): { hashes: Uint8Array; start: number; end: number } {
+  const { workerIndex = 0, workerCount = 1 } = params
+
+  if (
+    !Number.isInteger(workerIndex) ||
+    !Number.isInteger(workerCount) ||
+    workerIndex < 0 ||
+    workerCount < 1 ||
+    workerIndex > workerCount - 1
+  ) {
+    throw new Error('Worker parameters are not valid')
+  }
+
+  const hashes =
+    params.hashes ?? new Uint8Array(count * STATE_BLOCK_HASH_LENGTH)
+  if (
+    !(hashes instanceof Uint8Array) ||
+    hashes.length < count * STATE_BLOCK_HASH_LENGTH
+  ) {
+    throw new Error('Hashes are not valid')
+  }
+
+  return {
+    hashes,
+    start: Math.floor((count * workerIndex) / workerCount),
+    end: Math.floor((count * (workerIndex + 1)) / workerCount),
+  }
+}
+
+/**
+ * Hash state blocks in bulk, given either as 176 bytes preimages packed back
+ * to back (see [[createBlockPreimage]]), or as one array per field.
+ * Require WebAssembly support.
+ *
+ * The work can be spread across workers, each one hashing its own slice of
+ * the blocks: when the `hashes` buffer is backed by a `SharedArrayBuffer`,
+ * every worker writes to it directly.
+ *
+ * @param blocks - The blocks to hash
+ * @param params - Parameters
+ * @returns Hashes, as 32 bytes each, back to back
+ */
+export async function hashBlocks(
+  blocks: Uint8Array | BlockColumns,
+  params: HashBlocksParams = {}
+): Promise<Uint8Array> {
+  const assembly = await loadWasm()
+
+  const count = countBlocks(blocks)
+  if (count === -1) throw new Error('Blocks are not valid')
+  const { hashes, start, end } = prepareBatch(count, params)
+
+  const inputPointer = assembly.batchPointer
+  const outputPointer =
+    inputPointer + BLOCK_BATCH_SIZE * STATE_BLOCK_PREIMAGE_LENGTH
+
+  for (let offset = start; offset < end; offset += BLOCK_BATCH_SIZE) {
+    const batchCount = Math.min(BLOCK_BATCH_SIZE, end - offset)
+
+    if (blocks instanceof Uint8Array) {
+      assembly.heap.set(
+        blocks.subarray(
+          offset * STATE_BLOCK_PREIMAGE_LENGTH,
+          (offset + batchCount) * STATE_BLOCK_PREIMAGE_LENGTH
+        ),
+        inputPointer
+      )
+      assembly.blockHashBatch(inputPointer, batchCount, outputPointer)
+    } else {
+      // each column gets its own region of the batch buffer
+      const pointers: number[] = []
+      let columnPointer = inputPointer
+      for (const [field, size] of BLOCK_COLUMNS) {
+        assembly.heap.set(
+          blocks[field].subarray(offset * size, (offset + batchCount) * size),
+          columnPointer
+        )
+        pointers.push(columnPointer)
+        columnPointer += BLOCK_BATCH_SIZE * size
+      }
+
+      assembly.blockHashColumns(
+        pointers[0],
+        pointers[1],
+        pointers[2],
+        pointers[3],
+        pointers[4],
+        batchCount,
+        outputPointer
+      )
+    }
+
+    hashes.set(
+      assembly.heap.subarray(
+        outputPointer,
+        outputPointer + batchCount * STATE_BLOCK_HASH_LENGTH
+      ),
+      offset * STATE_BLOCK_HASH_LENGTH
+    )
+  }
+
+  return hashes
+}
+
+/**
+ * Compress the first 128 bytes of a state block preimage (preamble,
+ * account, previous and representative) once, so that blocks only
+ * differing by their balance and link can be hashed from there with
+ * [[hashBlockSuffixes]], at half the cost.
+ * Require WebAssembly support.
+ *
+ * @param preimage - A preimage (see [[createBlockPreimage]]), of which only the first 128 bytes are used
+ * @returns Midstate, as 64 bytes
+ */
+export async function createBlockMidstate(
+  preimage: Uint8Array
+): Promise<Uint8Array> {
+  const assembly = await loadWasm()
+
+  if (
+    !(preimage instanceof Uint8Array) ||
+    preimage.length < STATE_BLOCK_PREFIX_LENGTH
+  ) {
+    throw new Error('Preimage is not valid')
+  }
+
+  const prefixPointer = assembly.batchPointer
+  const midstatePointer = prefixPointer + STATE_BLOCK_PREFIX_LENGTH
+  assembly.heap.set(
+    preimage.subarray(0, STATE_BLOCK_PREFIX_LENGTH),
+    prefixPointer
+  )
+  assembly.blockMidstate(prefixPointer, midstatePointer)
+
+  return assembly.heap.slice(
+    midstatePointer,
+    midstatePointer + STATE_BLOCK_MIDSTATE_LENGTH
+  )
+}
+
+/**
+ * Hash state blocks sharing the prefix of a midstate, given as their last
+ * 48 bytes packed back to back: balance (16 bytes, big endian) and link.
+ * Require WebAssembly support.
+ *
+ * @param midstate - The midstate, from [[createBlockMidstate]]
+ * @param suffixes - The suffixes to hash
+ * @param params - Parameters, as for [[hashBlocks]]
+ * @returns Hashes, as 32 bytes each, back to back
+ */
+export async function hashBlockSuffixes(
+  midstate: Uint8Array,
+  suffixes: Uint8Array,
+  params: HashBlocksParams = {}
+): Promise<Uint8Array> {
+  const assembly = await loadWasm()
+
+  if (
+    !(midstate instanceof Uint8Array) ||
+    midstate.length !== STATE_BLOCK_MIDSTATE_LENGTH
+  ) {
+    throw new Error('Midstate is not valid')
+  }
+  if (
+    !(suffixes instanceof Uint8Array) ||
+    suffixes.length % STATE_BLOCK_SUFFIX_LENGTH !== 0
+  ) {
+    throw new Error('Suffixes are not valid')
+  }
+  const count = suffixes.length / STATE_BLOCK_SUFFIX_LENGTH
+  const { hashes, start, end } = prepareBatch(count, params)
+
+  // the midstate, then the suffixes, then their hashes
+  const midstatePointer = assembly.batchPointer
+  const inputPointer = midstatePointer + STATE_BLOCK_MIDSTATE_LENGTH
+  const outputPointer =
+    assembly.batchPointer + BLOCK_BATCH_SIZE * STATE_BLOCK_PREIMAGE_LENGTH
+  assembly.heap.set(midstate, midstatePointer)
+
+  for (let offset = start; offset < end; offset += BLOCK_BATCH_SIZE) {
+    const batchCount = Math.min(BLOCK_BATCH_SIZE, end - offset)
+
+    assembly.heap.set(
+      suffixes.subarray(
+        offset * STATE_BLOCK_SUFFIX_LENGTH,
+        (offset + batchCount) * STATE_BLOCK_SUFFIX_LENGTH
+      ),
+      inputPointer
+    )
+    assembly.blockHashSuffixes(
+      midstatePointer,
+      inputPointer,
+      batchCount,
+      outputPointer
+    )
+
+    hashes.set(
+      assembly.heap.subarray(
+        outputPointer,
+        outputPointer + batchCount * STATE_BLOCK_HASH_LENGTH
+      ),
+      offset * STATE_BLOCK_HASH_LENGTH
+    )
+  }
+
+  return hashes
+}
+
+/**
+ * Hash many independent messages with BLAKE2b, side by side in the SIMD
+ * lanes of WebAssembly, such as public keys for their address checksum.
+ * Require WebAssembly support.
+ *
+ * @param messages - The messages to hash
+ * @param outputLength - The length of every hash, between 1 and 64 bytes
+ * @returns Hashes, in the order of the messages
+ */
+export async function blake2bMulti(
+  messages: Uint8Array[],
+  outputLength: number
+): Promise<Uint8Array[]> {
+  const assembly = await loadWasm()
+
+  if (
+    !Array.isArray(messages) ||
+    !messages.every(message => message instanceof Uint8Array)
+  ) {
+    throw new Error('Messages are not valid')
+  }
+  if (
+    !Number.isInteger(outputLength) ||
+    outputLength < 1 ||
+    outputLength > 64
+  ) {
+    throw new Error('Output length is not valid')
+  }
+
+  const hashes: Uint8Array[] = []
+  let first = 0
+  while (first < messages.length) {
+    // as many messages as the batch buffer holds, along with their pointer,
+    // length and hash
+    let end = first
+    let size = 0
+    while (end < messages.length) {
+      const nextSize = size + 8 + outputLength + messages[end].length
+      if (nextSize > BATCH_BUFFER_LENGTH) break
+      size = nextSize
+      end++
+    }
+
+    if (end === first) {
+      hashes.push(blake2b(messages[first], null, outputLength))
+      first++
+      continue
+    }
+
+    const count = end - first
+    const pointersPointer = assembly.batchPointer
+    const lengthsPointer = pointersPointer + 4 * count
+    const hashesPointer = lengthsPointer + 4 * count
+    const { buffer } = assembly.heap
+    const pointers = new Uint32Array(buffer, pointersPointer, count)
+    const lengths = new Uint32Array(buffer, lengthsPointer, count)
+
+    let messagePointer = hashesPointer + count * outputLength
+    for (let i = 0; i < count; i++) {
+      const message = messages[first + i]
+      assembly.heap.set(message, messagePointer)
+      pointers[i] = messagePointer
+      lengths[i] = message.length
+      messagePointer += message.length
+    }
+
+    assembly.blake2bMulti(
+      hashesPointer,
+      outputLength,
+      pointersPointer,
+      lengthsPointer,
+      count
+    )
+
+    for (let i = 0; i < count; i++) {
+      const hashPointer = hashesPointer + i * outputLength
+      hashes.push(assembly.heap.slice(hashPointer, hashPointer + outputLength))
+    }
+
+    first = end
+  }
+
+  return hashes
+}
+
+/** Block parser parameters. */
+export interface BlockParserParams {
+  /**
+   * Called with the offset in the stream of every line that is not a valid
+   * block, the line being skipped. Defaults to throwing on the first one
+   */
+  onInvalidLine?: (offset: number) => void
+}
+
+/** Streaming parse of JSON blocks, see [[createBlockParser]]. */
+export interface BlockParser {
+  /**
+   * Parse the complete lines fed so far, keeping the last incomplete one for
+   * the next chunk.
+   *
+   * @param chunk - UTF-8 JSON blocks, one per line, split anywhere
+   * @returns Encoded blocks, see [[encodeBlock]], back to back
+   */
+  update(chunk: Uint8Array): Uint8Array
+  /**
+   * Parse the last line, even without a trailing newline.
+   *
+   * @returns Encoded blocks, back to back
+   */
+  finish(): Uint8Array
+}
+
+/**
+ * Create a parser of state blocks written as JSON, one per line, as in a
+ * ledger export. The lines are decoded in WebAssembly memory straight into
+ * encoded blocks, ready for [[verifyBlocks]] or a ledger verifier, without
+ * creating an object per block.
+ *
+ * A line is either a block, as given to [[hashBlock]], or any object holding
+ * one, such as `{ "hash", "block" }`. An invalid line throws an error giving
+ * its offset in the stream, unless it is skipped through `onInvalidLine`.
+ * Require WebAssembly support.
+ *
+ * @param params - Parameters
+ * @returns Parser
+ */
+export async function createBlockParser(
+  params: BlockParserParams = {}
+): Promise<BlockParser> {
+  const { onInvalidLine } = params
+  const assembly = await loadWasm()
+
+  // the consumed length and the count of blocks, the window, then the blocks
+  const resultPointer = assembly.batchPointer
+  const windowPointer = resultPointer + NDJSON_RESULT_LENGTH
+  const blocksPointer = windowPointer + NDJSON_WINDOW_LENGTH
+  let remainder = new Uint8Array(0)
+  // the offset of the remainder in the stream
+  let streamOffset = 0
+  // within an invalid line too long to be held, skipped up to its newline
+  let skipping = false
+
+  const parse = (chunk: Uint8Array, last: boolean): Uint8Array => {
+    if (!(chunk instanceof Uint8Array)) {
+      throw new Error('Chunk is not valid')
+    }
+
+    const input =
+      remainder.length === 0 ? chunk : concatArrays([remainder, chunk])
+    const blocks: Uint8Array[] = []
+    let offset = 0
+    if (skipping) {
+      const newline = input.indexOf(NEWLINE)
+      skipping = newline === -1 && !last
+      offset = newline === -1 ? input.length : newline + 1
+    }
+
+    while (offset < input.length) {
+      const length = Math.min(NDJSON_WINDOW_LENGTH, input.length - offset)
+      assembly.heap.set(input.subarray(offset, offset + length), windowPointer)
+
+      const ret = assembly.ndjsonParseBlocks(
+        windowPointer,
+        length,
+        last && offset + length === input.length ? 1 : 0,
+        blocksPointer,
+        NDJSON_BLOCK_CAPACITY,
+        resultPointer
+      )
+      // on an invalid line, the offset of the line and the blocks before it
+      const result = new Uint32Array(assembly.heap.buffer, resultPointer, 2)
+      const consumed = result[0]
+      const count = result[1]
+
+      blocks.push(
+        assembly.heap.slice(
+          blocksPointer,
+          blocksPointer + count * ENCODED_BLOCK_LENGTH
+        )
+      )
+
+      // a line longer than the window cannot be a block either
+      if (ret !== 0 || (consumed === 0 && length === NDJSON_WINDOW_LENGTH)) {
+        const lineOffset = offset + consumed
+        if (!onInvalidLine) {
+          throw new Error(
+            `Block is not valid at offset ${streamOffset + lineOffset}`
+          )
+        }
+        onInvalidLine(streamOffset + lineOffset)
+
+        const newline = input.indexOf(NEWLINE, lineOffset)
+        skipping = newline === -1 && !last
+        offset = newline === -1 ? input.length : newline + 1
+        continue
+      }
+      if (consumed === 0) break
+      offset += consumed
+    }
+
+    streamOffset += offset
+    remainder = input.slice(offset)
+
+    return concatArrays(blocks)
+  }
+
+  return {
+    update: chunk => parse(chunk, false),
+    finish: () => parse(new Uint8Array(0), true),
+  }
 }
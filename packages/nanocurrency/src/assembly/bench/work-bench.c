@@ -0,0 +1,111 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../blake2b-multi.h"
+#include "../native/dispatch.h"
+#include "../utils.h"
+#include "../work.h"
+
+#define NONCE_COUNT (1 << 22)
+
+/* address checksums: 32 bytes public keys hashed to 5 bytes */
+#define MESSAGE_COUNT (1 << 20)
+#define MESSAGE_LENGTH 32
+#define MESSAGE_BATCH 64
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/* The loop computeWork used to run: one nonce at a time through validate_work. */
+static uint64_t scan_validate_work(const uint8_t* const block_hash, const uint64_t work_threshold, const uint64_t start, const uint64_t end) {
+  uint8_t work_bytes[WORK_LENGTH];
+
+  for (uint64_t work = start; work != end; work++) {
+    uint64_to_bytes(work, work_bytes);
+    if (validate_work(block_hash, work_threshold, work_bytes)) return work;
+  }
+
+  return end;
+}
+
+static uint64_t scan_work_chunk(const uint8_t* const block_hash, const uint64_t work_threshold, const uint64_t start, const uint64_t end) {
+  uint8_t result[WORK_CHUNK_RESULT_LENGTH];
+  work_chunk(block_hash, work_threshold, start, end, result);
+
+  if (!result[0]) return end;
+
+  reverse_bytes(result + 1, WORK_LENGTH);
+  return bytes_to_uint64(result + 1);
+}
+
+int main(void) {
+  uint8_t block_hash[BLOCK_HASH_LENGTH];
+  hex_to_bytes("b9cb6b51b8eb869af085c4c03e7dc539943d0bdde13b21436b687c9c7ea56cb0", block_hash);
+
+  /* both kernels must find the same first nonce */
+  for (uint64_t start = 0; start < 64; start++) {
+    const uint64_t threshold = 0xff00000000000000ULL;
+    const uint64_t expected = scan_validate_work(block_hash, threshold, start, start + 100000);
+    const uint64_t actual = scan_work_chunk(block_hash, threshold, start, start + 100000);
+    if (expected != actual) {
+      printf("mismatch from %llu: %llu != %llu\n", (unsigned long long) start, (unsigned long long) expected, (unsigned long long) actual);
+      return 1;
+    }
+  }
+
+  /* unreachable threshold, so that every nonce is scanned */
+  const uint64_t threshold = 0xffffffffffffffffULL;
+
+  double begin = now();
+  scan_validate_work(block_hash, threshold, 0, NONCE_COUNT);
+  const double validate_work_time = now() - begin;
+
+  begin = now();
+  scan_work_chunk(block_hash, threshold, 0, NONCE_COUNT);
+  const double work_chunk_time = now() - begin;
+
+  printf("BLAKE2b variant: %s\n", blake2b_variant_name());
+  printf("validate_work loop: %.2f MH/s\n", NONCE_COUNT / validate_work_time / 1e6);
+  printf("work_chunk kernel: %.2f MH/s (x%.2f)\n", NONCE_COUNT / work_chunk_time / 1e6, validate_work_time / work_chunk_time);
+
+  static uint8_t messages[MESSAGE_BATCH][MESSAGE_LENGTH];
+  const uint8_t* in[MESSAGE_BATCH];
+  size_t inlen[MESSAGE_BATCH];
+  uint8_t out[MESSAGE_BATCH * 5];
+  for (unsigned int i = 0; i < MESSAGE_BATCH; i++) {
+    memset(messages[i], (int) i, MESSAGE_LENGTH);
+    in[i] = messages[i];
+    inlen[i] = MESSAGE_LENGTH;
+  }
+
+  begin = now();
+  for (unsigned int i = 0; i < MESSAGE_COUNT; i++) {
+    blake2b(out, 5, in[i % MESSAGE_BATCH], MESSAGE_LENGTH, NULL, 0);
+  }
+  const double blake2b_time = now() - begin;
+
+  begin = now();
+  for (unsigned int i = 0; i < MESSAGE_COUNT; i += MESSAGE_BATCH) {
+    blake2b_multi(out, 5, in, inlen, MESSAGE_BATCH);
+  }
+  const double blake2b_multi_time = now() - begin;
+
+  printf("blake2b loop: %.2f MH/s\n", MESSAGE_COUNT / blake2b_time / 1e6);
+  printf("blake2b_multi, %u lanes: %.2f MH/s (x%.2f)\n", blake2b_multi_lanes(), MESSAGE_COUNT / blake2b_multi_time / 1e6, blake2b_time / blake2b_multi_time);
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2b-multi.h"
+#include "compress.h"
+#include "utils.h"
+
+/*
+  Each state word is a vector holding that word for every message of the
+  pass, so that the G function runs unchanged, one lane per message.
+  Lanes whose message has no more blocks keep their state through a mask.
+*/
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#define MULTI_LANES 4
+typedef __m256i multi_word;
+
+#define MULTI_ADD(a, b) _mm256_add_epi64((a), (b))
+#define MULTI_XOR(a, b) _mm256_xor_si256((a), (b))
+#define MULTI_ROTR(x, c)                                                                   \
+  ((c) == 32 ? _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))                          \
+  : (c) == 24 ? _mm256_shuffle_epi8((x), r24)                                              \
+  : (c) == 16 ? _mm256_shuffle_epi8((x), r16)                                              \
+  : _mm256_xor_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x))))
+#define MULTI_LOAD(p) _mm256_loadu_si256((const __m256i*) (p))
+#define MULTI_STORE(p, w) _mm256_storeu_si256((__m256i*) (p), (w))
+#define MULTI_SET1(w) _mm256_set1_epi64x((long long) (w))
+#define MULTI_SELECT(mask, a, b) _mm256_blendv_epi8((b), (a), (mask))
+#define MULTI_ROTATIONS                                                                    \
+  const __m256i r16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+                                       2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9); \
+  const __m256i r24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+                                       3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10)
+#elif defined(__SSE2__)
+/* SSE2 to SSE4.1, or wasm SIMD through emscripten's SSE headers */
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#include "blake2/sse/blake2-config.h"
+#include "blake2/sse/blake2b-round.h"
+
+#define MULTI_LANES 2
+typedef __m128i multi_word;
+
+#define MULTI_ADD(a, b) _mm_add_epi64((a), (b))
+#define MULTI_XOR(a, b) _mm_xor_si128((a), (b))
+#define MULTI_ROTR(x, c) _mm_roti_epi64((x), -(c))
+#define MULTI_LOAD(p) LOADU(p)
+#define MULTI_STORE(p, w) STOREU((p), (w))
+#define MULTI_SET1(w) _mm_set1_epi64x((long long) (w))
+#define MULTI_SELECT(mask, a, b) _mm_or_si128(_mm_and_si128((mask), (a)), _mm_andnot_si128((mask), (b)))
+#if defined(HAVE_SSSE3)
+#define MULTI_ROTATIONS                                                                    \
+  const __m128i r16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9); \
+  const __m128i r24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10)
+#else
+#define MULTI_ROTATIONS
+#endif
+#else
+#define MULTI_LANES 1
+typedef uint64_t multi_word;
+
+#define MULTI_ADD(a, b) ((a) + (b))
+#define MULTI_XOR(a, b) ((a) ^ (b))
+#define MULTI_ROTR(x, c) ROTR64((x), (c))
+#define MULTI_LOAD(p) (*(p))
+#define MULTI_STORE(p, w) (*(p) = (w))
+#define MULTI_SET1(w) ((uint64_t) (w))
+#define MULTI_SELECT(mask, a, b) (((mask) & (a)) | (~(mask) & (b)))
+#define MULTI_ROTATIONS
+#endif
+
+#define MULTI_G(r, i, a, b, c, d)                                           \
+  do {                                                                      \
+    v[a] = MULTI_ADD(MULTI_ADD(v[a], v[b]), m[COMPRESS_SIGMA[r][2 * (i) + 0]]); \
+    v[d] = MULTI_ROTR(MULTI_XOR(v[d], v[a]), 32);                           \
+    v[c] = MULTI_ADD(v[c], v[d]);                                           \
+    v[b] = MULTI_ROTR(MULTI_XOR(v[b], v[c]), 24);                           \
+    v[a] = MULTI_ADD(MULTI_ADD(v[a], v[b]), m[COMPRESS_SIGMA[r][2 * (i) + 1]]); \
+    v[d] = MULTI_ROTR(MULTI_XOR(v[d], v[a]), 16);                           \
+    v[c] = MULTI_ADD(v[c], v[d]);                                           \
+    v[b] = MULTI_ROTR(MULTI_XOR(v[b], v[c]), 63);                           \
+  } while (0)
+
+#define MULTI_ROUND(r)                                                      \
+  do {                                                                      \
+    MULTI_G(r, 0, 0, 4,  8, 12);                                            \
+    MULTI_G(r, 1, 1, 5,  9, 13);                                            \
+    MULTI_G(r, 2, 2, 6, 10, 14);                                            \
+    MULTI_G(r, 3, 3, 7, 11, 15);                                            \
+    MULTI_G(r, 4, 0, 5, 10, 15);                                            \
+    MULTI_G(r, 5, 1, 6, 11, 12);                                            \
+    MULTI_G(r, 6, 2, 7,  8, 13);                                            \
+    MULTI_G(r, 7, 3, 4,  9, 14);                                            \
+  } while (0)
+
+/* one word per lane, so that a row loads as a vector */
+typedef struct {
+  uint64_t words[16][MULTI_LANES];
+  uint64_t counter[MULTI_LANES];
+  uint64_t last[MULTI_LANES];
+  uint64_t active[MULTI_LANES];
+} multi_block;
+
+static void multi_compress(multi_word* const h, const multi_block* const block) {
+  MULTI_ROTATIONS;
+
+  multi_word m[16];
+  for (unsigned int i = 0; i < 16; i++) m[i] = MULTI_LOAD(block->words[i]);
+
+  multi_word v[16];
+  for (unsigned int i = 0; i < 8; i++) {
+    v[i] = h[i];
+    v[8 + i] = MULTI_SET1(COMPRESS_IV[i]);
+  }
+  v[12] = MULTI_XOR(v[12], MULTI_LOAD(block->counter));
+  v[14] = MULTI_XOR(v[14], MULTI_LOAD(block->last));
+
+  MULTI_ROUND(0);
+  MULTI_ROUND(1);
+  MULTI_ROUND(2);
+  MULTI_ROUND(3);
+  MULTI_ROUND(4);
+  MULTI_ROUND(5);
+  MULTI_ROUND(6);
+  MULTI_ROUND(7);
+  MULTI_ROUND(8);
+  MULTI_ROUND(9);
+  MULTI_ROUND(10);
+  MULTI_ROUND(11);
+
+  const multi_word active = MULTI_LOAD(block->active);
+  for (unsigned int i = 0; i < 8; i++) {
+    const multi_word next = MULTI_XOR(h[i], MULTI_XOR(v[i], v[8 + i]));
+    h[i] = MULTI_SELECT(active, next, h[i]);
+  }
+}
+
+/* Hash up to MULTI_LANES messages, the missing lanes being left empty. */
+static void multi_pass(uint8_t* const out, const size_t outlen, const uint8_t* const* const in, const size_t* const inlen, const unsigned int lanes) {
+  size_t block_counts[MULTI_LANES];
+  size_t max_block_count = 0;
+  for (unsigned int lane = 0; lane < MULTI_LANES; lane++) {
+    /* an empty message still takes one (padding) block */
+    const size_t length = (lane < lanes) ? inlen[lane] : 0;
+    block_counts[lane] = (length == 0) ? 1 : (length + 127) / 128;
+    if (block_counts[lane] > max_block_count) max_block_count = block_counts[lane];
+  }
+
+  multi_word h[8];
+  for (unsigned int i = 0; i < 8; i++) h[i] = MULTI_SET1(COMPRESS_IV[i]);
+  h[0] = MULTI_SET1(COMPRESS_IV[0] ^ COMPRESS_PARAM(outlen));
+
+  for (size_t block_index = 0; block_index < max_block_count; block_index++) {
+    multi_block block;
+
+    for (unsigned int lane = 0; lane < MULTI_LANES; lane++) {
+      const size_t offset = block_index * 128;
+      size_t length = 0;
+
+      if (lane < lanes && block_index < block_counts[lane]) {
+        const size_t remaining = inlen[lane] - offset;
+        length = (remaining < 128) ? remaining : 128;
+
+        block.counter[lane] = offset + length;
+        block.last[lane] = (block_index == block_counts[lane] - 1) ? ~0ULL : 0;
+        block.active[lane] = ~0ULL;
+      } else {
+        block.counter[lane] = 0;
+        block.last[lane] = 0;
+        block.active[lane] = 0;
+      }
+
+      /* whole words straight from the message, then the zero padded tail */
+      const uint8_t* const src = (length > 0) ? in[lane] + offset : NULL;
+      const unsigned int word_count = (unsigned int) (length / 8);
+      for (unsigned int i = 0; i < word_count; i++) {
+        block.words[i][lane] = bytes_to_uint64(src + (8 * i));
+      }
+      if (word_count < 16) {
+        uint8_t tail[8] = { 0 };
+        if (length % 8 != 0) memcpy(tail, src + (8 * word_count), length % 8);
+        block.words[word_count][lane] = bytes_to_uint64(tail);
+        for (unsigned int i = word_count + 1; i < 16; i++) block.words[i][lane] = 0;
+      }
+    }
+
+    multi_compress(h, &block);
+  }
+
+  uint64_t words[8][MULTI_LANES];
+  for (unsigned int i = 0; i < 8; i++) MULTI_STORE(words[i], h[i]);
+
+  for (unsigned int lane = 0; lane < lanes; lane++) {
+    uint8_t digest[64];
+    for (unsigned int i = 0; i < 8; i++) uint64_to_bytes(words[i][lane], digest + (8 * i));
+    memcpy(out + (lane * outlen), digest, outlen);
+  }
+}
+
+int blake2b_multi(uint8_t* const out, const size_t outlen, const uint8_t* const* const in, const size_t* const inlen, const size_t count) {
+  if (outlen == 0 || outlen > 64) return -1;
+
+  for (size_t i = 0; i < count; i += MULTI_LANES) {
+    const unsigned int lanes = (count - i < MULTI_LANES) ? (unsigned int) (count - i) : MULTI_LANES;
+    multi_pass(out + (i * outlen), outlen, in + i, inlen + i, lanes);
+  }
+
+  return 0;
+}
+
+unsigned int blake2b_multi_lanes(void) {
+  return MULTI_LANES;
+}
@@ -0,0 +1,27 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_BLAKE2B_MULTI_H
+#define NANOCURRENCY_BLAKE2B_MULTI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Unkeyed BLAKE2b of count independent messages, all hashed to outlen
+  bytes and written back to back to out.
+
+  Messages are hashed side by side, one per SIMD lane: 4 per pass with
+  AVX2, 2 with SSE2 or wasm SIMD, and 1 otherwise. Best suited to many
+  short messages of similar lengths (keys, checksums, block hashes).
+
+  Returns 0, or -1 if outlen is not between 1 and 64.
+*/
+int blake2b_multi(uint8_t* const out, const size_t outlen, const uint8_t* const* const in, const size_t* const inlen, const size_t count);
+
+/* Count of messages hashed per pass by this build. */
+unsigned int blake2b_multi_lanes(void);
+
+#endif
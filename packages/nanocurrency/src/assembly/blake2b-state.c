@@ -0,0 +1,22 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2b-state.h"
+
+/* the state has no pointer, so a byte copy is a complete snapshot */
+void blake2b_state_snapshot(const blake2b_state* const S, uint8_t* const dst) {
+  memcpy(dst, S, BLAKE2B_STATE_LENGTH);
+}
+
+void blake2b_state_restore(blake2b_state* const S, const uint8_t* const src) {
+  memcpy(S, src, BLAKE2B_STATE_LENGTH);
+}
+
+void blake2b_state_copy(blake2b_state* const dst, const blake2b_state* const src) {
+  memcpy(dst, src, BLAKE2B_STATE_LENGTH);
+}
@@ -0,0 +1,29 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_BLAKE2B_STATE_H
+#define NANOCURRENCY_BLAKE2B_STATE_H
+
+#include <stdint.h>
+
+#include "blake2/ref/blake2.h"
+
+/*
+  Snapshot and restore of a BLAKE2b state, to hash many messages sharing a
+  prefix: feed the prefix once, snapshot, then restore the snapshot before
+  feeding each suffix.
+
+  The ref and SSE implementations share the same blake2b_state, so a
+  snapshot can be restored into a state used with either of them.
+*/
+#define BLAKE2B_STATE_LENGTH sizeof(blake2b_state)
+
+void blake2b_state_snapshot(const blake2b_state* const S, uint8_t* const dst);
+void blake2b_state_restore(blake2b_state* const S, const uint8_t* const src);
+
+/* Fork a state: dst continues from everything fed to src so far. */
+void blake2b_state_copy(blake2b_state* const dst, const blake2b_state* const src);
+
+#endif
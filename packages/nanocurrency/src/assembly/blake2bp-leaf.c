@@ -0,0 +1,77 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2/ref/blake2.h"
+#include "blake2/ref/blake2-impl.h"
+
+#include "blake2bp-leaf.h"
+
+/* same parameter block as blake2bp_init_leaf and blake2bp_init_root */
+static void blake2bp_param(blake2b_param* const P, const size_t outlen, const size_t keylen, const size_t offset, const uint8_t depth) {
+  P->digest_length = (uint8_t) outlen;
+  P->key_length = (uint8_t) keylen;
+  P->fanout = BLAKE2BP_LEAVES;
+  P->depth = 2;
+  store32(&P->leaf_length, 0);
+  store32(&P->node_offset, (uint32_t) offset);
+  store32(&P->xof_length, 0);
+  P->node_depth = depth;
+  P->inner_length = BLAKE2B_OUTBYTES;
+  memset(P->reserved, 0, sizeof(P->reserved));
+  memset(P->salt, 0, sizeof(P->salt));
+  memset(P->personal, 0, sizeof(P->personal));
+}
+
+int blake2bp_leaf_init(blake2b_state* const S, const size_t outlen, const size_t index, const void* const key, const size_t keylen) {
+  if (outlen == 0 || outlen > BLAKE2B_OUTBYTES || index >= BLAKE2BP_LEAVES || keylen > BLAKE2B_KEYBYTES) return -1;
+
+  blake2b_param P;
+  blake2bp_param(&P, outlen, keylen, index, 0);
+  if (blake2b_init_param(S, &P) < 0) return -1;
+
+  /* leaves output inner_length bytes, whatever the final length */
+  S->outlen = BLAKE2B_OUTBYTES;
+  S->last_node = (index == BLAKE2BP_LEAVES - 1);
+
+  if (keylen > 0) {
+    uint8_t block[BLAKE2B_BLOCKBYTES];
+    memset(block, 0, BLAKE2B_BLOCKBYTES);
+    memcpy(block, key, keylen);
+    blake2b_update(S, block, BLAKE2B_BLOCKBYTES);
+    secure_zero_memory(block, BLAKE2B_BLOCKBYTES);
+  }
+
+  return 0;
+}
+
+void blake2bp_leaf_update(blake2b_state* const S, const size_t index, const uint8_t* const in, const size_t inlen) {
+  for (size_t offset = index * BLAKE2B_BLOCKBYTES; offset < inlen; offset += BLAKE2BP_STRIPE_LENGTH) {
+    const size_t left = inlen - offset;
+    blake2b_update(S, in + offset, (left < BLAKE2B_BLOCKBYTES) ? left : BLAKE2B_BLOCKBYTES);
+  }
+}
+
+int blake2bp_leaf_final(blake2b_state* const S, uint8_t* const dst) {
+  return blake2b_final(S, dst, BLAKE2B_OUTBYTES);
+}
+
+int blake2bp_root(uint8_t* const out, const size_t outlen, const size_t keylen, const uint8_t* const leaf_hashes) {
+  if (outlen == 0 || outlen > BLAKE2B_OUTBYTES || keylen > BLAKE2B_KEYBYTES) return -1;
+
+  blake2b_param P;
+  blake2bp_param(&P, outlen, keylen, 0, 1);
+
+  blake2b_state S;
+  if (blake2b_init_param(&S, &P) < 0) return -1;
+  S.last_node = 1;
+
+  blake2b_update(&S, leaf_hashes, BLAKE2BP_LEAVES * BLAKE2B_OUTBYTES);
+
+  return blake2b_final(&S, out, outlen);
+}
@@ -0,0 +1,40 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_BLAKE2BP_LEAF_H
+#define NANOCURRENCY_BLAKE2BP_LEAF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "blake2/ref/blake2.h"
+
+/*
+  BLAKE2bp split into its four leaves, so that each one can be hashed on
+  its own thread: a leaf hashes every fourth 128 bytes block of the
+  message, and the root hashes the four leaf hashes.
+
+  Gives the same hashes as the vendored blake2bp.
+*/
+#define BLAKE2BP_LEAVES 4
+#define BLAKE2BP_STRIPE_LENGTH (BLAKE2BP_LEAVES * BLAKE2B_BLOCKBYTES)
+
+/* Leaf index of a hash to outlen bytes, with an optional key (keylen 0 otherwise). */
+int blake2bp_leaf_init(blake2b_state* const S, const size_t outlen, const size_t index, const void* const key, const size_t keylen);
+
+/*
+  Feed the leaf index with its blocks from a part of the message, which
+  must start at a multiple of BLAKE2BP_STRIPE_LENGTH. Only the last part
+  of the message can have another length.
+*/
+void blake2bp_leaf_update(blake2b_state* const S, const size_t index, const uint8_t* const in, const size_t inlen);
+
+/* Hash of the leaf, BLAKE2B_OUTBYTES long. */
+int blake2bp_leaf_final(blake2b_state* const S, uint8_t* const dst);
+
+/* Final hash, from the BLAKE2BP_LEAVES leaf hashes back to back. */
+int blake2bp_root(uint8_t* const out, const size_t outlen, const size_t keylen, const uint8_t* const leaf_hashes);
+
+#endif
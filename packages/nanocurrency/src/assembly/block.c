@@ -0,0 +1,124 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "block.h"
+#include "compress.h"
+#include "utils.h"
+
+/*
+  The 176 bytes preimage always spans exactly two BLAKE2b blocks: a full
+  one (preamble, account, previous, representative), then the balance and
+  the link, zero padded. Both compressions are unrolled with their counter
+  and last block flag known at compile time, and without any buffering.
+*/
+static void block_compress(uint64_t* const h, const uint64_t* const m, const uint64_t counter, const uint8_t last) {
+  uint64_t v[16];
+  for (unsigned int i = 0; i < 8; i++) {
+    v[i] = h[i];
+    v[8 + i] = COMPRESS_IV[i];
+  }
+  v[12] ^= counter;
+  if (last) v[14] = ~v[14];
+
+  COMPRESS_ROUND(0);
+  COMPRESS_ROUND(1);
+  COMPRESS_ROUND(2);
+  COMPRESS_ROUND(3);
+  COMPRESS_ROUND(4);
+  COMPRESS_ROUND(5);
+  COMPRESS_ROUND(6);
+  COMPRESS_ROUND(7);
+  COMPRESS_ROUND(8);
+  COMPRESS_ROUND(9);
+  COMPRESS_ROUND(10);
+  COMPRESS_ROUND(11);
+
+  for (unsigned int i = 0; i < 8; i++) h[i] ^= v[i] ^ v[8 + i];
+}
+
+static void block_midstate_words(const uint64_t* const first, uint64_t* const h) {
+  memcpy(h, COMPRESS_IV, 8 * sizeof(uint64_t));
+  h[0] ^= COMPRESS_PARAM(STATE_BLOCK_HASH_LENGTH);
+
+  block_compress(h, first, STATE_BLOCK_PREFIX_LENGTH, 0);
+}
+
+static void block_final_words(uint64_t* const h, const uint64_t* const second, uint8_t* const dst) {
+  block_compress(h, second, STATE_BLOCK_PREIMAGE_LENGTH, 1);
+
+  for (unsigned int i = 0; i < 4; i++) uint64_to_bytes(h[i], dst + (8 * i));
+}
+
+static void block_hash_words(const uint64_t* const first, const uint64_t* const second, uint8_t* const dst) {
+  uint64_t h[8];
+  block_midstate_words(first, h);
+  block_final_words(h, second, dst);
+}
+
+static void load_words(const uint8_t* const src, const unsigned int count, uint64_t* const dst) {
+  for (unsigned int i = 0; i < count; i++) dst[i] = bytes_to_uint64(src + (8 * i));
+}
+
+void block_hash(const uint8_t* const preimage, uint8_t* const dst) {
+  uint64_t first[16];
+  load_words(preimage, 16, first);
+
+  uint64_t second[16] = { 0 };
+  load_words(preimage + 128, 6, second);
+
+  block_hash_words(first, second, dst);
+}
+
+void block_hash_batch(const uint8_t* const preimages, const uint32_t count, uint8_t* const dst) {
+  for (uint32_t i = 0; i < count; i++) {
+    block_hash(preimages + ((size_t) i * STATE_BLOCK_PREIMAGE_LENGTH), dst + ((size_t) i * STATE_BLOCK_HASH_LENGTH));
+  }
+}
+
+void block_hash_columns(const uint8_t* const accounts, const uint8_t* const previous, const uint8_t* const representatives, const uint8_t* const balances, const uint8_t* const links, const uint32_t count, uint8_t* const dst) {
+  /* the preamble is the big endian block type, 6 for state blocks */
+  uint64_t first[16] = { 0, 0, 0, 0x0600000000000000ULL };
+  uint64_t second[16] = { 0 };
+
+  for (uint32_t i = 0; i < count; i++) {
+    const size_t offset = (size_t) i * 32;
+
+    load_words(accounts + offset, 4, first + 4);
+    load_words(previous + offset, 4, first + 8);
+    load_words(representatives + offset, 4, first + 12);
+    load_words(balances + ((size_t) i * STATE_BLOCK_BALANCE_LENGTH), 2, second);
+    load_words(links + offset, 4, second + 2);
+
+    block_hash_words(first, second, dst + ((size_t) i * STATE_BLOCK_HASH_LENGTH));
+  }
+}
+
+void block_midstate(const uint8_t* const prefix, uint8_t* const dst) {
+  uint64_t first[16];
+  load_words(prefix, 16, first);
+
+  uint64_t h[8];
+  block_midstate_words(first, h);
+
+  for (unsigned int i = 0; i < 8; i++) uint64_to_bytes(h[i], dst + (8 * i));
+}
+
+void block_hash_suffixes(const uint8_t* const midstate, const uint8_t* const suffixes, const uint32_t count, uint8_t* const dst) {
+  uint64_t start[8];
+  load_words(midstate, 8, start);
+
+  uint64_t second[16] = { 0 };
+
+  for (uint32_t i = 0; i < count; i++) {
+    load_words(suffixes + ((size_t) i * STATE_BLOCK_SUFFIX_LENGTH), 6, second);
+
+    uint64_t h[8];
+    memcpy(h, start, sizeof(h));
+    block_final_words(h, second, dst + ((size_t) i * STATE_BLOCK_HASH_LENGTH));
+  }
+}
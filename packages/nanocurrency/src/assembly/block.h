@@ -0,0 +1,43 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_BLOCK_H
+#define NANOCURRENCY_BLOCK_H
+
+#include <stdint.h>
+
+/* preamble + account + previous + representative + balance + link */
+#define STATE_BLOCK_PREIMAGE_LENGTH (32 + 32 + 32 + 32 + 16 + 32)
+#define STATE_BLOCK_HASH_LENGTH 32
+
+#define STATE_BLOCK_BALANCE_LENGTH 16
+
+/* The preimage is a first BLAKE2b block (preamble to representative), then balance and link. */
+#define STATE_BLOCK_PREFIX_LENGTH 128
+#define STATE_BLOCK_SUFFIX_LENGTH (STATE_BLOCK_PREIMAGE_LENGTH - STATE_BLOCK_PREFIX_LENGTH)
+#define STATE_BLOCK_MIDSTATE_LENGTH 64
+
+/* BLAKE2b-256 of a packed state block preimage. */
+void block_hash(const uint8_t* const preimage, uint8_t* const dst);
+
+/* Hashes of count preimages packed back to back, to count hashes back to back. */
+void block_hash_batch(const uint8_t* const preimages, const uint32_t count, uint8_t* const dst);
+
+/*
+  Hashes of count blocks given as one array per field (32 bytes each, 16
+  for the big endian balances), the preamble being implied.
+*/
+void block_hash_columns(const uint8_t* const accounts, const uint8_t* const previous, const uint8_t* const representatives, const uint8_t* const balances, const uint8_t* const links, const uint32_t count, uint8_t* const dst);
+
+/*
+  BLAKE2b state once the 128 bytes prefix of a preimage is compressed, so
+  that blocks only differing by their balance and link cost one compression.
+*/
+void block_midstate(const uint8_t* const prefix, uint8_t* const dst);
+
+/* Hashes of count 48 bytes suffixes packed back to back, all following the prefix of midstate. */
+void block_hash_suffixes(const uint8_t* const midstate, const uint8_t* const suffixes, const uint32_t count, uint8_t* const dst);
+
+#endif
@@ -0,0 +1,68 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_COMPRESS_H
+#define NANOCURRENCY_COMPRESS_H
+
+#include <stdint.h>
+
+/*
+  BLAKE2b constants and round function, for the kernels specialized on a
+  fixed message length (work, state block hash) instead of going through
+  the generic blake2b_update.
+*/
+static const uint64_t COMPRESS_IV[8] = {
+  0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t COMPRESS_SIGMA[12][16] = {
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+  { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+  {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+  {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+  {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+  { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+  { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+  {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+  { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+/* parameter block word 0 for an unkeyed hash: digest length, fanout 1, depth 1 */
+#define COMPRESS_PARAM(outlen) (0x01010000ULL ^ (outlen))
+
+#define ROTR64(w, c) (((w) >> (c)) | ((w) << (64 - (c))))
+
+/* single lane G function and round, over the local arrays v and m */
+#define COMPRESS_G(r, i, a, b, c, d)                        \
+  do {                                                      \
+    v[a] = v[a] + v[b] + m[COMPRESS_SIGMA[r][2 * (i) + 0]]; \
+    v[d] = ROTR64(v[d] ^ v[a], 32);                         \
+    v[c] = v[c] + v[d];                                     \
+    v[b] = ROTR64(v[b] ^ v[c], 24);                         \
+    v[a] = v[a] + v[b] + m[COMPRESS_SIGMA[r][2 * (i) + 1]]; \
+    v[d] = ROTR64(v[d] ^ v[a], 16);                         \
+    v[c] = v[c] + v[d];                                     \
+    v[b] = ROTR64(v[b] ^ v[c], 63);                         \
+  } while (0)
+
+#define COMPRESS_ROUND(r)                                   \
+  do {                                                      \
+    COMPRESS_G(r, 0, 0, 4,  8, 12);                         \
+    COMPRESS_G(r, 1, 1, 5,  9, 13);                         \
+    COMPRESS_G(r, 2, 2, 6, 10, 14);                         \
+    COMPRESS_G(r, 3, 3, 7, 11, 15);                         \
+    COMPRESS_G(r, 4, 0, 5, 10, 15);                         \
+    COMPRESS_G(r, 5, 1, 6, 11, 12);                         \
+    COMPRESS_G(r, 6, 2, 7,  8, 13);                         \
+    COMPRESS_G(r, 7, 3, 4,  9, 14);                         \
+  } while (0)
+
+#endif
@@ -3,119 +3,153 @@
  * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
  * Licensed under GPL-3.0 (https://git.io/vAZsK)
  */
+#include <stddef.h>
 #include <stdint.h>
-#include <string.h>
-#include <stdlib.h>
 
 #include <emscripten.h>
 
 #include "blake2/ref/blake2.h"
+#include "blake2b-multi.h"
+#include "blake2b-state.h"
+#include "blake2bp-leaf.h"
+#include "block.h"
+#include "ndjson.h"
+#include "utils.h"
+#include "work.h"
 
-const uint8_t BLOCK_HASH_LENGTH = 32;
-const uint8_t WORK_LENGTH = 8;
+char stack_string[2 * WORK_CHUNK_RESULT_LENGTH + 1];
 
-void hex_to_bytes(const char* const hex, uint8_t* const dst) {
-  int byte_index = 0;
-  for (unsigned int i = 0; i < strlen(hex); i += 2) {
-    char byte_string[3];
-    memcpy(byte_string, hex + i, 2);
-    byte_string[2] = '\0';
-    const uint8_t byte = (uint8_t) strtol(byte_string, NULL, 16);
-    dst[byte_index++] = byte;
-  }
-}
+EMSCRIPTEN_KEEPALIVE
+const char* emscripten_work_chunk(const char* const block_hash_hex, const char* const work_threshold_hex, const uint8_t worker_index, const uint8_t worker_count, const double offset, const uint32_t count) {
+  uint8_t block_hash_bytes[BLOCK_HASH_LENGTH];
+  hex_to_bytes(block_hash_hex, block_hash_bytes);
 
-void uint64_to_bytes(const uint64_t src, uint8_t* const dst) {
-  memcpy(dst, &src, sizeof(src));
-}
+  uint8_t work_threshold_bytes[WORK_LENGTH];
+  hex_to_bytes(work_threshold_hex, work_threshold_bytes);
+  reverse_bytes(work_threshold_bytes, WORK_LENGTH);
+  uint64_t work_threshold = bytes_to_uint64(work_threshold_bytes);
 
-uint64_t bytes_to_uint64(const uint8_t* const src) {
-  uint64_t ret = 0;
+  uint64_t lower_bound;
+  uint64_t upper_bound;
+  work_bounds(worker_index, worker_count, &lower_bound, &upper_bound);
 
-  memcpy(&ret, src, sizeof(ret));
+  // the offset is relative to the worker range, and stays within 2^53 in practice
+  const uint64_t start = (upper_bound - lower_bound > (uint64_t) offset) ? lower_bound + (uint64_t) offset : upper_bound;
+  const uint64_t end = (upper_bound - start > count) ? start + count : upper_bound;
 
-  return ret;
-}
+  uint8_t result[WORK_CHUNK_RESULT_LENGTH];
+  work_chunk(block_hash_bytes, work_threshold, start, end, result);
+  bytes_to_hex(result, WORK_CHUNK_RESULT_LENGTH, stack_string);
 
-const uint8_t HEX_MAP[] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                           '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-void bytes_to_hex(const uint8_t* const src, const uint8_t length, char* const dst) {
-  for (unsigned int i = 0; i < length; ++i) {
-    dst[2 * i] = HEX_MAP[(src[i] & 0xF0) >> 4];
-    dst[(2 * i) + 1] = HEX_MAP[src[i] & 0x0F];
-  }
+  return stack_string;
+}
 
-  dst[2 * length] = '\0';
+/* All pointers are into the module memory, see the callers in accelerated.ts. */
+EMSCRIPTEN_KEEPALIVE
+void emscripten_block_hash(const uint8_t* const preimage, uint8_t* const dst) {
+  block_hash(preimage, dst);
 }
 
-void reverse_bytes(uint8_t* const src, const uint8_t length) {
-  for (unsigned int i = 0; i < (length / 2); i++) {
-    const uint8_t temp = src[i];
-    src[i] = src[(length - 1) - i];
-    src[(length - 1) - i] = temp;
-  }
+EMSCRIPTEN_KEEPALIVE
+void emscripten_block_hash_batch(const uint8_t* const preimages, const uint32_t count, uint8_t* const dst) {
+  block_hash_batch(preimages, count, dst);
 }
 
-const uint8_t WORK_HASH_LENGTH = 8;
-uint8_t validate_work(const uint8_t* const block_hash, uint64_t work_threshold, uint8_t* const work) {
-  blake2b_state hash;
-  uint8_t output[WORK_HASH_LENGTH];
+EMSCRIPTEN_KEEPALIVE
+void emscripten_block_hash_columns(const uint8_t* const accounts, const uint8_t* const previous, const uint8_t* const representatives, const uint8_t* const balances, const uint8_t* const links, const uint32_t count, uint8_t* const dst) {
+  block_hash_columns(accounts, previous, representatives, balances, links, count, dst);
+}
 
-  blake2b_init(&hash, WORK_HASH_LENGTH);
-  blake2b_update(&hash, work, WORK_LENGTH);
-  blake2b_update(&hash, block_hash, BLOCK_HASH_LENGTH);
-  blake2b_final(&hash, output, WORK_HASH_LENGTH);
+EMSCRIPTEN_KEEPALIVE
+void emscripten_block_midstate(const uint8_t* const prefix, uint8_t* const dst) {
+  block_midstate(prefix, dst);
+}
 
-  const uint64_t output_int = bytes_to_uint64(output);
+EMSCRIPTEN_KEEPALIVE
+void emscripten_block_hash_suffixes(const uint8_t* const midstate, const uint8_t* const suffixes, const uint32_t count, uint8_t* const dst) {
+  block_hash_suffixes(midstate, suffixes, count, dst);
+}
 
-  return output_int >= work_threshold;
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2b_multi(uint8_t* const out, const uint32_t outlen, const uint8_t* const* const in, const size_t* const inlen, const uint32_t count) {
+  return blake2b_multi(out, outlen, in, inlen, count);
 }
 
-const uint64_t MIN_UINT64 = 0x0000000000000000;
-const uint64_t MAX_UINT64 = 0xffffffffffffffff;
-void work(const uint8_t* const block_hash, uint64_t work_threshold, const uint8_t worker_index, const uint8_t worker_count, uint8_t* const dst) {
-  const uint64_t interval = (MAX_UINT64 - MIN_UINT64) / worker_count;
+/*
+  Incremental hashing over a state snapshot kept by the caller, so that
+  forking a hashing context is a copy of its snapshot.
+*/
+EMSCRIPTEN_KEEPALIVE
+uint32_t emscripten_blake2b_state_length(void) {
+  return BLAKE2B_STATE_LENGTH;
+}
 
-  const uint64_t lower_bound = MIN_UINT64 + (worker_index * interval);
-  const uint64_t upper_bound = (worker_index != worker_count - 1) ? lower_bound + interval : MAX_UINT64;
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2b_init(uint8_t* const snapshot, const uint32_t outlen, const uint8_t* const key, const uint32_t keylen) {
+  blake2b_state S;
+  const int ret = (keylen > 0) ? blake2b_init_key(&S, outlen, key, keylen) : blake2b_init(&S, outlen);
+  blake2b_state_snapshot(&S, snapshot);
 
-  uint64_t work = lower_bound;
-  uint8_t work_bytes[WORK_LENGTH];
+  return ret;
+}
 
-  for (;;) {
-    if (work == upper_bound) return;
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2b_update(uint8_t* const snapshot, const uint8_t* const in, const uint32_t inlen) {
+  blake2b_state S;
+  blake2b_state_restore(&S, snapshot);
+  const int ret = blake2b_update(&S, in, inlen);
+  blake2b_state_snapshot(&S, snapshot);
 
-    uint64_to_bytes(work, work_bytes);
+  return ret;
+}
 
-    if (validate_work(block_hash, work_threshold, work_bytes)) {
-      reverse_bytes(work_bytes, WORK_LENGTH);
-      dst[0] = 1;
-      memcpy(dst + 1, work_bytes, WORK_LENGTH);
-      return;
-    }
+/* The snapshot is left untouched, so that hashing can go on. */
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2b_final(const uint8_t* const snapshot, uint8_t* const out) {
+  blake2b_state S;
+  blake2b_state_restore(&S, snapshot);
 
-    work++;
-  }
+  return blake2b_final(&S, out, S.outlen);
 }
 
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2bp_leaf_init(uint8_t* const snapshot, const uint32_t outlen, const uint32_t index, const uint8_t* const key, const uint32_t keylen) {
+  blake2b_state S;
+  const int ret = blake2bp_leaf_init(&S, outlen, index, key, keylen);
+  blake2b_state_snapshot(&S, snapshot);
 
-char stack_string[2 + BLOCK_HASH_LENGTH + 1];
+  return ret;
+}
 
 EMSCRIPTEN_KEEPALIVE
-const char* emscripten_work(const char* const block_hash_hex, const char* const work_threshold_hex, const uint8_t worker_index, const uint8_t worker_count) {
-  uint8_t block_hash_bytes[BLOCK_HASH_LENGTH];
-  hex_to_bytes(block_hash_hex, block_hash_bytes);
+void emscripten_blake2bp_leaf_update(uint8_t* const snapshot, const uint32_t index, const uint8_t* const in, const uint32_t inlen) {
+  blake2b_state S;
+  blake2b_state_restore(&S, snapshot);
+  blake2bp_leaf_update(&S, index, in, inlen);
+  blake2b_state_snapshot(&S, snapshot);
+}
 
-  uint8_t work_threshold_bytes[WORK_LENGTH];
-  hex_to_bytes(work_threshold_hex, work_threshold_bytes);
-  reverse_bytes(work_threshold_bytes, WORK_LENGTH);
-  uint64_t work_threshold = bytes_to_uint64(work_threshold_bytes);
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2bp_leaf_final(const uint8_t* const snapshot, uint8_t* const dst) {
+  blake2b_state S;
+  blake2b_state_restore(&S, snapshot);
+
+  return blake2bp_leaf_final(&S, dst);
+}
 
+EMSCRIPTEN_KEEPALIVE
+int emscripten_blake2bp_root(uint8_t* const out, const uint32_t outlen, const uint32_t keylen, const uint8_t* const leaf_hashes) {
+  return blake2bp_root(out, outlen, keylen, leaf_hashes);
+}
 
-  uint8_t work_[1 + WORK_LENGTH];
-  work_[0] = 0;
-  work(block_hash_bytes, work_threshold, worker_index, worker_count, work_);
-  bytes_to_hex(work_, 1 + WORK_LENGTH, stack_string);
+/* result receives the consumed length, then the count of blocks, as two 32 bits values. */
+EMSCRIPTEN_KEEPALIVE
+int emscripten_ndjson_parse_blocks(const char* const in, const uint32_t inlen, const uint8_t last, uint8_t* const dst, const uint32_t capacity, uint32_t* const result) {
+  size_t consumed;
+  uint32_t count;
+  const int ret = ndjson_parse_blocks(in, inlen, last, dst, capacity, &consumed, &count);
+  result[0] = (uint32_t) consumed;
+  result[1] = count;
 
-  return stack_string;
+  return ret;
 }
@@ -0,0 +1,15 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#define BLAKE2B_VARIANT ref
+#include "variant.h"
+
+#include "../blake2/ref/blake2b-ref.c"
+#include "../work.c"
+#include "../blake2b-multi.c"
+
+#include "dispatch.h"
+
+DEFINE_BLAKE2B_VARIANT("ref")
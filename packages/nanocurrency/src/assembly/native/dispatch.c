@@ -0,0 +1,125 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../blake2b-multi.h"
+#include "../work.h"
+
+#include "dispatch.h"
+
+/*
+  Public BLAKE2b and work functions of the native build, forwarding to the
+  best variant the CPU supports. The variant is selected once, at startup.
+*/
+extern const blake2b_variant blake2b_variant_ref;
+#if defined(__x86_64__) || defined(__i386__)
+extern const blake2b_variant blake2b_variant_sse2;
+extern const blake2b_variant blake2b_variant_sse41;
+extern const blake2b_variant blake2b_variant_avx;
+extern const blake2b_variant blake2b_variant_avx2;
+#endif
+
+static const blake2b_variant* selected_variant = NULL;
+
+static const blake2b_variant* const* supported_variants(void) {
+  /* from the fastest to the slowest */
+  static const blake2b_variant* variants[6];
+  unsigned int count = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) variants[count++] = &blake2b_variant_avx2;
+  if (__builtin_cpu_supports("avx")) variants[count++] = &blake2b_variant_avx;
+  if (__builtin_cpu_supports("sse4.1")) variants[count++] = &blake2b_variant_sse41;
+  if (__builtin_cpu_supports("sse2")) variants[count++] = &blake2b_variant_sse2;
+#endif
+  variants[count++] = &blake2b_variant_ref;
+  variants[count] = NULL;
+
+  return variants;
+}
+
+__attribute__((constructor))
+static void select_variant(void) {
+  const blake2b_variant* const* variants = supported_variants();
+  const char* const forced = getenv("NANOCURRENCY_BLAKE2B");
+
+  selected_variant = variants[0];
+  if (forced == NULL) return;
+
+  for (unsigned int i = 0; variants[i] != NULL; i++) {
+    if (strcmp(variants[i]->name, forced) == 0) {
+      selected_variant = variants[i];
+      return;
+    }
+  }
+}
+
+static const blake2b_variant* variant(void) {
+  /* in case we are called from another constructor */
+  if (selected_variant == NULL) select_variant();
+
+  return selected_variant;
+}
+
+const char* blake2b_variant_name(void) {
+  return variant()->name;
+}
+
+int blake2b_init_param(blake2b_state* S, const blake2b_param* P) {
+  return variant()->init_param(S, P);
+}
+
+int blake2b_init(blake2b_state* S, size_t outlen) {
+  return variant()->init(S, outlen);
+}
+
+int blake2b_init_key(blake2b_state* S, size_t outlen, const void* key, size_t keylen) {
+  return variant()->init_key(S, outlen, key, keylen);
+}
+
+int blake2b_update(blake2b_state* S, const void* in, size_t inlen) {
+  return variant()->update(S, in, inlen);
+}
+
+int blake2b_final(blake2b_state* S, void* out, size_t outlen) {
+  return variant()->final(S, out, outlen);
+}
+
+int blake2b(void* out, size_t outlen, const void* in, size_t inlen, const void* key, size_t keylen) {
+  return variant()->hash(out, outlen, in, inlen, key, keylen);
+}
+
+uint64_t work_value(const uint8_t* const block_hash, const uint8_t* const work) {
+  return variant()->value(block_hash, work);
+}
+
+uint8_t validate_work(const uint8_t* const block_hash, uint64_t work_threshold, const uint8_t* const work) {
+  return variant()->validate(block_hash, work_threshold, work);
+}
+
+void work_value_interleaved(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values) {
+  variant()->value_interleaved(block_hash_words, work, values);
+}
+
+void work_bounds(const uint8_t worker_index, const uint8_t worker_count, uint64_t* const lower_bound, uint64_t* const upper_bound) {
+  variant()->bounds(worker_index, worker_count, lower_bound, upper_bound);
+}
+
+void work_chunk(const uint8_t* const block_hash, uint64_t work_threshold, const uint64_t start, const uint64_t end, uint8_t* const dst) {
+  variant()->chunk(block_hash, work_threshold, start, end, dst);
+}
+
+int blake2b_multi(uint8_t* const out, const size_t outlen, const uint8_t* const* const in, const size_t* const inlen, const size_t count) {
+  return variant()->multi(out, outlen, in, inlen, count);
+}
+
+unsigned int blake2b_multi_lanes(void) {
+  return variant()->multi_lanes();
+}
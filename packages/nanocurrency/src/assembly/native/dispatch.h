@@ -0,0 +1,51 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_DISPATCH_H
+#define NANOCURRENCY_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../blake2/ref/blake2.h"
+
+/* The functions compiled for one instruction set, see variant.h. */
+typedef struct {
+  const char* name;
+
+  int (*init_param)(blake2b_state* S, const blake2b_param* P);
+  int (*init)(blake2b_state* S, size_t outlen);
+  int (*init_key)(blake2b_state* S, size_t outlen, const void* key, size_t keylen);
+  int (*update)(blake2b_state* S, const void* in, size_t inlen);
+  int (*final)(blake2b_state* S, void* out, size_t outlen);
+  int (*hash)(void* out, size_t outlen, const void* in, size_t inlen, const void* key, size_t keylen);
+
+  uint64_t (*value)(const uint8_t* const block_hash, const uint8_t* const work);
+  uint8_t (*validate)(const uint8_t* const block_hash, uint64_t work_threshold, const uint8_t* const work);
+  void (*value_interleaved)(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values);
+  void (*bounds)(const uint8_t worker_index, const uint8_t worker_count, uint64_t* const lower_bound, uint64_t* const upper_bound);
+  void (*chunk)(const uint8_t* const block_hash, uint64_t work_threshold, const uint64_t start, const uint64_t end, uint8_t* const dst);
+
+  int (*multi)(uint8_t* const out, const size_t outlen, const uint8_t* const* const in, const size_t* const inlen, const size_t count);
+  unsigned int (*multi_lanes)(void);
+} blake2b_variant;
+
+#define DEFINE_BLAKE2B_VARIANT(variant_name) \
+  const blake2b_variant VARIANT_NAME(blake2b_variant) = { \
+    variant_name, \
+    blake2b_init_param, blake2b_init, blake2b_init_key, blake2b_update, blake2b_final, blake2b, \
+    work_value, validate_work, work_value_interleaved, work_bounds, work_chunk, \
+    blake2b_multi, blake2b_multi_lanes \
+  };
+
+/*
+  Name of the variant selected for this CPU: ref, sse2, sse41, avx or avx2.
+
+  The NANOCURRENCY_BLAKE2B environment variable forces a variant, as long
+  as the CPU supports it.
+*/
+const char* blake2b_variant_name(void);
+
+#endif
@@ -0,0 +1,39 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_VARIANT_H
+#define NANOCURRENCY_VARIANT_H
+
+/*
+  Suffix the public symbols of a BLAKE2b implementation, and of the work
+  kernels built on top of it, with BLAKE2B_VARIANT, so that the same sources
+  compiled with different instruction sets can be linked together.
+*/
+#ifndef BLAKE2B_VARIANT
+#error "BLAKE2B_VARIANT must be defined"
+#endif
+
+#define VARIANT_NAME__(name, variant) name ## _ ## variant
+#define VARIANT_NAME_(name, variant) VARIANT_NAME__(name, variant)
+#define VARIANT_NAME(name) VARIANT_NAME_(name, BLAKE2B_VARIANT)
+
+#define blake2b_init_param VARIANT_NAME(blake2b_init_param)
+#define blake2b_init VARIANT_NAME(blake2b_init)
+#define blake2b_init_key VARIANT_NAME(blake2b_init_key)
+#define blake2b_update VARIANT_NAME(blake2b_update)
+#define blake2b_final VARIANT_NAME(blake2b_final)
+#define blake2b VARIANT_NAME(blake2b)
+#define blake2 VARIANT_NAME(blake2)
+
+#define work_value VARIANT_NAME(work_value)
+#define validate_work VARIANT_NAME(validate_work)
+#define work_value_interleaved VARIANT_NAME(work_value_interleaved)
+#define work_bounds VARIANT_NAME(work_bounds)
+#define work_chunk VARIANT_NAME(work_chunk)
+
+#define blake2b_multi VARIANT_NAME(blake2b_multi)
+#define blake2b_multi_lanes VARIANT_NAME(blake2b_multi_lanes)
+
+#endif
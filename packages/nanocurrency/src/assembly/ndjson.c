@@ -0,0 +1,273 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2/ref/blake2.h"
+
+#include "ndjson.h"
+
+/*
+  Not a validating JSON parser: the objects and arrays of a line are
+  walked flat, only looking for the string fields of a state block, and
+  the line is valid as long as every one of them is found and valid.
+*/
+#define ACCOUNT_OFFSET 0
+#define PREVIOUS_OFFSET 32
+#define REPRESENTATIVE_OFFSET 64
+#define BALANCE_OFFSET 96
+#define LINK_OFFSET 112
+#define SIGNATURE_OFFSET 144
+#define WORK_OFFSET 208
+
+#define FIELD_TYPE (1 << 0)
+#define FIELD_ACCOUNT (1 << 1)
+#define FIELD_PREVIOUS (1 << 2)
+#define FIELD_REPRESENTATIVE (1 << 3)
+#define FIELD_BALANCE (1 << 4)
+#define FIELD_LINK (1 << 5)
+#define FIELD_SIGNATURE (1 << 6)
+#define FIELD_WORK (1 << 7)
+#define FIELDS_ALL 0xff
+
+/* 52 characters of public key (4 padding bits, then 256 bits), then 8 of checksum */
+#define ADDRESS_KEY_LENGTH 52
+#define ADDRESS_CHECKSUM_LENGTH 8
+#define ADDRESS_CHECKSUM_BYTES 5
+
+static const char BASE32_ALPHABET[] = "13456789abcdefghijkmnopqrstuwxyz";
+
+static int hex_value(const char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+
+  return -1;
+}
+
+static int decode_hex(const char* const src, const size_t length, uint8_t* const dst, const size_t dstlen) {
+  if (length != 2 * dstlen) return -1;
+
+  for (size_t i = 0; i < dstlen; i++) {
+    const int high = hex_value(src[2 * i]);
+    const int low = hex_value(src[(2 * i) + 1]);
+    if (high < 0 || low < 0) return -1;
+
+    dst[i] = (uint8_t) ((high << 4) | low);
+  }
+
+  return 0;
+}
+
+static int base32_value(const char c) {
+  if (c == '\0') return -1;
+
+  const char* const found = strchr(BASE32_ALPHABET, c);
+
+  return (found == NULL) ? -1 : (int) (found - BASE32_ALPHABET);
+}
+
+/* Decode characters holding bits bits, the leading padding being zero, to dstlen bytes. */
+static int decode_base32(const char* const src, const size_t length, uint8_t* const dst, const size_t dstlen) {
+  const unsigned int padding = (unsigned int) ((length * 5) - (dstlen * 8));
+  uint32_t acc = 0;
+  unsigned int bits = 0;
+  size_t written = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    const int value = base32_value(src[i]);
+    if (value < 0) return -1;
+
+    acc = (acc << 5) | (uint32_t) value;
+    bits += 5;
+
+    if (i == 0) {
+      if ((acc >> (5 - padding)) != 0) return -1;
+      bits -= padding;
+      acc &= (1u << bits) - 1;
+    }
+
+    if (bits >= 8) {
+      bits -= 8;
+      dst[written++] = (uint8_t) (acc >> bits);
+      acc &= (1u << bits) - 1;
+    }
+  }
+
+  return (written == dstlen) ? 0 : -1;
+}
+
+static int decode_address(const char* const src, const size_t length, uint8_t* const dst) {
+  size_t prefix;
+  if (length == 4 + ADDRESS_KEY_LENGTH + ADDRESS_CHECKSUM_LENGTH && memcmp(src, "xrb_", 4) == 0) {
+    prefix = 4;
+  } else if (length == 5 + ADDRESS_KEY_LENGTH + ADDRESS_CHECKSUM_LENGTH && memcmp(src, "nano_", 5) == 0) {
+    prefix = 5;
+  } else {
+    return -1;
+  }
+
+  uint8_t checksum[ADDRESS_CHECKSUM_BYTES];
+  if (decode_base32(src + prefix, ADDRESS_KEY_LENGTH, dst, 32) < 0) return -1;
+  if (decode_base32(src + prefix + ADDRESS_KEY_LENGTH, ADDRESS_CHECKSUM_LENGTH, checksum, ADDRESS_CHECKSUM_BYTES) < 0) return -1;
+
+  /* the checksum is the reversed BLAKE2b-40 of the public key */
+  uint8_t expected[ADDRESS_CHECKSUM_BYTES];
+  blake2b(expected, ADDRESS_CHECKSUM_BYTES, dst, 32, NULL, 0);
+  for (unsigned int i = 0; i < ADDRESS_CHECKSUM_BYTES; i++) {
+    if (checksum[i] != expected[ADDRESS_CHECKSUM_BYTES - 1 - i]) return -1;
+  }
+
+  return 0;
+}
+
+/* A raw amount, up to 2^128 - 1, to 16 big endian bytes, through 32 bits limbs. */
+static int decode_balance(const char* const src, const size_t length, uint8_t* const dst) {
+  if (length == 0 || length > 39) return -1;
+
+  uint32_t limbs[4] = { 0 };
+  for (size_t i = 0; i < length; i++) {
+    if (src[i] < '0' || src[i] > '9') return -1;
+
+    uint64_t carry = (uint64_t) (src[i] - '0');
+    for (int limb = 3; limb >= 0; limb--) {
+      const uint64_t value = ((uint64_t) limbs[limb] * 10) + carry;
+      limbs[limb] = (uint32_t) value;
+      carry = value >> 32;
+    }
+    if (carry != 0) return -1;
+  }
+
+  for (unsigned int limb = 0; limb < 4; limb++) {
+    for (unsigned int i = 0; i < 4; i++) dst[(4 * limb) + i] = (uint8_t) (limbs[limb] >> (24 - (8 * i)));
+  }
+
+  return 0;
+}
+
+static int key_is(const char* const key, const size_t length, const char* const name) {
+  return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+/* Decode the value of a block field, or return 0 for any other key. */
+static int decode_field(const char* const key, const size_t keylen, const char* const value, const size_t length, uint8_t* const dst) {
+  if (key_is(key, keylen, "type")) {
+    return key_is(value, length, "state") ? FIELD_TYPE : -1;
+  }
+  if (key_is(key, keylen, "account")) {
+    return decode_address(value, length, dst + ACCOUNT_OFFSET) < 0 ? -1 : FIELD_ACCOUNT;
+  }
+  if (key_is(key, keylen, "previous")) {
+    return decode_hex(value, length, dst + PREVIOUS_OFFSET, 32) < 0 ? -1 : FIELD_PREVIOUS;
+  }
+  if (key_is(key, keylen, "representative")) {
+    return decode_address(value, length, dst + REPRESENTATIVE_OFFSET) < 0 ? -1 : FIELD_REPRESENTATIVE;
+  }
+  if (key_is(key, keylen, "balance")) {
+    return decode_balance(value, length, dst + BALANCE_OFFSET) < 0 ? -1 : FIELD_BALANCE;
+  }
+  if (key_is(key, keylen, "link")) {
+    if (decode_hex(value, length, dst + LINK_OFFSET, 32) == 0) return FIELD_LINK;
+    return decode_address(value, length, dst + LINK_OFFSET) < 0 ? -1 : FIELD_LINK;
+  }
+  if (key_is(key, keylen, "signature")) {
+    return decode_hex(value, length, dst + SIGNATURE_OFFSET, 64) < 0 ? -1 : FIELD_SIGNATURE;
+  }
+  if (key_is(key, keylen, "work")) {
+    return decode_hex(value, length, dst + WORK_OFFSET, 8) < 0 ? -1 : FIELD_WORK;
+  }
+
+  return 0;
+}
+
+static const char* skip_whitespace(const char* p, const char* const end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+
+  return p;
+}
+
+/* p is past the opening quote. Returns past the closing quote, or NULL. */
+static const char* skip_string(const char* p, const char* const end, int* const escaped) {
+  *escaped = 0;
+
+  while (p < end) {
+    if (*p == '"') return p + 1;
+    if (*p == '\\') {
+      *escaped = 1;
+      p++;
+    }
+    p++;
+  }
+
+  return NULL;
+}
+
+static int parse_block(const char* p, const char* const end, uint8_t* const dst) {
+  int found = 0;
+
+  while ((p = skip_whitespace(p, end)) < end) {
+    if (*p != '"') {
+      /* structure, or a number, true, false or null */
+      p++;
+      continue;
+    }
+
+    int escaped;
+    const char* const key = p + 1;
+    p = skip_string(key, end, &escaped);
+    if (p == NULL) return -1;
+    const size_t keylen = (size_t) (p - key) - 1;
+
+    p = skip_whitespace(p, end);
+    /* a string in an array */
+    if (p == end || *p != ':') continue;
+
+    p = skip_whitespace(p + 1, end);
+    /* an object or an array is walked into */
+    if (p == end || *p != '"') continue;
+
+    const char* const value = p + 1;
+    p = skip_string(value, end, &escaped);
+    if (p == NULL) return -1;
+    /* none of the fields of a block needs escaping */
+    if (escaped) continue;
+
+    const int field = decode_field(key, keylen, value, (size_t) (p - value) - 1, dst);
+    if (field < 0) return -1;
+    found |= field;
+  }
+
+  return (found == FIELDS_ALL) ? 0 : -1;
+}
+
+int ndjson_parse_blocks(const char* const in, const size_t inlen, const uint8_t last, uint8_t* const dst, const uint32_t capacity, size_t* const consumed, uint32_t* const count) {
+  size_t offset = 0;
+  uint32_t written = 0;
+
+  while (written < capacity && offset < inlen) {
+    const char* const newline = memchr(in + offset, '\n', inlen - offset);
+    if (newline == NULL && !last) break;
+
+    const char* const line_end = (newline == NULL) ? in + inlen : newline;
+    const char* const line = skip_whitespace(in + offset, line_end);
+
+    if (line < line_end) {
+      if (parse_block(line, line_end, dst + ((size_t) written * ENCODED_BLOCK_LENGTH)) < 0) {
+        *consumed = offset;
+        *count = written;
+        return -1;
+      }
+      written++;
+    }
+
+    offset = (size_t) (line_end - in) + (newline == NULL ? 0 : 1);
+  }
+
+  *consumed = offset;
+  *count = written;
+  return 0;
+}
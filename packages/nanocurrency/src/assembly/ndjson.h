@@ -0,0 +1,39 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_NDJSON_H
+#define NANOCURRENCY_NDJSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  account + previous + representative + balance + link + signature + work,
+  as encodeBlock lays them out, the balance and the work big endian.
+*/
+#define ENCODED_BLOCK_LENGTH (32 + 32 + 32 + 16 + 32 + 64 + 8)
+
+/*
+  Parse state blocks written as JSON, one per line, straight into encoded
+  blocks, without allocating.
+
+  The type, account, previous, representative, balance, link, signature
+  and work fields are read wherever they are, so that a block nested in
+  an object (as in {"hash", "block"}) is read too, and any other field is
+  skipped. Addresses are decoded and their checksum checked, and the link
+  can be either hexadecimal or an address.
+
+  Only complete lines are parsed, up to capacity blocks: a line is
+  complete once its newline is read, or when last is set, at the end of
+  the input. Empty lines are skipped.
+
+  consumed is set to the length of the lines parsed, so that the rest is
+  fed again with the next input, and count to the count of blocks written
+  to dst. Returns 0, or -1 if a line is not a valid state block, consumed
+  then being the offset of that line.
+*/
+int ndjson_parse_blocks(const char* const in, const size_t inlen, const uint8_t last, uint8_t* const dst, const uint32_t capacity, size_t* const consumed, uint32_t* const count);
+
+#endif
@@ -0,0 +1,127 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "block.h"
+#include "store.h"
+
+#define PREVIOUS_OFFSET 32
+
+static const uint8_t MAGIC[4] = { 'N', 'B', 'S', 'I' };
+
+static uint32_t load_uint32(const uint8_t* const src) {
+  return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+}
+
+static void store_uint32(const uint32_t src, uint8_t* const dst) {
+  for (unsigned int i = 0; i < 4; i++) dst[i] = (uint8_t) (src >> (8 * i));
+}
+
+static int is_zero(const uint8_t* const src, const size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (src[i] != 0) return 0;
+  }
+
+  return 1;
+}
+
+uint32_t block_store_slot_count(const uint32_t count) {
+  uint32_t slot_count = 1;
+  while (slot_count < 2 * (uint64_t) count && slot_count < BLOCK_STORE_MAX_SLOT_COUNT) slot_count <<= 1;
+
+  return slot_count;
+}
+
+size_t block_store_index_length(const uint32_t count) {
+  return BLOCK_STORE_HEADER_LENGTH + ((size_t) count * (STATE_BLOCK_HASH_LENGTH + 4)) + ((size_t) block_store_slot_count(count) * 4);
+}
+
+uint8_t* block_store_hashes(uint8_t* const index) {
+  return index + BLOCK_STORE_HEADER_LENGTH;
+}
+
+static uint8_t* successors(const uint8_t* const index, const uint32_t count) {
+  return (uint8_t*) index + BLOCK_STORE_HEADER_LENGTH + ((size_t) count * STATE_BLOCK_HASH_LENGTH);
+}
+
+static uint8_t* slots(const uint8_t* const index, const uint32_t count) {
+  return successors(index, count) + ((size_t) count * 4);
+}
+
+void block_store_build(const uint8_t* const blocks, const uint32_t count, uint8_t* const index) {
+  const uint32_t slot_count = block_store_slot_count(count);
+  const uint8_t* const hashes = block_store_hashes(index);
+  uint8_t* const successor_bytes = successors(index, count);
+  uint8_t* const slot_bytes = slots(index, count);
+
+  memcpy(index, MAGIC, 4);
+  store_uint32(BLOCK_STORE_VERSION, index + 4);
+  store_uint32(count, index + 8);
+  store_uint32(slot_count, index + 12);
+  memset(successor_bytes, 0, (size_t) count * 4);
+  memset(slot_bytes, 0, (size_t) slot_count * 4);
+
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* const hash = hashes + ((size_t) i * STATE_BLOCK_HASH_LENGTH);
+    uint32_t slot = load_uint32(hash) & (slot_count - 1);
+
+    for (;;) {
+      const uint32_t entry = load_uint32(slot_bytes + ((size_t) slot * 4));
+      if (entry == 0) {
+        store_uint32(i + 1, slot_bytes + ((size_t) slot * 4));
+        break;
+      }
+      /* a duplicate */
+      if (memcmp(hashes + ((size_t) (entry - 1) * STATE_BLOCK_HASH_LENGTH), hash, STATE_BLOCK_HASH_LENGTH) == 0) break;
+
+      slot = (slot + 1) & (slot_count - 1);
+    }
+  }
+
+  /* once every hash is indexed, each block is the successor of its previous block */
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* const previous = blocks + ((size_t) i * BLOCK_STORE_BLOCK_LENGTH) + PREVIOUS_OFFSET;
+    if (is_zero(previous, STATE_BLOCK_HASH_LENGTH)) continue;
+
+    const int64_t found = block_store_find(index, previous);
+    if (found < 0) continue;
+
+    uint8_t* const successor = successor_bytes + ((size_t) found * 4);
+    if (load_uint32(successor) == 0) store_uint32(i + 1, successor);
+  }
+}
+
+int block_store_check(const uint8_t* const index, const size_t length, const uint32_t count) {
+  if (length < BLOCK_STORE_HEADER_LENGTH || memcmp(index, MAGIC, 4) != 0) return -1;
+  if (load_uint32(index + 4) != BLOCK_STORE_VERSION) return -1;
+  if (load_uint32(index + 8) != count || load_uint32(index + 12) != block_store_slot_count(count)) return -1;
+
+  return length == block_store_index_length(count) ? 0 : -1;
+}
+
+int64_t block_store_find(const uint8_t* const index, const uint8_t* const hash) {
+  const uint32_t count = load_uint32(index + 8);
+  const uint32_t slot_count = load_uint32(index + 12);
+  const uint8_t* const hashes = index + BLOCK_STORE_HEADER_LENGTH;
+  const uint8_t* const slot_bytes = slots(index, count);
+  uint32_t slot = load_uint32(hash) & (slot_count - 1);
+
+  for (;;) {
+    const uint32_t entry = load_uint32(slot_bytes + ((size_t) slot * 4));
+    if (entry == 0) return -1;
+    if (memcmp(hashes + ((size_t) (entry - 1) * STATE_BLOCK_HASH_LENGTH), hash, STATE_BLOCK_HASH_LENGTH) == 0) return entry - 1;
+
+    slot = (slot + 1) & (slot_count - 1);
+  }
+}
+
+int64_t block_store_successor(const uint8_t* const index, const uint32_t i) {
+  const uint32_t count = load_uint32(index + 8);
+
+  return (int64_t) load_uint32(successors(index, count) + ((size_t) i * 4)) - 1;
+}
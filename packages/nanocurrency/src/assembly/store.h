@@ -0,0 +1,59 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_STORE_H
+#define NANOCURRENCY_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  A block store is a file of 216 bytes encoded state blocks back to back,
+  and an index of that file, as written by createBlockStoreIndex in store.ts:
+
+    header      "NBSI", version, block count, slot count (4 bytes each)
+    hashes      the 32 bytes hash of every block, in the order of the blocks
+    successors  per block, 1 + the index of the block following it in its
+                account chain, or 0 (4 bytes each)
+    slots       open addressing table of 1 + the index of a block, or 0 for
+                an empty slot (4 bytes each)
+
+  Every integer is little endian. A hash starts probing at the slot given
+  by its first 4 bytes, and probes the next ones until an empty slot:
+  block hashes being uniform, they are used as is, and with at least twice
+  as many slots as blocks, a lookup reads a couple of slots.
+*/
+#define BLOCK_STORE_HEADER_LENGTH 16
+#define BLOCK_STORE_VERSION 1
+#define BLOCK_STORE_BLOCK_LENGTH 216
+#define BLOCK_STORE_MAX_SLOT_COUNT 0x80000000u
+/* so that every block has an empty slot after it */
+#define BLOCK_STORE_MAX_COUNT (BLOCK_STORE_MAX_SLOT_COUNT / 2)
+
+/* A power of two, at least twice count, count being at most BLOCK_STORE_MAX_COUNT. */
+uint32_t block_store_slot_count(const uint32_t count);
+
+size_t block_store_index_length(const uint32_t count);
+
+/* Where the hashes of the blocks go, for the caller to fill before building the index. */
+uint8_t* block_store_hashes(uint8_t* const index);
+
+/*
+  Build the index of count blocks, their hashes being already written to
+  block_store_hashes(index), the index being block_store_index_length(count)
+  bytes. When blocks share a hash, or a previous block, the first one wins.
+*/
+void block_store_build(const uint8_t* const blocks, const uint32_t count, uint8_t* const index);
+
+/* Check that an index of length bytes is one of count blocks. Returns 0, or -1. */
+int block_store_check(const uint8_t* const index, const size_t length, const uint32_t count);
+
+/* Returns the index of the block of a hash, or -1. */
+int64_t block_store_find(const uint8_t* const index, const uint8_t* const hash);
+
+/* Returns the index of the block following block i in its account chain, or -1. */
+int64_t block_store_successor(const uint8_t* const index, const uint32_t i);
+
+#endif
@@ -0,0 +1,65 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../block.h"
+
+/*
+  Check the specialized state block hashes (packed, from a midstate and
+  columnar) against the generic BLAKE2b (itself checked by kat.c), over
+  pseudo-random preimages.
+*/
+#define PREIMAGE_COUNT 10000
+
+int main(void) {
+  uint8_t preimage[STATE_BLOCK_PREIMAGE_LENGTH];
+  uint32_t seed = 0x6e616e6f;
+
+  for (unsigned int count = 0; count < PREIMAGE_COUNT; count++) {
+    for (unsigned int i = 0; i < STATE_BLOCK_PREIMAGE_LENGTH; i++) {
+      seed = (seed * 1103515245) + 12345;
+      preimage[i] = (uint8_t) (seed >> 16);
+    }
+
+    uint8_t expected[STATE_BLOCK_HASH_LENGTH];
+    blake2b(expected, STATE_BLOCK_HASH_LENGTH, preimage, STATE_BLOCK_PREIMAGE_LENGTH, NULL, 0);
+
+    uint8_t actual[STATE_BLOCK_HASH_LENGTH];
+    block_hash(preimage, actual);
+
+    if (memcmp(actual, expected, STATE_BLOCK_HASH_LENGTH) != 0) {
+      printf("error: preimage %u\n", count);
+      return 1;
+    }
+
+    /* same block, from the midstate of its prefix */
+    uint8_t midstate[STATE_BLOCK_MIDSTATE_LENGTH];
+    block_midstate(preimage, midstate);
+    block_hash_suffixes(midstate, preimage + STATE_BLOCK_PREFIX_LENGTH, 1, actual);
+
+    if (memcmp(actual, expected, STATE_BLOCK_HASH_LENGTH) != 0) {
+      printf("error: midstate %u\n", count);
+      return 1;
+    }
+
+    /* same block, as columns of one row with the state block preamble */
+    memset(preimage, 0, 32);
+    preimage[31] = 6;
+    blake2b(expected, STATE_BLOCK_HASH_LENGTH, preimage, STATE_BLOCK_PREIMAGE_LENGTH, NULL, 0);
+    block_hash_columns(preimage + 32, preimage + 64, preimage + 96, preimage + 128, preimage + 144, 1, actual);
+
+    if (memcmp(actual, expected, STATE_BLOCK_HASH_LENGTH) != 0) {
+      printf("error: columns %u\n", count);
+      return 1;
+    }
+  }
+
+  printf("ok: %u preimages\n", PREIMAGE_COUNT);
+  return 0;
+}
@@ -0,0 +1,91 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../blake2bp-leaf.h"
+#include "../utils.h"
+
+/*
+  Check the linked BLAKE2b implementation against blake2b-kat.txt, or with
+  the blake2bp argument the BLAKE2bp leaves against blake2bp-kat.txt, read
+  from stdin: blocks of "in:", "key:" and "hash:" lines, in hexadecimal.
+*/
+#define LINE_LENGTH 1024
+
+/* each leaf fed stripe by stripe, as when hashing a file chunk by chunk */
+static int blake2bp_leaves(void* out, size_t outlen, const void* in, size_t inlen, const void* key, size_t keylen) {
+  uint8_t leaf_hashes[BLAKE2BP_LEAVES * BLAKE2B_OUTBYTES];
+
+  for (size_t index = 0; index < BLAKE2BP_LEAVES; index++) {
+    blake2b_state S;
+    if (blake2bp_leaf_init(&S, outlen, index, key, keylen) < 0) return -1;
+
+    for (size_t offset = 0; offset < inlen; offset += BLAKE2BP_STRIPE_LENGTH) {
+      const size_t left = inlen - offset;
+      blake2bp_leaf_update(&S, index, (const uint8_t*) in + offset, (left < BLAKE2BP_STRIPE_LENGTH) ? left : BLAKE2BP_STRIPE_LENGTH);
+    }
+
+    blake2bp_leaf_final(&S, leaf_hashes + (index * BLAKE2B_OUTBYTES));
+  }
+
+  return blake2bp_root(out, outlen, keylen, leaf_hashes);
+}
+
+static size_t read_field(const char* const line, const char* const name, uint8_t* const dst) {
+  const size_t name_length = strlen(name);
+  if (strncmp(line, name, name_length) != 0) return (size_t) -1;
+
+  char hex[LINE_LENGTH];
+  strcpy(hex, line + name_length);
+  hex[strcspn(hex, "\r\n")] = '\0';
+  hex_to_bytes(hex, dst);
+
+  return strlen(hex) / 2;
+}
+
+int main(int argc, char** argv) {
+  int (*hash)(void*, size_t, const void*, size_t, const void*, size_t) = blake2b;
+  if (argc > 1 && strcmp(argv[1], "blake2bp") == 0) hash = blake2bp_leaves;
+
+  char line[LINE_LENGTH];
+  uint8_t in[LINE_LENGTH / 2];
+  uint8_t key[BLAKE2B_KEYBYTES];
+  uint8_t expected[BLAKE2B_OUTBYTES];
+  size_t in_length = 0;
+  size_t key_length = 0;
+  unsigned int count = 0;
+
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    size_t length;
+
+    if ((length = read_field(line, "in:\t", in)) != (size_t) -1) {
+      in_length = length;
+    } else if ((length = read_field(line, "key:\t", key)) != (size_t) -1) {
+      key_length = length;
+    } else if ((length = read_field(line, "hash:\t", expected)) != (size_t) -1) {
+      uint8_t actual[BLAKE2B_OUTBYTES];
+      hash(actual, length, in, in_length, key, key_length);
+
+      if (memcmp(actual, expected, length) != 0) {
+        printf("error: vector %u\n", count);
+        return 1;
+      }
+
+      count++;
+    }
+  }
+
+  if (count == 0) {
+    puts("error: no vector");
+    return 1;
+  }
+
+  printf("ok: %u vectors\n", count);
+  return 0;
+}
@@ -0,0 +1,70 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../blake2b-multi.h"
+#include "../native/dispatch.h"
+
+/*
+  Check the multi-buffer BLAKE2b against the generic one (itself checked by
+  kat.c), over batches mixing empty, partial and multi-block messages.
+*/
+#define MAX_COUNT 11
+#define MAX_LENGTH 300
+
+int main(void) {
+  static uint8_t messages[MAX_COUNT][MAX_LENGTH];
+  const uint8_t* in[MAX_COUNT];
+  size_t inlen[MAX_COUNT];
+  uint32_t seed = 0x6e616e6f;
+  unsigned int batches = 0;
+
+  for (unsigned int i = 0; i < MAX_COUNT; i++) {
+    for (unsigned int j = 0; j < MAX_LENGTH; j++) {
+      seed = (seed * 1103515245) + 12345;
+      messages[i][j] = (uint8_t) (seed >> 16);
+    }
+    in[i] = messages[i];
+  }
+
+  for (size_t count = 0; count <= MAX_COUNT; count++) {
+    for (size_t outlen = 1; outlen <= BLAKE2B_OUTBYTES; outlen++) {
+      for (size_t i = 0; i < count; i++) {
+        seed = (seed * 1103515245) + 12345;
+        inlen[i] = (seed >> 16) % (MAX_LENGTH + 1);
+      }
+
+      uint8_t actual[MAX_COUNT * BLAKE2B_OUTBYTES];
+      if (blake2b_multi(actual, outlen, in, inlen, count) != 0) {
+        printf("error: count %u, outlen %u\n", (unsigned int) count, (unsigned int) outlen);
+        return 1;
+      }
+
+      for (size_t i = 0; i < count; i++) {
+        uint8_t expected[BLAKE2B_OUTBYTES];
+        blake2b(expected, outlen, in[i], inlen[i], NULL, 0);
+
+        if (memcmp(actual + (i * outlen), expected, outlen) != 0) {
+          printf("error: count %u, outlen %u, message %u\n", (unsigned int) count, (unsigned int) outlen, (unsigned int) i);
+          return 1;
+        }
+      }
+
+      batches++;
+    }
+  }
+
+  if (blake2b_multi(NULL, 0, in, inlen, 0) != -1 || blake2b_multi(NULL, 65, in, inlen, 0) != -1) {
+    puts("error: output length");
+    return 1;
+  }
+
+  printf("ok: %u batches, %u lanes (%s)\n", batches, blake2b_multi_lanes(), blake2b_variant_name());
+  return 0;
+}
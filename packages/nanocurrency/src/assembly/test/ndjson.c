@@ -0,0 +1,87 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../ndjson.h"
+#include "../utils.h"
+
+/*
+  Check the NDJSON block parser against a block encoded by encodeBlock,
+  over split inputs, nested blocks and invalid lines.
+*/
+#define BLOCK "{\"type\":\"state\",\"account\":\"xrb_39fkkrfkt1gnmjbtwu6yc6xwc8p1abswtmfeabuzict6pmrabcatzmh71rgc\",\"previous\":\"0000000000000000000000000000000000000000000000000000000000000000\",\"representative\":\"xrb_3qfohkcii7dgaz3beijxc9y93x3kto5wioy5qdt5fdnq3p94psm185n7ktf6\",\"balance\":\"881686\",\"link\":\"9728D0A8B740CBABD885A20218CA0D1371A2AF5E8CF8B59CA7D7FA3C290B0CB0\",\"link_as_account\":\"xrb_37sat4ndgi8doheadai45571t6ujncqox59rppgchozt9inip57ifrxqtch4\",\"signature\":\"59D94A7414CD685D188D5CC77B6DB4E331BBD37534DD2B69DE2198BD1E4ADB3DEBB3E5C1D38597CAA512D45A9E454DE79E995DB71BC646FAA11582A1BC5D9203\",\"work\":\"b2ff948c874e7d62\"}"
+#define ENCODED "9db2961b2d01d49c53ae6c9e513bc51ac04273cd4dac4277f82b44b4f084a91a0000000000000000000000000000000000000000000000000000000000000000ddb57c9508156e47c296423d51fc70f432d547c857c3baf436ae970d8e2b6660000000000000000000000000000d74169728d0a8b740cbabd885a20218ca0d1371a2af5e8cf8b59ca7d7fa3c290b0cb059d94a7414cd685d188d5cc77b6db4e331bbd37534dd2b69de2198bd1e4adb3debb3e5c1d38597caa512d45a9e454de79e995db71bc646faa11582a1bc5d9203b2ff948c874e7d62"
+/* nested, spaced, with nano_ and lowercase prefixes, a padded balance and an address link */
+#define SPACED "{ \"block\" : { \"type\" : \"state\" , \"account\": \"xrb_39fkkrfkt1gnmjbtwu6yc6xwc8p1abswtmfeabuzict6pmrabcatzmh71rgc\", \"previous\": \"0000000000000000000000000000000000000000000000000000000000000000\", \"representative\": \"nano_3qfohkcii7dgaz3beijxc9y93x3kto5wioy5qdt5fdnq3p94psm185n7ktf6\", \"balance\": \"000881686\", \"link\": \"xrb_37sat4ndgi8doheadai45571t6ujncqox59rppgchozt9inip57ifrxqtch4\", \"signature\": \"59d94a7414cd685d188d5cc77b6db4e331bbd37534dd2b69de2198bd1e4adb3debb3e5c1d38597caa512d45a9e454de79e995db71bc646faa11582a1bc5d9203\", \"work\": \"B2FF948C874E7D62\", \"tags\": [\"a\", 1, null] } }"
+
+/* BLOCK with its first from replaced by to */
+static const char* tamper(const char* const from, const char* const to) {
+  static char tampered[2 * sizeof(BLOCK)];
+  const char* const found = strstr(BLOCK, from);
+  const size_t before = (size_t) (found - BLOCK);
+
+  memcpy(tampered, BLOCK, before);
+  strcpy(tampered + before, to);
+  strcat(tampered, found + strlen(from));
+
+  return tampered;
+}
+
+static int expect(const char* const name, const char* const in, const uint8_t last, const uint32_t capacity, const int expected_ret, const size_t expected_consumed, const uint32_t expected_count) {
+  uint8_t expected_block[ENCODED_BLOCK_LENGTH];
+  hex_to_bytes(ENCODED, expected_block);
+  /* a tampered balance is only checked through the returned value */
+  const int compare = strstr(in, "881686") != NULL;
+
+  uint8_t blocks[4 * ENCODED_BLOCK_LENGTH];
+  size_t consumed;
+  uint32_t count;
+  const int ret = ndjson_parse_blocks(in, strlen(in), last, blocks, capacity, &consumed, &count);
+
+  if (ret != expected_ret || consumed != expected_consumed || count != expected_count) {
+    printf("error: %s (ret %d, consumed %zu, count %u)\n", name, ret, consumed, count);
+    return 1;
+  }
+  for (uint32_t i = 0; compare && i < count; i++) {
+    if (memcmp(blocks + (i * ENCODED_BLOCK_LENGTH), expected_block, ENCODED_BLOCK_LENGTH) != 0) {
+      printf("error: %s (block %u)\n", name, i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int main(void) {
+  const size_t line = strlen(BLOCK) + 1;
+  int failures = 0;
+
+  failures += expect("line", BLOCK "\n", 0, 4, 0, line, 1);
+  failures += expect("blank lines", "\n  \n" BLOCK "\n\n" BLOCK "\n", 0, 4, 0, (2 * line) + 5, 2);
+  failures += expect("incomplete line", BLOCK "\n" BLOCK, 0, 4, 0, line, 1);
+  failures += expect("last line", BLOCK "\n" BLOCK, 1, 4, 0, (2 * line) - 1, 2);
+  failures += expect("capacity", BLOCK "\n" BLOCK "\n", 0, 1, 0, line, 1);
+  failures += expect("nested", "{\"hash\":\"30B313950FE441F009649DBBEF093DC7968A970E56DADC3E50B1E23A481C5AC6\",\"block\":" BLOCK "}\n", 0, 4, 0, line + 84, 1);
+  failures += expect("spaces", SPACED, 1, 4, 0, strlen(SPACED), 1);
+
+  const char* const largest = tamper("881686", "340282366920938463463374607431768211455");
+  failures += expect("largest balance", largest, 1, 4, 0, strlen(largest), 1);
+
+  /* the first broken line stops the parse */
+  failures += expect("missing field", BLOCK "\n{\"type\":\"state\"}\n", 0, 4, -1, line, 1);
+  failures += expect("bad checksum", tamper("mh71rgc", "mh71rgd"), 1, 4, -1, 0, 0);
+  failures += expect("bad type", tamper("state", "send"), 1, 4, -1, 0, 0);
+  failures += expect("balance overflow", tamper("881686", "340282366920938463463374607431768211456"), 1, 4, -1, 0, 0);
+  failures += expect("bad hex", tamper("7d62", "7d6z"), 1, 4, -1, 0, 0);
+  failures += expect("bad padding", tamper("xrb_39fk", "xrb_h9fk"), 1, 4, -1, 0, 0);
+
+  if (failures > 0) return 1;
+
+  printf("ok: ndjson\n");
+  return 0;
+}
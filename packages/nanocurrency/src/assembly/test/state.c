@@ -0,0 +1,61 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../blake2/ref/blake2.h"
+#include "../blake2b-state.h"
+#include "../native/dispatch.h"
+
+/*
+  Check that a message hashed from a restored (or copied) snapshot of its
+  prefix matches the message hashed in one go, for prefixes and suffixes
+  around the block boundaries.
+*/
+#define MAX_LENGTH 300
+
+int main(void) {
+  uint8_t message[MAX_LENGTH];
+  for (unsigned int i = 0; i < MAX_LENGTH; i++) message[i] = (uint8_t) (i * 7);
+
+  unsigned int count = 0;
+  for (size_t prefix_length = 0; prefix_length <= MAX_LENGTH; prefix_length++) {
+    blake2b_state prefix;
+    blake2b_init(&prefix, BLAKE2B_OUTBYTES);
+    blake2b_update(&prefix, message, prefix_length);
+
+    uint8_t snapshot[BLAKE2B_STATE_LENGTH];
+    blake2b_state_snapshot(&prefix, snapshot);
+
+    for (size_t length = prefix_length; length <= MAX_LENGTH; length += 37) {
+      uint8_t expected[BLAKE2B_OUTBYTES];
+      blake2b(expected, BLAKE2B_OUTBYTES, message, length, NULL, 0);
+
+      blake2b_state restored;
+      blake2b_state_restore(&restored, snapshot);
+      blake2b_update(&restored, message + prefix_length, length - prefix_length);
+      uint8_t actual[BLAKE2B_OUTBYTES];
+      blake2b_final(&restored, actual, BLAKE2B_OUTBYTES);
+
+      blake2b_state copied;
+      blake2b_state_copy(&copied, &prefix);
+      blake2b_update(&copied, message + prefix_length, length - prefix_length);
+      uint8_t actual_copy[BLAKE2B_OUTBYTES];
+      blake2b_final(&copied, actual_copy, BLAKE2B_OUTBYTES);
+
+      if (memcmp(actual, expected, BLAKE2B_OUTBYTES) != 0 || memcmp(actual_copy, expected, BLAKE2B_OUTBYTES) != 0) {
+        printf("error: prefix %u, length %u\n", (unsigned int) prefix_length, (unsigned int) length);
+        return 1;
+      }
+
+      count++;
+    }
+  }
+
+  printf("ok: %u messages (%s)\n", count, blake2b_variant_name());
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../block.h"
+#include "../store.h"
+
+/*
+  Index interleaved account chains of pseudo-random blocks, and check that
+  every block is found, that the chains are followed, and that a block
+  sharing the hash or the previous block of another one is left out.
+*/
+#define ACCOUNT_COUNT 7
+#define CHAIN_LENGTH 1000
+#define BLOCK_COUNT (ACCOUNT_COUNT * CHAIN_LENGTH + 2)
+
+static void hash_block(const uint8_t* const block, uint8_t* const dst) {
+  uint8_t preimage[STATE_BLOCK_PREIMAGE_LENGTH] = { 0 };
+  preimage[31] = 6;
+  memcpy(preimage + 32, block, STATE_BLOCK_PREIMAGE_LENGTH - 32);
+  block_hash(preimage, dst);
+}
+
+int main(void) {
+  uint8_t* const blocks = calloc(BLOCK_COUNT, BLOCK_STORE_BLOCK_LENGTH);
+  uint8_t* const index = malloc(block_store_index_length(BLOCK_COUNT));
+  uint8_t* const hashes = block_store_hashes(index);
+  uint32_t seed = 0x6e616e6f;
+
+  /* block i is block i / ACCOUNT_COUNT of the chain of account i % ACCOUNT_COUNT */
+  for (uint32_t i = 0; i < ACCOUNT_COUNT * CHAIN_LENGTH; i++) {
+    uint8_t* const block = blocks + ((size_t) i * BLOCK_STORE_BLOCK_LENGTH);
+    for (unsigned int j = 64; j < BLOCK_STORE_BLOCK_LENGTH; j++) {
+      seed = (seed * 1103515245) + 12345;
+      block[j] = (uint8_t) (seed >> 16);
+    }
+    block[0] = (uint8_t) (i % ACCOUNT_COUNT);
+    if (i >= ACCOUNT_COUNT) memcpy(block + 32, hashes + ((size_t) (i - ACCOUNT_COUNT) * STATE_BLOCK_HASH_LENGTH), STATE_BLOCK_HASH_LENGTH);
+
+    hash_block(block, hashes + ((size_t) i * STATE_BLOCK_HASH_LENGTH));
+  }
+
+  /* a duplicate of block 3, and a fork of block 0 */
+  uint8_t* const duplicate = blocks + ((size_t) (BLOCK_COUNT - 2) * BLOCK_STORE_BLOCK_LENGTH);
+  uint8_t* const fork = duplicate + BLOCK_STORE_BLOCK_LENGTH;
+  memcpy(duplicate, blocks + (3 * BLOCK_STORE_BLOCK_LENGTH), BLOCK_STORE_BLOCK_LENGTH);
+  memcpy(fork, blocks + (ACCOUNT_COUNT * BLOCK_STORE_BLOCK_LENGTH), BLOCK_STORE_BLOCK_LENGTH);
+  fork[100] ^= 1;
+  hash_block(duplicate, hashes + ((size_t) (BLOCK_COUNT - 2) * STATE_BLOCK_HASH_LENGTH));
+  hash_block(fork, hashes + ((size_t) (BLOCK_COUNT - 1) * STATE_BLOCK_HASH_LENGTH));
+
+  block_store_build(blocks, BLOCK_COUNT, index);
+
+  if (block_store_check(index, block_store_index_length(BLOCK_COUNT), BLOCK_COUNT) != 0 || block_store_check(index, block_store_index_length(BLOCK_COUNT), BLOCK_COUNT - 1) == 0) {
+    printf("error: header\n");
+    return 1;
+  }
+
+  for (uint32_t i = 0; i < BLOCK_COUNT; i++) {
+    const int64_t expected = (i == BLOCK_COUNT - 2) ? 3 : i;
+    if (block_store_find(index, hashes + ((size_t) i * STATE_BLOCK_HASH_LENGTH)) != expected) {
+      printf("error: block %u not found\n", i);
+      return 1;
+    }
+  }
+
+  uint8_t missing[STATE_BLOCK_HASH_LENGTH] = { 0 };
+  if (block_store_find(index, missing) != -1) {
+    printf("error: missing block found\n");
+    return 1;
+  }
+
+  for (uint32_t account = 0; account < ACCOUNT_COUNT; account++) {
+    int64_t i = account;
+    uint32_t length = 0;
+    for (; i >= 0; i = block_store_successor(index, (uint32_t) i)) {
+      if (i != account + (int64_t) length * ACCOUNT_COUNT) {
+        printf("error: chain %u at %u\n", account, length);
+        return 1;
+      }
+      length++;
+    }
+
+    if (length != CHAIN_LENGTH) {
+      printf("error: chain %u of %u blocks\n", account, length);
+      return 1;
+    }
+  }
+
+  free(index);
+  free(blocks);
+
+  printf("ok: %u blocks\n", BLOCK_COUNT);
+  return 0;
+}
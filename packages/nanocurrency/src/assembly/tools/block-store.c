@@ -0,0 +1,247 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../block.h"
+#include "../store.h"
+#include "../utils.h"
+
+/*
+  Index a binary ledger dump by block hash, and query it.
+
+  usage: block-store index [--threads <count>] <blocks> <index>
+         block-store get <blocks> <index> <hash>
+         block-store chain <blocks> <index> <hash>
+
+  The dump holds 216 bytes state blocks back to back, as encoded by
+  encodeBlock, and the index the one of createBlockStoreIndex (see store.h),
+  so that either side can query what the other indexed. Both files are
+  mapped in memory: the blocks are hashed by every thread straight into
+  the index, which is then built on the calling thread.
+
+  `get` prints "<index> <block>", the block in hexadecimal, and `chain`
+  prints "<index> <hash>" for every block of the account chain of a block,
+  from its open block to its frontier.
+*/
+#define MAX_THREADS 255
+/* blocks hashed by a single block_hash_batch call */
+#define BATCH_LENGTH 256
+
+typedef struct {
+  const uint8_t* blocks;
+  uint8_t* hashes;
+  size_t start;
+  size_t end;
+} slice;
+
+typedef struct {
+  void* data;
+  size_t length;
+} mapping;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void* hash_slice(void* const arg) {
+  const slice* const s = (const slice*) arg;
+
+  /* the preamble is written once, and every block copied after it */
+  uint8_t preimages[BATCH_LENGTH * STATE_BLOCK_PREIMAGE_LENGTH] = { 0 };
+  for (size_t i = 0; i < BATCH_LENGTH; i++) preimages[(i * STATE_BLOCK_PREIMAGE_LENGTH) + 31] = 6;
+
+  for (size_t batch = s->start; batch < s->end; batch += BATCH_LENGTH) {
+    const size_t count = (s->end - batch < BATCH_LENGTH) ? s->end - batch : BATCH_LENGTH;
+
+    for (size_t i = 0; i < count; i++) {
+      const uint8_t* const block = s->blocks + ((batch + i) * BLOCK_STORE_BLOCK_LENGTH);
+      memcpy(preimages + (i * STATE_BLOCK_PREIMAGE_LENGTH) + 32, block, STATE_BLOCK_PREIMAGE_LENGTH - 32);
+    }
+    block_hash_batch(preimages, (uint32_t) count, s->hashes + (batch * STATE_BLOCK_HASH_LENGTH));
+  }
+
+  return NULL;
+}
+
+static int map_file(const char* const path, const int writable, const size_t length, mapping* const dst) {
+  const int fd = open(path, writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    return -1;
+  }
+  if (writable && ftruncate(fd, (off_t) length) < 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+
+  dst->length = writable ? length : (size_t) st.st_size;
+  dst->data = NULL;
+  if (dst->length > 0) {
+    dst->data = mmap(NULL, dst->length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (dst->data == MAP_FAILED) {
+      perror(path);
+      close(fd);
+      return -1;
+    }
+  }
+  close(fd);
+
+  return 0;
+}
+
+static void unmap_file(const mapping* const m) {
+  if (m->length > 0) munmap(m->data, m->length);
+}
+
+static int map_blocks(const char* const path, mapping* const dst, uint32_t* const count) {
+  if (map_file(path, 0, 0, dst) < 0) return -1;
+
+  if (dst->length % BLOCK_STORE_BLOCK_LENGTH != 0 || dst->length / BLOCK_STORE_BLOCK_LENGTH > BLOCK_STORE_MAX_COUNT) {
+    fprintf(stderr, "%s: not a whole count of %d bytes blocks, up to %u\n", path, BLOCK_STORE_BLOCK_LENGTH, BLOCK_STORE_MAX_COUNT);
+    unmap_file(dst);
+    return -1;
+  }
+  *count = (uint32_t) (dst->length / BLOCK_STORE_BLOCK_LENGTH);
+
+  return 0;
+}
+
+static int usage(void) {
+  fputs("usage: block-store index [--threads <count>] <blocks> <index>\n", stderr);
+  fputs("       block-store get <blocks> <index> <hash>\n", stderr);
+  fputs("       block-store chain <blocks> <index> <hash>\n", stderr);
+
+  return 2;
+}
+
+static int index_blocks(const char* const blocks_path, const char* const index_path, const long thread_count) {
+  mapping blocks;
+  uint32_t count;
+  if (map_blocks(blocks_path, &blocks, &count) < 0) return 1;
+
+  mapping index;
+  if (map_file(index_path, 1, block_store_index_length(count), &index) < 0) return 1;
+  uint8_t* const hashes = block_store_hashes(index.data);
+
+  const double begin = now();
+  slice slices[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+
+  for (long i = 0; i < thread_count; i++) {
+    slice* const s = &slices[i];
+    s->blocks = blocks.data;
+    s->hashes = hashes;
+    s->start = ((size_t) count * (size_t) i) / (size_t) thread_count;
+    s->end = ((size_t) count * (size_t) (i + 1)) / (size_t) thread_count;
+
+    if (pthread_create(&threads[i], NULL, hash_slice, s) != 0) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+  for (long i = 0; i < thread_count; i++) pthread_join(threads[i], NULL);
+
+  block_store_build(blocks.data, count, index.data);
+  const double elapsed = now() - begin;
+
+  unmap_file(&index);
+  unmap_file(&blocks);
+
+  const double throughput = (double) count / (elapsed > 0 ? elapsed : 1e-9);
+  fprintf(stderr, "%u blocks indexed in %.2f s, %.0f blocks/s\n", count, elapsed, throughput);
+
+  return 0;
+}
+
+static int query(const char* const command, const char* const blocks_path, const char* const index_path, const char* const hash_hex) {
+  if (strlen(hash_hex) != 2 * STATE_BLOCK_HASH_LENGTH || strspn(hash_hex, "0123456789abcdefABCDEF") != 2 * STATE_BLOCK_HASH_LENGTH) return usage();
+  uint8_t hash[STATE_BLOCK_HASH_LENGTH];
+  hex_to_bytes(hash_hex, hash);
+
+  mapping blocks;
+  uint32_t count;
+  if (map_blocks(blocks_path, &blocks, &count) < 0) return 1;
+  mapping index;
+  if (map_file(index_path, 0, 0, &index) < 0) return 1;
+  if (block_store_check(index.data, index.length, count) < 0) {
+    fprintf(stderr, "%s: not an index of %s\n", index_path, blocks_path);
+    return 1;
+  }
+  const uint8_t* const data = blocks.data;
+  const uint8_t* const hashes = block_store_hashes(index.data);
+
+  int64_t found = block_store_find(index.data, hash);
+  if (found < 0) {
+    fprintf(stderr, "%s: not found\n", hash_hex);
+    return 1;
+  }
+
+  if (strcmp(command, "get") == 0) {
+    char hex[2 * BLOCK_STORE_BLOCK_LENGTH + 1];
+    bytes_to_hex(data + ((size_t) found * BLOCK_STORE_BLOCK_LENGTH), BLOCK_STORE_BLOCK_LENGTH, hex);
+    printf("%lld %s\n", (long long) found, hex);
+  } else {
+    /* back to the open block, or to the first block missing its previous one */
+    for (;;) {
+      const uint8_t* const previous = data + ((size_t) found * BLOCK_STORE_BLOCK_LENGTH) + 32;
+      const int64_t before = block_store_find(index.data, previous);
+      if (before < 0) break;
+      found = before;
+    }
+
+    for (; found >= 0; found = block_store_successor(index.data, (uint32_t) found)) {
+      char hex[2 * STATE_BLOCK_HASH_LENGTH + 1];
+      bytes_to_hex(hashes + ((size_t) found * STATE_BLOCK_HASH_LENGTH), STATE_BLOCK_HASH_LENGTH, hex);
+      printf("%lld %s\n", (long long) found, hex);
+    }
+  }
+
+  unmap_file(&index);
+  unmap_file(&blocks);
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) return usage();
+
+  if (strcmp(argv[1], "index") == 0) {
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int arg = 2;
+    if (argc > 3 && strcmp(argv[arg], "--threads") == 0) {
+      thread_count = strtol(argv[arg + 1], NULL, 10);
+      if (thread_count < 1 || thread_count > MAX_THREADS) return usage();
+      arg += 2;
+    }
+    if (arg != argc - 2) return usage();
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_THREADS) thread_count = MAX_THREADS;
+
+    return index_blocks(argv[arg], argv[arg + 1], thread_count);
+  }
+
+  if ((strcmp(argv[1], "get") == 0 || strcmp(argv[1], "chain") == 0) && argc == 5) {
+    return query(argv[1], argv[2], argv[3], argv[4]);
+  }
+
+  return usage();
+}
@@ -0,0 +1,187 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../blake2bp-leaf.h"
+#include "../native/dispatch.h"
+#include "../utils.h"
+
+/*
+  BLAKE2bp-256 checksum of a file, each leaf on its own thread.
+
+  usage: hash-file [--read] <path>
+
+  The file is mapped in memory, or with --read, read by chunks of
+  CHUNK_LENGTH bytes, the next chunk being read while the current one is
+  hashed. The hash goes to stdout, the throughput to stderr.
+*/
+#define HASH_LENGTH 32
+#define CHUNK_LENGTH (64 * 1024 * 1024)
+
+typedef struct {
+  blake2b_state state;
+  size_t index;
+  const uint8_t* in;
+  size_t inlen;
+} leaf;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void* hash_leaf(void* const arg) {
+  leaf* const l = (leaf*) arg;
+  blake2bp_leaf_update(&l->state, l->index, l->in, l->inlen);
+
+  return NULL;
+}
+
+static int hash_part(leaf* const leaves, const uint8_t* const in, const size_t inlen) {
+  pthread_t threads[BLAKE2BP_LEAVES];
+
+  for (size_t i = 0; i < BLAKE2BP_LEAVES; i++) {
+    leaves[i].in = in;
+    leaves[i].inlen = inlen;
+    if (pthread_create(&threads[i], NULL, hash_leaf, &leaves[i]) != 0) return -1;
+  }
+  for (size_t i = 0; i < BLAKE2BP_LEAVES; i++) pthread_join(threads[i], NULL);
+
+  return 0;
+}
+
+static int hash_mapped(leaf* const leaves, const int fd, const size_t length) {
+  if (length == 0) return 0;
+
+  void* const map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) return -1;
+  posix_madvise(map, length, POSIX_MADV_SEQUENTIAL);
+
+  const int ret = hash_part(leaves, map, length);
+  munmap(map, length);
+
+  return ret;
+}
+
+static ssize_t read_chunk(const int fd, uint8_t* const dst) {
+  size_t length = 0;
+
+  while (length < CHUNK_LENGTH) {
+    const ssize_t count = read(fd, dst + length, CHUNK_LENGTH - length);
+    if (count < 0) return -1;
+    if (count == 0) break;
+    length += (size_t) count;
+  }
+
+  return (ssize_t) length;
+}
+
+typedef struct {
+  leaf* leaves;
+  const uint8_t* in;
+  size_t inlen;
+  int ret;
+} part;
+
+static void* hash_part_thread(void* const arg) {
+  part* const p = (part*) arg;
+  p->ret = hash_part(p->leaves, p->in, p->inlen);
+
+  return NULL;
+}
+
+static int hash_read(leaf* const leaves, const int fd) {
+  /* CHUNK_LENGTH is a multiple of BLAKE2BP_STRIPE_LENGTH, as leaves require */
+  uint8_t* const buffers[2] = { malloc(CHUNK_LENGTH), malloc(CHUNK_LENGTH) };
+  int ret = -1;
+  if (buffers[0] == NULL || buffers[1] == NULL) goto end;
+
+  unsigned int current = 0;
+  ssize_t length = read_chunk(fd, buffers[current]);
+
+  while (length > 0) {
+    pthread_t thread;
+    part p = { leaves, buffers[current], (size_t) length, 0 };
+    if (pthread_create(&thread, NULL, hash_part_thread, &p) != 0) goto end;
+
+    /* a short chunk is the last one */
+    const ssize_t next_length = (length == CHUNK_LENGTH) ? read_chunk(fd, buffers[1 - current]) : 0;
+
+    pthread_join(thread, NULL);
+    if (p.ret < 0 || next_length < 0) goto end;
+
+    current = 1 - current;
+    length = next_length;
+  }
+
+  ret = (length < 0) ? -1 : 0;
+
+end:
+  free(buffers[0]);
+  free(buffers[1]);
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  const int use_read = (argc == 3 && strcmp(argv[1], "--read") == 0);
+  if (argc != 2 && !use_read) {
+    fputs("usage: hash-file [--read] <path>\n", stderr);
+    return 2;
+  }
+  const char* const path = argv[argc - 1];
+
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    return 1;
+  }
+
+  leaf leaves[BLAKE2BP_LEAVES];
+  for (size_t i = 0; i < BLAKE2BP_LEAVES; i++) {
+    leaves[i].index = i;
+    blake2bp_leaf_init(&leaves[i].state, HASH_LENGTH, i, NULL, 0);
+  }
+
+  const double begin = now();
+  const int ret = use_read ? hash_read(leaves, fd) : hash_mapped(leaves, fd, (size_t) st.st_size);
+  close(fd);
+  if (ret < 0) {
+    perror(path);
+    return 1;
+  }
+
+  uint8_t leaf_hashes[BLAKE2BP_LEAVES * BLAKE2B_OUTBYTES];
+  for (size_t i = 0; i < BLAKE2BP_LEAVES; i++) {
+    blake2bp_leaf_final(&leaves[i].state, leaf_hashes + (i * BLAKE2B_OUTBYTES));
+  }
+
+  uint8_t hash[HASH_LENGTH];
+  blake2bp_root(hash, HASH_LENGTH, 0, leaf_hashes);
+  const double elapsed = now() - begin;
+
+  char hex[2 * HASH_LENGTH + 1];
+  bytes_to_hex(hash, HASH_LENGTH, hex);
+  printf("%s  %s\n", hex, path);
+
+  const double megabytes = (double) st.st_size / 1e6;
+  fprintf(stderr, "%.1f MB in %.2f s, %.1f MB/s (BLAKE2b variant: %s)\n", megabytes, elapsed, megabytes / (elapsed > 0 ? elapsed : 1e-9), blake2b_variant_name());
+
+  return 0;
+}
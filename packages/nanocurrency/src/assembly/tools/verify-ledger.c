@@ -0,0 +1,365 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../block.h"
+#include "../native/dispatch.h"
+#include "../utils.h"
+#include "../work.h"
+
+/*
+  Validate the work of every block of a binary ledger dump, on every core.
+
+  usage: verify-ledger [--threads <count>] [--threshold <hex>] [--receive-threshold <hex>] <path>
+
+  The dump holds 216 bytes state blocks back to back, as encoded by
+  encodeBlock: account, previous, representative, balance, link,
+  signature and work, big endian. It is mapped in memory, and every
+  thread validates its own slice of it.
+
+  Open blocks, and blocks raising the balance of the last block of their
+  account, are validated against the receive threshold. As in
+  `nanocurrency verify ledger`, the last balance of the 65536 most
+  recently seen accounts is kept, in a first pass over the whole dump.
+  The signatures and the hashes are left to `nanocurrency verify ledger`,
+  there being no Ed25519 in the C sources: only the failing blocks are
+  hashed.
+
+  The failing blocks go to stdout as "<index> <hash> work" lines, the
+  throughput to stderr.
+*/
+#define STATE_BLOCK_LENGTH 216
+#define DEFAULT_WORK_THRESHOLD 0xffffffc000000000ULL
+#define MAX_THREADS 255
+/* see BALANCE_CACHE_CAPACITY in ledger.ts */
+#define BALANCE_CACHE_CAPACITY 65536
+#define BALANCE_CACHE_BUCKETS (2 * BALANCE_CACHE_CAPACITY)
+#define NO_ENTRY UINT32_MAX
+
+#define ACCOUNT_OFFSET 0
+#define PREVIOUS_OFFSET 32
+#define BALANCE_OFFSET 96
+#define WORK_OFFSET 208
+
+/* the last balance of an account, in a bucket chain and in the LRU list */
+typedef struct {
+  uint8_t account[32];
+  uint8_t balance[STATE_BLOCK_BALANCE_LENGTH];
+  uint32_t next;
+  uint32_t newer;
+  uint32_t older;
+} balance_entry;
+
+typedef struct {
+  balance_entry entries[BALANCE_CACHE_CAPACITY];
+  uint32_t buckets[BALANCE_CACHE_BUCKETS];
+  uint32_t size;
+  uint32_t newest;
+  uint32_t oldest;
+} balance_cache;
+
+typedef struct {
+  const uint8_t* blocks;
+  /* one byte per block of the dump, non-zero for a receive block */
+  const uint8_t* receives;
+  size_t start;
+  size_t end;
+  uint64_t threshold;
+  uint64_t receive_threshold;
+  /* indexes of the failing blocks, in order */
+  size_t* failures;
+  size_t failure_count;
+  size_t failure_capacity;
+  int ret;
+} slice;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static int is_zero(const uint8_t* const src, const size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if (src[i] != 0) return 0;
+  }
+
+  return 1;
+}
+
+/* account public keys are uniform, as in table.ts */
+static uint32_t bucket_of(const uint8_t* const account) {
+  const uint32_t bytes = (uint32_t) account[24] | ((uint32_t) account[25] << 8) | ((uint32_t) account[26] << 16) | ((uint32_t) account[27] << 24);
+
+  return bytes & (BALANCE_CACHE_BUCKETS - 1);
+}
+
+static void unlink_entry(balance_cache* const cache, const uint32_t index) {
+  balance_entry* const entry = &cache->entries[index];
+
+  if (entry->newer == NO_ENTRY) cache->newest = entry->older;
+  else cache->entries[entry->newer].older = entry->older;
+  if (entry->older == NO_ENTRY) cache->oldest = entry->newer;
+  else cache->entries[entry->older].newer = entry->newer;
+}
+
+static void link_newest(balance_cache* const cache, const uint32_t index) {
+  balance_entry* const entry = &cache->entries[index];
+
+  entry->newer = NO_ENTRY;
+  entry->older = cache->newest;
+  if (cache->newest == NO_ENTRY) cache->oldest = index;
+  else cache->entries[cache->newest].newer = index;
+  cache->newest = index;
+}
+
+/* the entry of an account, created in place of the least recently used one when full */
+static uint32_t find_or_insert(balance_cache* const cache, const uint8_t* const account, int* const found) {
+  const uint32_t bucket = bucket_of(account);
+  for (uint32_t index = cache->buckets[bucket]; index != NO_ENTRY; index = cache->entries[index].next) {
+    if (memcmp(cache->entries[index].account, account, 32) == 0) {
+      unlink_entry(cache, index);
+      link_newest(cache, index);
+      *found = 1;
+
+      return index;
+    }
+  }
+
+  uint32_t index;
+  if (cache->size < BALANCE_CACHE_CAPACITY) {
+    index = cache->size++;
+  } else {
+    index = cache->oldest;
+    unlink_entry(cache, index);
+
+    uint32_t* link = &cache->buckets[bucket_of(cache->entries[index].account)];
+    while (*link != index) link = &cache->entries[*link].next;
+    *link = cache->entries[index].next;
+  }
+
+  memcpy(cache->entries[index].account, account, 32);
+  cache->entries[index].next = cache->buckets[bucket];
+  cache->buckets[bucket] = index;
+  link_newest(cache, index);
+  *found = 0;
+
+  return index;
+}
+
+/* the subtype depends on the blocks before, so it is told first, in order */
+static int classify_blocks(const uint8_t* const blocks, const size_t block_count, uint8_t* const receives) {
+  balance_cache* const cache = malloc(sizeof(balance_cache));
+  if (cache == NULL) return -1;
+
+  cache->size = 0;
+  cache->newest = NO_ENTRY;
+  cache->oldest = NO_ENTRY;
+  for (size_t i = 0; i < BALANCE_CACHE_BUCKETS; i++) cache->buckets[i] = NO_ENTRY;
+
+  for (size_t index = 0; index < block_count; index++) {
+    const uint8_t* const block = blocks + (index * STATE_BLOCK_LENGTH);
+    const uint8_t* const balance = block + BALANCE_OFFSET;
+
+    int found;
+    balance_entry* const entry = &cache->entries[find_or_insert(cache, block + ACCOUNT_OFFSET, &found)];
+
+    /* big endian balances compare as bytes */
+    receives[index] = is_zero(block + PREVIOUS_OFFSET, BLOCK_HASH_LENGTH) || (found && memcmp(balance, entry->balance, STATE_BLOCK_BALANCE_LENGTH) > 0);
+    memcpy(entry->balance, balance, STATE_BLOCK_BALANCE_LENGTH);
+  }
+
+  free(cache);
+
+  return 0;
+}
+
+static int add_failure(slice* const s, const size_t index) {
+  if (s->failure_count == s->failure_capacity) {
+    const size_t capacity = s->failure_capacity == 0 ? 64 : 2 * s->failure_capacity;
+    size_t* const failures = realloc(s->failures, capacity * sizeof(size_t));
+    if (failures == NULL) return -1;
+
+    s->failures = failures;
+    s->failure_capacity = capacity;
+  }
+
+  s->failures[s->failure_count++] = index;
+
+  return 0;
+}
+
+static void* verify_slice(void* const arg) {
+  slice* const s = (slice*) arg;
+
+  for (size_t index = s->start; index < s->end; index++) {
+    const uint8_t* const block = s->blocks + (index * STATE_BLOCK_LENGTH);
+
+    /* the work of an open block is computed on the account public key */
+    const uint8_t* const previous = block + PREVIOUS_OFFSET;
+    const uint8_t* const root = is_zero(previous, BLOCK_HASH_LENGTH) ? block + ACCOUNT_OFFSET : previous;
+    const uint64_t threshold = s->receives[index] ? s->receive_threshold : s->threshold;
+
+    /* the work is hashed little endian */
+    uint8_t work[WORK_LENGTH];
+    memcpy(work, block + WORK_OFFSET, WORK_LENGTH);
+    reverse_bytes(work, WORK_LENGTH);
+
+    if (!validate_work(root, threshold, work) && add_failure(s, index) < 0) {
+      s->ret = -1;
+      return NULL;
+    }
+  }
+
+  return NULL;
+}
+
+static int parse_threshold(const char* const hex, uint64_t* const dst) {
+  if (strlen(hex) != 16 || strspn(hex, "0123456789abcdefABCDEF") != 16) return -1;
+
+  uint8_t bytes[8];
+  hex_to_bytes(hex, bytes);
+  reverse_bytes(bytes, 8);
+  *dst = bytes_to_uint64(bytes);
+
+  return 0;
+}
+
+static int usage(void) {
+  fputs("usage: verify-ledger [--threads <count>] [--threshold <hex>] [--receive-threshold <hex>] <path>\n", stderr);
+
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+  uint64_t threshold = DEFAULT_WORK_THRESHOLD;
+  int has_receive_threshold = 0;
+  uint64_t receive_threshold = 0;
+
+  int arg = 1;
+  for (; arg < argc - 1; arg += 2) {
+    if (strcmp(argv[arg], "--threads") == 0) {
+      thread_count = strtol(argv[arg + 1], NULL, 10);
+      if (thread_count < 1 || thread_count > MAX_THREADS) return usage();
+    } else if (strcmp(argv[arg], "--threshold") == 0) {
+      if (parse_threshold(argv[arg + 1], &threshold) < 0) return usage();
+    } else if (strcmp(argv[arg], "--receive-threshold") == 0) {
+      if (parse_threshold(argv[arg + 1], &receive_threshold) < 0) return usage();
+      has_receive_threshold = 1;
+    } else {
+      return usage();
+    }
+  }
+  if (arg != argc - 1) return usage();
+  if (!has_receive_threshold) receive_threshold = threshold;
+  if (thread_count < 1) thread_count = 1;
+  if (thread_count > MAX_THREADS) thread_count = MAX_THREADS;
+  const char* const path = argv[arg];
+
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    return 1;
+  }
+  if (st.st_size % STATE_BLOCK_LENGTH != 0) {
+    fprintf(stderr, "%s: not a whole count of %d bytes blocks\n", path, STATE_BLOCK_LENGTH);
+    return 1;
+  }
+  const size_t length = (size_t) st.st_size;
+  const size_t block_count = length / STATE_BLOCK_LENGTH;
+
+  const uint8_t* blocks = NULL;
+  if (length > 0) {
+    void* const map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      perror(path);
+      return 1;
+    }
+    posix_madvise(map, length, POSIX_MADV_SEQUENTIAL);
+    blocks = map;
+  }
+  close(fd);
+
+  const double begin = now();
+  uint8_t* const receives = malloc(block_count > 0 ? block_count : 1);
+  if (receives == NULL || classify_blocks(blocks, block_count, receives) < 0) {
+    perror("verify-ledger");
+    return 1;
+  }
+
+  slice slices[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  int ret = 0;
+
+  for (long i = 0; i < thread_count; i++) {
+    slice* const s = &slices[i];
+    memset(s, 0, sizeof(slice));
+    s->blocks = blocks;
+    s->receives = receives;
+    s->start = (block_count * (size_t) i) / (size_t) thread_count;
+    s->end = (block_count * (size_t) (i + 1)) / (size_t) thread_count;
+    s->threshold = threshold;
+    s->receive_threshold = receive_threshold;
+
+    if (pthread_create(&threads[i], NULL, verify_slice, s) != 0) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+
+  size_t failure_count = 0;
+  for (long i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
+    if (slices[i].ret < 0) ret = -1;
+    failure_count += slices[i].failure_count;
+  }
+  const double elapsed = now() - begin;
+
+  if (ret < 0) {
+    perror("verify-ledger");
+    return 1;
+  }
+
+  /* the slices are in order, and so are their failures */
+  for (long i = 0; i < thread_count; i++) {
+    for (size_t j = 0; j < slices[i].failure_count; j++) {
+      const size_t index = slices[i].failures[j];
+
+      uint8_t hash[STATE_BLOCK_HASH_LENGTH];
+      uint8_t preimage[STATE_BLOCK_PREIMAGE_LENGTH] = { 0 };
+      preimage[31] = 6;
+      memcpy(preimage + 32, blocks + (index * STATE_BLOCK_LENGTH), STATE_BLOCK_PREIMAGE_LENGTH - 32);
+      block_hash(preimage, hash);
+
+      char hex[2 * STATE_BLOCK_HASH_LENGTH + 1];
+      bytes_to_hex(hash, STATE_BLOCK_HASH_LENGTH, hex);
+      printf("%zu %s work\n", index, hex);
+    }
+    free(slices[i].failures);
+  }
+  free(receives);
+
+  if (length > 0) munmap((void*) blocks, length);
+
+  const double throughput = (double) block_count / (elapsed > 0 ? elapsed : 1e-9);
+  fprintf(stderr, "%zu blocks in %.2f s, %.0f blocks/s, %zu failures (BLAKE2b variant: %s)\n", block_count, elapsed, throughput, failure_count, blake2b_variant_name());
+
+  return failure_count > 0 ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "utils.h"
+
+void hex_to_bytes(const char* const hex, uint8_t* const dst) {
+  int byte_index = 0;
+  for (unsigned int i = 0; i < strlen(hex); i += 2) {
+    char byte_string[3];
+    memcpy(byte_string, hex + i, 2);
+    byte_string[2] = '\0';
+    const uint8_t byte = (uint8_t) strtol(byte_string, NULL, 16);
+    dst[byte_index++] = byte;
+  }
+}
+
+void uint64_to_bytes(const uint64_t src, uint8_t* const dst) {
+  memcpy(dst, &src, sizeof(src));
+}
+
+uint64_t bytes_to_uint64(const uint8_t* const src) {
+  uint64_t ret = 0;
+
+  memcpy(&ret, src, sizeof(ret));
+
+  return ret;
+}
+
+void uint64_to_big_endian_bytes(const uint64_t src, uint8_t* const dst) {
+  uint64_to_bytes(src, dst);
+  reverse_bytes(dst, sizeof(src));
+}
+
+const uint8_t HEX_MAP[] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                           '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+void bytes_to_hex(const uint8_t* const src, const uint8_t length, char* const dst) {
+  for (unsigned int i = 0; i < length; ++i) {
+    dst[2 * i] = HEX_MAP[(src[i] & 0xF0) >> 4];
+    dst[(2 * i) + 1] = HEX_MAP[src[i] & 0x0F];
+  }
+
+  dst[2 * length] = '\0';
+}
+
+void reverse_bytes(uint8_t* const src, const uint8_t length) {
+  for (unsigned int i = 0; i < (length / 2); i++) {
+    const uint8_t temp = src[i];
+    src[i] = src[(length - 1) - i];
+    src[(length - 1) - i] = temp;
+  }
+}
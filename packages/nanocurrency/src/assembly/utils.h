@@ -0,0 +1,20 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_UTILS_H
+#define NANOCURRENCY_UTILS_H
+
+#include <stdint.h>
+
+void hex_to_bytes(const char* const hex, uint8_t* const dst);
+void bytes_to_hex(const uint8_t* const src, const uint8_t length, char* const dst);
+
+void uint64_to_bytes(const uint64_t src, uint8_t* const dst);
+uint64_t bytes_to_uint64(const uint8_t* const src);
+void uint64_to_big_endian_bytes(const uint64_t src, uint8_t* const dst);
+
+void reverse_bytes(uint8_t* const src, const uint8_t length);
+
+#endif
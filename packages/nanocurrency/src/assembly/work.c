@@ -0,0 +1,226 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2/ref/blake2.h"
+
+#include "compress.h"
+#include "utils.h"
+#include "work.h"
+
+#if defined(__SSE4_1__)
+/* SSE4.1, or wasm SIMD through emscripten's SSE headers */
+#include <smmintrin.h>
+#include "blake2/sse/blake2-config.h"
+#include "blake2/sse/blake2b-round.h"
+#endif
+
+uint64_t work_value(const uint8_t* const block_hash, const uint8_t* const work) {
+  blake2b_state hash;
+  uint8_t output[WORK_HASH_LENGTH];
+
+  blake2b_init(&hash, WORK_HASH_LENGTH);
+  blake2b_update(&hash, work, WORK_LENGTH);
+  blake2b_update(&hash, block_hash, BLOCK_HASH_LENGTH);
+  blake2b_final(&hash, output, WORK_HASH_LENGTH);
+
+  return bytes_to_uint64(output);
+}
+
+uint8_t validate_work(const uint8_t* const block_hash, uint64_t work_threshold, const uint8_t* const work) {
+  return work_value(block_hash, work) >= work_threshold;
+}
+
+/*
+  The work message is a single 40 bytes block (nonce, then block hash)
+  hashed to 8 bytes, so the whole BLAKE2b computation is one compression
+  where only the first message word differs between two nonces.
+
+  Evaluating two nonces in lockstep gives the CPU two independent
+  dependency chains in each G function, which scalar runtimes (without
+  SIMD) can schedule in parallel.
+*/
+#define WORK_G(r, i, a, b, c, d)                                \
+  do {                                                          \
+    va[a] = va[a] + va[b] + ma[COMPRESS_SIGMA[r][2 * (i) + 0]]; \
+    vb[a] = vb[a] + vb[b] + mb[COMPRESS_SIGMA[r][2 * (i) + 0]]; \
+    va[d] = ROTR64(va[d] ^ va[a], 32);                          \
+    vb[d] = ROTR64(vb[d] ^ vb[a], 32);                          \
+    va[c] = va[c] + va[d];                                      \
+    vb[c] = vb[c] + vb[d];                                      \
+    va[b] = ROTR64(va[b] ^ va[c], 24);                          \
+    vb[b] = ROTR64(vb[b] ^ vb[c], 24);                          \
+    va[a] = va[a] + va[b] + ma[COMPRESS_SIGMA[r][2 * (i) + 1]]; \
+    vb[a] = vb[a] + vb[b] + mb[COMPRESS_SIGMA[r][2 * (i) + 1]]; \
+    va[d] = ROTR64(va[d] ^ va[a], 16);                          \
+    vb[d] = ROTR64(vb[d] ^ vb[a], 16);                          \
+    va[c] = va[c] + va[d];                                      \
+    vb[c] = vb[c] + vb[d];                                      \
+    va[b] = ROTR64(va[b] ^ va[c], 63);                          \
+    vb[b] = ROTR64(vb[b] ^ vb[c], 63);                          \
+  } while (0)
+
+#define WORK_ROUND(r)                                           \
+  do {                                                          \
+    WORK_G(r, 0, 0, 4,  8, 12);                                 \
+    WORK_G(r, 1, 1, 5,  9, 13);                                 \
+    WORK_G(r, 2, 2, 6, 10, 14);                                 \
+    WORK_G(r, 3, 3, 7, 11, 15);                                 \
+    WORK_G(r, 4, 0, 5, 10, 15);                                 \
+    WORK_G(r, 5, 1, 6, 11, 12);                                 \
+    WORK_G(r, 6, 2, 7,  8, 13);                                 \
+    WORK_G(r, 7, 3, 4,  9, 14);                                 \
+  } while (0)
+
+void work_value_interleaved(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values) {
+  const uint64_t h0 = COMPRESS_IV[0] ^ COMPRESS_PARAM(WORK_HASH_LENGTH);
+
+  uint64_t ma[16] = { 0 };
+  uint64_t mb[16] = { 0 };
+  ma[0] = work;
+  mb[0] = work + 1;
+  for (unsigned int i = 0; i < 4; i++) {
+    ma[1 + i] = block_hash_words[i];
+    mb[1 + i] = block_hash_words[i];
+  }
+
+  uint64_t va[16];
+  va[0] = h0;
+  for (unsigned int i = 1; i < 8; i++) va[i] = COMPRESS_IV[i];
+  for (unsigned int i = 0; i < 8; i++) va[8 + i] = COMPRESS_IV[i];
+  va[12] ^= WORK_LENGTH + BLOCK_HASH_LENGTH; /* counter */
+  va[14] = ~va[14]; /* last block */
+
+  uint64_t vb[16];
+  memcpy(vb, va, sizeof(vb));
+
+  WORK_ROUND(0);
+  WORK_ROUND(1);
+  WORK_ROUND(2);
+  WORK_ROUND(3);
+  WORK_ROUND(4);
+  WORK_ROUND(5);
+  WORK_ROUND(6);
+  WORK_ROUND(7);
+  WORK_ROUND(8);
+  WORK_ROUND(9);
+  WORK_ROUND(10);
+  WORK_ROUND(11);
+
+  values[0] = h0 ^ va[0] ^ va[8];
+  values[1] = h0 ^ vb[0] ^ vb[8];
+}
+
+#if defined(__SSE4_1__)
+/*
+  With SIMD, the vendored SSE round macros already spread each G function
+  over two vector registers, so a single nonce is evaluated at a time.
+*/
+#define WORK_LANES 1
+static void work_values(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values) {
+  const uint64_t h0 = COMPRESS_IV[0] ^ COMPRESS_PARAM(WORK_HASH_LENGTH);
+
+  __m128i row1l, row1h;
+  __m128i row2l, row2h;
+  __m128i row3l, row3h;
+  __m128i row4l, row4h;
+  __m128i b0, b1;
+  __m128i t0, t1;
+  const __m128i r16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+  const __m128i r24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+
+  const __m128i m0 = _mm_set_epi64x((long long) block_hash_words[0], (long long) work);
+  const __m128i m1 = _mm_set_epi64x((long long) block_hash_words[2], (long long) block_hash_words[1]);
+  const __m128i m2 = _mm_set_epi64x(0, (long long) block_hash_words[3]);
+  const __m128i m3 = _mm_setzero_si128();
+  const __m128i m4 = _mm_setzero_si128();
+  const __m128i m5 = _mm_setzero_si128();
+  const __m128i m6 = _mm_setzero_si128();
+  const __m128i m7 = _mm_setzero_si128();
+
+  row1l = _mm_set_epi64x((long long) COMPRESS_IV[1], (long long) h0);
+  row1h = _mm_set_epi64x((long long) COMPRESS_IV[3], (long long) COMPRESS_IV[2]);
+  row2l = _mm_set_epi64x((long long) COMPRESS_IV[5], (long long) COMPRESS_IV[4]);
+  row2h = _mm_set_epi64x((long long) COMPRESS_IV[7], (long long) COMPRESS_IV[6]);
+  row3l = _mm_set_epi64x((long long) COMPRESS_IV[1], (long long) COMPRESS_IV[0]);
+  row3h = _mm_set_epi64x((long long) COMPRESS_IV[3], (long long) COMPRESS_IV[2]);
+  row4l = _mm_set_epi64x((long long) COMPRESS_IV[5], (long long) (COMPRESS_IV[4] ^ (WORK_LENGTH + BLOCK_HASH_LENGTH)));
+  row4h = _mm_set_epi64x((long long) COMPRESS_IV[7], (long long) ~COMPRESS_IV[6]);
+
+  ROUND(0);
+  ROUND(1);
+  ROUND(2);
+  ROUND(3);
+  ROUND(4);
+  ROUND(5);
+  ROUND(6);
+  ROUND(7);
+  ROUND(8);
+  ROUND(9);
+  ROUND(10);
+  ROUND(11);
+
+  uint64_t row1[2];
+  STOREU(row1, _mm_xor_si128(row3l, row1l));
+  values[0] = h0 ^ row1[0];
+}
+#else
+#define WORK_LANES 2
+static void work_values(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values) {
+  work_value_interleaved(block_hash_words, work, values);
+}
+#endif
+
+static const uint64_t MIN_UINT64 = 0x0000000000000000;
+static const uint64_t MAX_UINT64 = 0xffffffffffffffff;
+void work_bounds(const uint8_t worker_index, const uint8_t worker_count, uint64_t* const lower_bound, uint64_t* const upper_bound) {
+  const uint64_t interval = (MAX_UINT64 - MIN_UINT64) / worker_count;
+
+  *lower_bound = MIN_UINT64 + (worker_index * interval);
+  *upper_bound = (worker_index != worker_count - 1) ? *lower_bound + interval : MAX_UINT64;
+}
+
+void work_chunk(const uint8_t* const block_hash, uint64_t work_threshold, const uint64_t start, const uint64_t end, uint8_t* const dst) {
+  uint64_t block_hash_words[4];
+  for (unsigned int i = 0; i < 4; i++) {
+    block_hash_words[i] = bytes_to_uint64(block_hash + (8 * i));
+  }
+
+  uint64_t work = start;
+  uint64_t best = 0;
+  uint8_t found = 0;
+
+  memset(dst, 0, WORK_CHUNK_RESULT_LENGTH);
+
+  while (work != end && !found) {
+    uint64_t values[WORK_LANES];
+    work_values(block_hash_words, work, values);
+
+    /* the last nonces can be past the end of the range */
+    const unsigned int lanes = (end - work < WORK_LANES) ? (unsigned int) (end - work) : WORK_LANES;
+    for (unsigned int lane = 0; lane < lanes; lane++) {
+      if (values[lane] > best) best = values[lane];
+
+      work++;
+
+      if (values[lane] >= work_threshold) {
+        dst[0] = 1;
+        uint64_to_big_endian_bytes(work - 1, dst + 1);
+        found = 1;
+        break;
+      }
+    }
+  }
+
+  uint64_to_big_endian_bytes(best, dst + 1 + WORK_LENGTH);
+
+  const uint32_t scanned = (uint32_t) (work - start);
+  dst[17] = (uint8_t) (scanned >> 24);
+  dst[18] = (uint8_t) (scanned >> 16);
+  dst[19] = (uint8_t) (scanned >> 8);
+  dst[20] = (uint8_t) scanned;
+}
@@ -0,0 +1,35 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+#ifndef NANOCURRENCY_WORK_H
+#define NANOCURRENCY_WORK_H
+
+#include <stdint.h>
+
+#define BLOCK_HASH_LENGTH 32
+#define WORK_LENGTH 8
+#define WORK_HASH_LENGTH 8
+
+/* found flag + work + best work value + count of nonces scanned */
+#define WORK_CHUNK_RESULT_LENGTH (1 + WORK_LENGTH + WORK_HASH_LENGTH + 4)
+
+/* Work value of a single nonce, through the generic BLAKE2b API. */
+uint64_t work_value(const uint8_t* const block_hash, const uint8_t* const work);
+uint8_t validate_work(const uint8_t* const block_hash, uint64_t work_threshold, const uint8_t* const work);
+
+/* Work values of two consecutive nonces, evaluated in lockstep. */
+void work_value_interleaved(const uint64_t* const block_hash_words, const uint64_t work, uint64_t* const values);
+
+void work_bounds(const uint8_t worker_index, const uint8_t worker_count, uint64_t* const lower_bound, uint64_t* const upper_bound);
+
+/*
+  Scan the nonces in [start, end), stopping at the first one meeting the threshold.
+
+  dst is filled with the found flag, the work, the best work value seen
+  and the count of nonces scanned, all big endian.
+*/
+void work_chunk(const uint8_t* const block_hash, uint64_t work_threshold, const uint64_t start, const uint64_t end, uint8_t* const dst);
+
+#endif
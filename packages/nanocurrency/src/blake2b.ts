@@ -0,0 +1,298 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import {
+  AssemblyWhenLoaded,
+  BATCH_BUFFER_LENGTH,
+  loadWasm,
+} from './accelerated'
+
+/** Incremental BLAKE2b hashing, see [[createBlake2bContext]]. */
+export interface Blake2bContext {
+  /**
+   * Feed bytes to the hash.
+   *
+   * @param data - The bytes to feed
+   * @returns The context itself
+   */
+  update(data: Uint8Array): Blake2bContext
+  /**
+   * Copy the context, to hash several messages sharing what was fed so far
+   * without hashing it again.
+   *
+   * @returns A new context, independent from this one
+   */
+  fork(): Blake2bContext
+  /**
+   * Hash everything fed so far. The context can still be fed afterwards.
+   *
+   * @returns Hash
+   */
+  digest(): Uint8Array
+}
+
+/** Count of leaves of BLAKE2bp, hence of threads it can be spread on. */
+const BLAKE2BP_LEAVES = 4
+/** Leaves take turns hashing the 128 bytes blocks of a stripe. */
+const BLAKE2BP_STRIPE_LENGTH = BLAKE2BP_LEAVES * 128
+const BLAKE2BP_LEAF_HASH_LENGTH = 64
+
+function checkBlake2bParams(outputLength: number, key?: Uint8Array): void {
+  if (
+    !Number.isInteger(outputLength) ||
+    outputLength < 1 ||
+    outputLength > 64
+  ) {
+    throw new Error('Output length is not valid')
+  }
+  if (
+    typeof key !== 'undefined' &&
+    (!(key instanceof Uint8Array) || key.length > 64)
+  ) {
+    throw new Error('Key is not valid')
+  }
+}
+
+function createContext(
+  assembly: AssemblyWhenLoaded,
+  state: Uint8Array,
+  outputLength: number
+): Blake2bContext {
+  // the state is kept on the JavaScript side, and copied to the start of the
+  // batch buffer for every operation
+  const statePointer = assembly.batchPointer
+  const dataPointer = statePointer + assembly.blake2bStateLength
+  const maxDataLength = BATCH_BUFFER_LENGTH - assembly.blake2bStateLength
+
+  const context: Blake2bContext = {
+    update: data => {
+      if (!(data instanceof Uint8Array)) throw new Error('Data is not valid')
+
+      assembly.heap.set(state, statePointer)
+      for (let offset = 0; offset < data.length; offset += maxDataLength) {
+        const chunk = data.subarray(offset, offset + maxDataLength)
+        assembly.heap.set(chunk, dataPointer)
+        assembly.blake2bUpdate(statePointer, dataPointer, chunk.length)
+      }
+      state.set(
+        assembly.heap.subarray(
+          statePointer,
+          statePointer + assembly.blake2bStateLength
+        )
+      )
+
+      return context
+    },
+    fork: () => createContext(assembly, state.slice(), outputLength),
+    digest: () => {
+      assembly.heap.set(state, statePointer)
+      assembly.blake2bFinal(statePointer, dataPointer)
+
+      return assembly.heap.slice(dataPointer, dataPointer + outputLength)
+    },
+  }
+
+  return context
+}
+
+/**
+ * Create an incremental BLAKE2b hashing context, whose state can be forked
+ * to hash many messages sharing a prefix (a seed, a preamble) at the cost
+ * of their suffix only.
+ * Require WebAssembly support.
+ *
+ * @param outputLength - The length of the hash, between 1 and 64 bytes
+ * @param key - An optional key, up to 64 bytes
+ * @returns Context
+ */
+export async function createBlake2bContext(
+  outputLength: number,
+  key?: Uint8Array
+): Promise<Blake2bContext> {
+  const assembly = await loadWasm()
+  checkBlake2bParams(outputLength, key)
+
+  const statePointer = assembly.batchPointer
+  const keyPointer = statePointer + assembly.blake2bStateLength
+  const keyLength = key ? key.length : 0
+  if (key) assembly.heap.set(key, keyPointer)
+  assembly.blake2bInit(statePointer, outputLength, keyPointer, keyLength)
+
+  const state = assembly.heap.slice(
+    statePointer,
+    statePointer + assembly.blake2bStateLength
+  )
+
+  return createContext(assembly, state, outputLength)
+}
+
+/** One of the leaves of a BLAKE2bp hash, see [[createBlake2bpLeaf]]. */
+export interface Blake2bpLeaf {
+  /**
+   * Feed a part of the message to the leaf, which only hashes its own
+   * blocks of it. Every part but the last must be a multiple of 512 bytes.
+   *
+   * @param data - The part of the message
+   * @returns The leaf itself
+   */
+  update(data: Uint8Array): Blake2bpLeaf
+  /**
+   * Hash of the leaf, to give to [[blake2bpRoot]].
+   *
+   * @returns 64 bytes leaf hash
+   */
+  digest(): Uint8Array
+}
+
+/**
+ * Create one of the four leaves of a BLAKE2bp hash. Every leaf is fed the
+ * whole message, and can be run on its own thread.
+ * Require WebAssembly support.
+ *
+ * @param outputLength - The length of the final hash, between 1 and 64 bytes
+ * @param index - The index of the leaf, between 0 and 3
+ * @param key - An optional key, up to 64 bytes
+ * @returns Leaf
+ */
+export async function createBlake2bpLeaf(
+  outputLength: number,
+  index: number,
+  key?: Uint8Array
+): Promise<Blake2bpLeaf> {
+  const assembly = await loadWasm()
+  checkBlake2bParams(outputLength, key)
+  if (!Number.isInteger(index) || index < 0 || index >= BLAKE2BP_LEAVES) {
+    throw new Error('Index is not valid')
+  }
+
+  const stateLength = assembly.blake2bStateLength
+  const statePointer = assembly.batchPointer
+  const dataPointer = statePointer + stateLength
+  // parts must stay aligned on stripes
+  const maxDataLength =
+    BATCH_BUFFER_LENGTH -
+    stateLength -
+    ((BATCH_BUFFER_LENGTH - stateLength) % BLAKE2BP_STRIPE_LENGTH)
+
+  if (key) assembly.heap.set(key, dataPointer)
+  assembly.blake2bpLeafInit(
+    statePointer,
+    outputLength,
+    index,
+    dataPointer,
+    key ? key.length : 0
+  )
+  const state = assembly.heap.slice(statePointer, statePointer + stateLength)
+  let ended = false
+
+  const leaf: Blake2bpLeaf = {
+    update: data => {
+      if (!(data instanceof Uint8Array) || (ended && data.length > 0)) {
+        throw new Error('Data is not valid')
+      }
+      // an empty part does not reopen an ended leaf
+      ended = ended || data.length % BLAKE2BP_STRIPE_LENGTH !== 0
+
+      assembly.heap.set(state, statePointer)
+      for (let offset = 0; offset < data.length; offset += maxDataLength) {
+        const chunk = data.subarray(offset, offset + maxDataLength)
+        assembly.heap.set(chunk, dataPointer)
+        assembly.blake2bpLeafUpdate(
+          statePointer,
+          index,
+          dataPointer,
+          chunk.length
+        )
+      }
+      state.set(
+        assembly.heap.subarray(statePointer, statePointer + stateLength)
+      )
+
+      return leaf
+    },
+    digest: () => {
+      assembly.heap.set(state, statePointer)
+      assembly.blake2bpLeafFinal(statePointer, dataPointer)
+
+      return assembly.heap.slice(
+        dataPointer,
+        dataPointer + BLAKE2BP_LEAF_HASH_LENGTH
+      )
+    },
+  }
+
+  return leaf
+}
+
+/**
+ * Compute a BLAKE2bp hash from the hashes of its four leaves.
+ * Require WebAssembly support.
+ *
+ * @param leafHashes - The hashes of the leaves, in order
+ * @param outputLength - The length of the hash, between 1 and 64 bytes
+ * @param key - The key the leaves were created with, if any
+ * @returns Hash
+ */
+export async function blake2bpRoot(
+  leafHashes: Uint8Array[],
+  outputLength: number,
+  key?: Uint8Array
+): Promise<Uint8Array> {
+  const assembly = await loadWasm()
+  checkBlake2bParams(outputLength, key)
+  if (
+    !Array.isArray(leafHashes) ||
+    leafHashes.length !== BLAKE2BP_LEAVES ||
+    !leafHashes.every(
+      leafHash =>
+        leafHash instanceof Uint8Array &&
+        leafHash.length === BLAKE2BP_LEAF_HASH_LENGTH
+    )
+  ) {
+    throw new Error('Leaf hashes are not valid')
+  }
+
+  const leafHashesPointer = assembly.batchPointer
+  const hashPointer =
+    leafHashesPointer + BLAKE2BP_LEAVES * BLAKE2BP_LEAF_HASH_LENGTH
+  leafHashes.forEach((leafHash, index) =>
+    assembly.heap.set(
+      leafHash,
+      leafHashesPointer + index * BLAKE2BP_LEAF_HASH_LENGTH
+    )
+  )
+  assembly.blake2bpRoot(
+    hashPointer,
+    outputLength,
+    key ? key.length : 0,
+    leafHashesPointer
+  )
+
+  return assembly.heap.slice(hashPointer, hashPointer + outputLength)
+}
+
+/**
+ * Compute a BLAKE2bp hash, its leaves one after the other. Use
+ * [[createBlake2bpLeaf]] to spread them on threads instead.
+ * Require WebAssembly support.
+ *
+ * @param data - The message
+ * @param outputLength - The length of the hash, between 1 and 64 bytes
+ * @param key - An optional key, up to 64 bytes
+ * @returns Hash
+ */
+export async function blake2bp(
+  data: Uint8Array,
+  outputLength: number,
+  key?: Uint8Array
+): Promise<Uint8Array> {
+  const leafHashes: Uint8Array[] = []
+  for (let index = 0; index < BLAKE2BP_LEAVES; index++) {
+    const leaf = await createBlake2bpLeaf(outputLength, index, key)
+    leafHashes.push(leaf.update(data).digest())
+  }
+
+  return blake2bpRoot(leafHashes, outputLength, key)
+}
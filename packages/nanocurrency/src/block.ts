@@ -5,11 +5,15 @@
  */
 import { checkAddress, checkAmount, checkHash, checkKey } from './check'
 
-import { deriveAddress, derivePublicKey } from './keys'
+import { unsafeDeriveCachedAddress, unsafeDerivePublicKey } from './keys'
 
-import { unsafeHashBlock } from './hash'
+import { unsafeCreateBlockPreimage, unsafeHashBlockBytes } from './hash'
 
-import { signBlock } from './signature'
+import { parseAddress } from './parse'
+
+import { unsafeSignBlock } from './signature'
+
+import { byteArrayToHex, defineLazyProperty, hexToByteArray } from './utils'
 
 const BLANK_HASH =
   '0000000000000000000000000000000000000000000000000000000000000000'
@@ -63,6 +67,10 @@ export interface BlockRepresentation {
   representative: string
   balance: string
   link: string
+  /**
+   * The link in address format. Unless the link was given as an address,
+   * it is only derived when first read
+   */
   link_as_account: string
   work: string | null
   signature: string
@@ -76,15 +84,38 @@ export interface Block {
   block: BlockRepresentation
 }
 
+/** @hidden */
+export interface AccountKeys {
+  secretKeyBytes: Uint8Array
+  /** In hexadecimal format */
+  publicKey: string
+  account: string
+}
+
 /**
- * Create a state block.
+ * Derive once what signing blocks for an account needs. The secret key is
+ * not validated.
  *
- * @param secretKey - The secret key to create the block from, in hexadecimal format
- * @param data - Block data
- * @returns Block
+ * @hidden
  */
-export function createBlock(secretKey: string, data: BlockData): Block {
-  if (!checkKey(secretKey)) throw new Error('Secret key is not valid')
+export function unsafeDeriveAccountKeys(secretKey: string): AccountKeys {
+  const secretKeyBytes = hexToByteArray(secretKey)
+  const publicKey = byteArrayToHex(unsafeDerivePublicKey(secretKeyBytes))
+
+  return {
+    secretKeyBytes,
+    publicKey,
+    account: unsafeDeriveCachedAddress(publicKey),
+  }
+}
+
+/**
+ * Create a state block signed with already derived keys. The block data is
+ * validated, the keys are not.
+ *
+ * @hidden
+ */
+export function createBlockWithKeys(keys: AccountKeys, data: BlockData): Block {
   if (typeof data.work === 'undefined') throw new Error('Work is not set')
   if (!checkAddress(data.representative)) {
     throw new Error('Representative is not valid')
@@ -135,44 +166,149 @@ export function createBlock(secretKey: string, data: BlockData): Block {
     throw new Error('Block is impossible')
   }
 
-  const publicKey = derivePublicKey(secretKey)
-  const account = deriveAddress(publicKey)
-  // we use unsafeHashBlock because we already
-  // checked the input
-  const hash = unsafeHashBlock({
-    account,
-    previous: correctedPrevious,
-    representative: data.representative,
-    balance: data.balance,
-    link: correctedLink,
-  })
-  const signature = signBlock({ hash, secretKey })
-
-  let link
-  let linkAsAddress
-  if (linkIsAddress) {
-    linkAsAddress = correctedLink
-    link = derivePublicKey(linkAsAddress)
-  } else {
-    link = correctedLink
-    linkAsAddress = deriveAddress(link)
-  }
+  // the inputs are checked, so that everything below is unchecked
+  const hashBytes = unsafeHashBlockBytes(
+    unsafeCreateBlockPreimage({
+      account: keys.account,
+      previous: correctedPrevious,
+      representative: data.representative,
+      balance: data.balance,
+      link: correctedLink,
+    })
+  )
+  const hash = byteArrayToHex(hashBytes)
+  const signature = byteArrayToHex(
+    unsafeSignBlock(hashBytes, keys.secretKeyBytes)
+  )
+
+  const link = linkIsAddress
+    ? byteArrayToHex(parseAddress(correctedLink).publicKeyBytes as Uint8Array)
+    : correctedLink
 
-  const block: BlockRepresentation = {
+  // receive, open and change blocks seldom need their link as an address,
+  // so it is not encoded until read
+  const block = {
     type: 'state',
-    account,
+    account: keys.account,
     previous: correctedPrevious,
     representative: data.representative,
     balance: data.balance,
     link,
-    // eslint-disable-next-line @typescript-eslint/camelcase
-    link_as_account: linkAsAddress,
-    work: data.work,
-    signature,
-  }
+  } as BlockRepresentation
+  defineLazyProperty(block, 'link_as_account', () =>
+    linkIsAddress ? correctedLink : unsafeDeriveCachedAddress(link)
+  )
+  block.work = data.work
+  block.signature = signature
 
   return {
     hash,
     block,
   }
 }
+
+/**
+ * Create a state block.
+ *
+ * @param secretKey - The secret key to create the block from, in hexadecimal format
+ * @param data - Block data
+ * @returns Block
+ */
+export function createBlock(secretKey: string, data: BlockData): Block {
+  if (!checkKey(secretKey)) throw new Error('Secret key is not valid')
+
+  return createBlockWithKeys(unsafeDeriveAccountKeys(secretKey), data)
+}
+
+/** Bulk block creation item. */
+export interface CreateBlocksItem {
+  /** The secret key to create the block from, in hexadecimal format */
+  secretKey: string
+  /** Block data */
+  data: BlockData
+}
+
+/** Bulk block creation parameters. */
+export interface CreateBlocksParams {
+  /** The current worker index, starting at 0 */
+  workerIndex?: number
+  /** The count of worker */
+  workerCount?: number
+  /**
+   * Precomputed works, by block root in uppercase hexadecimal format: the
+   * previous block hash, or the public key for an open block. Used for the
+   * blocks whose work is `null`
+   */
+  works?: Map<string, string>
+}
+
+/**
+ * Create state blocks in bulk, for many accounts. The keys of a secret key
+ * given several times are derived once.
+ *
+ * The work can be spread across workers, each one creating its own slice
+ * of the blocks: concatenating the results of the workers, in order, gives
+ * the blocks of all the items.
+ *
+ * @param items - The secret keys and data of the blocks
+ * @param params - Parameters
+ * @returns Blocks of the slice of the current worker, in order
+ */
+export function createBlocks(
+  items: CreateBlocksItem[],
+  params: CreateBlocksParams = {}
+): Block[] {
+  const { workerIndex = 0, workerCount = 1, works } = params
+
+  if (!Array.isArray(items)) throw new Error('Items are not valid')
+  if (
+    !Number.isInteger(workerIndex) ||
+    !Number.isInteger(workerCount) ||
+    workerIndex < 0 ||
+    workerCount < 1 ||
+    workerIndex > workerCount - 1
+  ) {
+    throw new Error('Worker parameters are not valid')
+  }
+  if (typeof works !== 'undefined' && !(works instanceof Map)) {
+    throw new Error('Works are not valid')
+  }
+
+  const start = Math.floor((items.length * workerIndex) / workerCount)
+  const end = Math.floor((items.length * (workerIndex + 1)) / workerCount)
+  const keysBySecretKey = new Map<string, AccountKeys>()
+  const blocks: Block[] = []
+
+  for (let index = start; index < end; index++) {
+    const item = items[index]
+    if (
+      typeof item !== 'object' ||
+      item === null ||
+      typeof item.data !== 'object' ||
+      item.data === null
+    ) {
+      throw new Error('Items are not valid')
+    }
+    const { secretKey, data } = item
+
+    let keys = keysBySecretKey.get(secretKey)
+    if (!keys) {
+      if (!checkKey(secretKey)) throw new Error('Secret key is not valid')
+      keys = unsafeDeriveAccountKeys(secretKey)
+      keysBySecretKey.set(secretKey, keys)
+    }
+
+    let work = data.work
+    if (work === null && works) {
+      const root =
+        data.previous === null || data.previous === BLANK_HASH
+          ? keys.publicKey
+          : data.previous
+      work = works.get(String(root).toUpperCase()) ?? null
+    }
+
+    blocks.push(createBlockWithKeys(keys, { ...data, work }))
+  }
+
+  return blocks
+}
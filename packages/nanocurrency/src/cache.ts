@@ -0,0 +1,105 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+
+/** Usage of a cache since it was created or cleared. */
+export interface CacheStats {
+  /** The count of lookups answered from the cache */
+  hits: number
+  /** The count of lookups that had to be computed */
+  misses: number
+  /** The count of entries currently cached */
+  size: number
+  /** The maximum count of entries, the least recently used being evicted */
+  capacity: number
+}
+
+/** Usage of the address caches, see [[getAddressCacheStats]]. */
+export interface AddressCacheStats {
+  /** Address to public key, when parsing or checking an address */
+  publicKeys: CacheStats
+  /** Public key to address, when deriving an address */
+  addresses: CacheStats
+}
+
+/** @hidden */
+export interface LruCache<V> {
+  get(key: string): V | undefined
+  set(key: string, value: V): void
+  stats(): CacheStats
+  clear(): void
+}
+
+/** @hidden */
+export function createLruCache<V>(capacity: number): LruCache<V> {
+  // a Map iterates in insertion order, so re-inserting an entry on every hit
+  // keeps the least recently used one first
+  const entries = new Map<string, V>()
+  let hits = 0
+  let misses = 0
+
+  return {
+    get: key => {
+      const value = entries.get(key)
+      if (typeof value === 'undefined') {
+        misses++
+        return undefined
+      }
+
+      hits++
+      entries.delete(key)
+      entries.set(key, value)
+
+      return value
+    },
+    set: (key, value) => {
+      entries.delete(key)
+      entries.set(key, value)
+      if (entries.size > capacity) {
+        entries.delete(entries.keys().next().value)
+      }
+    },
+    stats: () => ({ hits, misses, size: entries.size, capacity }),
+    clear: () => {
+      entries.clear()
+      hits = 0
+      misses = 0
+    },
+  }
+}
+
+/**
+ * Count of addresses kept by each cache, far more than the accounts and
+ * representatives usually involved in bulk block creation.
+ */
+const ADDRESS_CACHE_CAPACITY = 1024
+
+/** @hidden */
+export const PUBLIC_KEY_CACHE = createLruCache<Uint8Array>(
+  ADDRESS_CACHE_CAPACITY
+)
+/** @hidden */
+export const ADDRESS_CACHE = createLruCache<string>(ADDRESS_CACHE_CAPACITY)
+
+/**
+ * Get the hit and miss counts of the caches of decoded addresses and derived
+ * addresses, used when checking addresses, hashing and creating blocks.
+ *
+ * @returns Stats
+ */
+export function getAddressCacheStats(): AddressCacheStats {
+  return {
+    publicKeys: PUBLIC_KEY_CACHE.stats(),
+    addresses: ADDRESS_CACHE.stats(),
+  }
+}
+
+/**
+ * Empty the address caches, and reset their stats.
+ */
+export function clearAddressCaches(): void {
+  PUBLIC_KEY_CACHE.clear()
+  ADDRESS_CACHE.clear()
+}
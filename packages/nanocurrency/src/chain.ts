@@ -0,0 +1,154 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import {
+  Block,
+  BlockData,
+  createBlockWithKeys,
+  unsafeDeriveAccountKeys,
+} from './block'
+
+import { checkAddress, checkAmount, checkHash, checkKey } from './check'
+
+/** Account chain parameters. */
+export interface AccountChainParams {
+  /** The hash of the last block of the account chain, or `null` if the account is not opened yet */
+  frontier: string | null
+  /** The balance of the account, in raw */
+  balance: string
+  /** The representative address */
+  representative: string
+  /**
+   * Compute the work of a block hash, or of the public key for an open block.
+   * Called as soon as a frontier is known, before its block is returned: it
+   * should hand the hash to a worker, [[computeWork]] on the calling thread
+   * holding back every block until the work of the next one is found
+   */
+  computeWork: (hash: string) => Promise<string | null>
+}
+
+/** Account chain block data. */
+export interface AccountChainBlockData {
+  /** The resulting balance, in raw */
+  balance: string
+  /**
+   * The destination address of a send block, the pairing send block hash of
+   * a receive or open block, or `null` for a change block
+   */
+  link: string | null
+  /** The new representative address. Defaults to the current one */
+  representative?: string
+}
+
+/** Successive blocks of an account chain, see [[createAccountChain]]. */
+export interface AccountChain {
+  /** The account address */
+  readonly account: string
+  /** The account public key, in hexadecimal format */
+  readonly publicKey: string
+  /** The hash of the last block, or `null` if the account is not opened yet */
+  readonly frontier: string | null
+  /** The balance after the last block, in raw */
+  readonly balance: string
+  /** The representative after the last block */
+  readonly representative: string
+  /**
+   * Create and sign the next block, once the work of the frontier is
+   * computed, and start computing the work of the new frontier right away.
+   * Calls are queued, so that several blocks can be appended without
+   * waiting for each other.
+   *
+   * @param data - Block data
+   * @returns Block, which is the new frontier
+   */
+  append(data: AccountChainBlockData): Promise<Block>
+}
+
+type MutableAccountChain = {
+  -readonly [K in keyof AccountChain]: AccountChain[K]
+}
+
+/**
+ * Create a builder of successive state blocks for an account. The keys are
+ * derived once, and the work of each new frontier is computed as soon as
+ * it is known, so that it overlaps with broadcasting the previous block.
+ *
+ * @param secretKey - The secret key of the account, in hexadecimal format
+ * @param params - Parameters
+ * @returns Account chain
+ */
+export function createAccountChain(
+  secretKey: string,
+  params: AccountChainParams
+): AccountChain {
+  if (!checkKey(secretKey)) throw new Error('Secret key is not valid')
+  if (params.frontier !== null && !checkHash(params.frontier)) {
+    throw new Error('Frontier is not valid')
+  }
+  if (!checkAmount(params.balance)) throw new Error('Balance is not valid')
+  if (!checkAddress(params.representative)) {
+    throw new Error('Representative is not valid')
+  }
+  if (typeof params.computeWork !== 'function') {
+    throw new Error('Compute work is not valid')
+  }
+
+  const keys = unsafeDeriveAccountKeys(secretKey)
+
+  const startWork = (root: string): Promise<string | null> => {
+    // a synchronous throw rejects the work too, rather than escaping
+    const work = Promise.resolve().then(() => params.computeWork(root))
+    // the error is thrown by the next append, not left unhandled
+    work.catch(() => undefined)
+
+    return work
+  }
+
+  // the work of an open block is computed on the public key
+  let pendingWork = startWork(params.frontier ?? keys.publicKey)
+  let queue: Promise<unknown> = Promise.resolve()
+
+  const appendNow = async (data: AccountChainBlockData): Promise<Block> => {
+    let work: string | null
+    try {
+      work = await pendingWork
+    } catch (err) {
+      // retried by the next append
+      pendingWork = startWork(chain.frontier ?? keys.publicKey)
+      throw err
+    }
+
+    const block = createBlockWithKeys(keys, {
+      previous: chain.frontier,
+      link: data.link,
+      balance: data.balance,
+      representative: data.representative ?? chain.representative,
+      work,
+    } as BlockData)
+
+    chain.frontier = block.hash
+    chain.balance = block.block.balance
+    chain.representative = block.block.representative
+    pendingWork = startWork(block.hash)
+
+    return block
+  }
+
+  const chain: MutableAccountChain = {
+    account: keys.account,
+    publicKey: keys.publicKey,
+    frontier: params.frontier,
+    balance: params.balance,
+    representative: params.representative,
+    append: data => {
+      const block = queue.then(() => appendNow(data))
+      queue = block.catch(() => undefined)
+
+      return block
+    },
+  }
+
+  return chain
+}
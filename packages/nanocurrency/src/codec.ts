@@ -0,0 +1,319 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import { STATE_BLOCK_PREIMAGE_LENGTH } from './accelerated'
+
+import { BlockRepresentation } from './block'
+
+import {
+  checkAddress,
+  checkAmount,
+  checkHash,
+  checkSignature,
+  checkWork,
+} from './check'
+
+import { convert, Unit } from './conversion'
+
+import { unsafeHashBlockBytes } from './hash'
+
+import { unsafeDeriveCachedAddress } from './keys'
+
+import { parseAddress } from './parse'
+
+import { byteArrayToHex, hexToByteArray } from './utils'
+
+/**
+ * Length of an encoded state block: account, previous, representative,
+ * balance, link, signature and work, as the Nano node serializes them.
+ */
+export const STATE_BLOCK_LENGTH = 216
+
+/** The fields of an encoded state block, and their offset and size. */
+const FIELDS = {
+  account: [0, 32],
+  previous: [32, 32],
+  representative: [64, 32],
+  balance: [96, 16],
+  link: [112, 32],
+  signature: [144, 64],
+  work: [208, 8],
+}
+/** The fields hashed, after the preamble. */
+const HASHED_LENGTH = 144
+
+/**
+ * A state block read straight from its encoded bytes: the fields are only
+ * decoded when read, and the byte fields are views on the same buffer.
+ * Addresses are decoded with the `xrb_` prefix.
+ */
+export interface BlockView {
+  /** The 216 bytes of the block, a view on the underlying buffer */
+  readonly bytes: Uint8Array
+  readonly accountBytes: Uint8Array
+  readonly previousBytes: Uint8Array
+  readonly representativeBytes: Uint8Array
+  /** Big-endian */
+  readonly balanceBytes: Uint8Array
+  readonly linkBytes: Uint8Array
+  readonly signatureBytes: Uint8Array
+  /** Big-endian */
+  readonly workBytes: Uint8Array
+  /** The account address */
+  readonly account: string
+  /** In hexadecimal format */
+  readonly previous: string
+  /** The representative address */
+  readonly representative: string
+  /** In raw */
+  readonly balance: string
+  /** In hexadecimal format */
+  readonly link: string
+  /** In hexadecimal format */
+  readonly signature: string
+  /** In hexadecimal format */
+  readonly work: string
+  /**
+   * Hash the block.
+   *
+   * @returns Hash, in hexadecimal format
+   */
+  hash(): string
+  /**
+   * Decode every field of the block.
+   *
+   * @returns Block representation
+   */
+  toRepresentation(): BlockRepresentation
+}
+
+function field(bytes: Uint8Array, name: keyof typeof FIELDS): Uint8Array {
+  const [offset, size] = FIELDS[name]
+
+  return bytes.subarray(offset, offset + size)
+}
+
+const STATE_BLOCK_PREAMBLE_BYTES = new Uint8Array(32)
+STATE_BLOCK_PREAMBLE_BYTES[31] = 6
+
+// shared by every view, which only holds its bytes
+const BLOCK_VIEW_PROTOTYPE = {
+  hash(this: BlockView): string {
+    const preimage = new Uint8Array(STATE_BLOCK_PREIMAGE_LENGTH)
+    preimage.set(STATE_BLOCK_PREAMBLE_BYTES, 0)
+    preimage.set(this.bytes.subarray(0, HASHED_LENGTH), 32)
+
+    return byteArrayToHex(unsafeHashBlockBytes(preimage))
+  },
+  toRepresentation(this: BlockView): BlockRepresentation {
+    const link = this.link
+
+    return {
+      type: 'state',
+      account: this.account,
+      previous: this.previous,
+      representative: this.representative,
+      balance: this.balance,
+      link,
+      // eslint-disable-next-line @typescript-eslint/camelcase
+      link_as_account: unsafeDeriveCachedAddress(link),
+      work: this.work,
+      signature: this.signature,
+    }
+  },
+}
+
+function defineViewField<K extends keyof BlockView>(
+  name: K,
+  read: (bytes: Uint8Array) => BlockView[K]
+): void {
+  Object.defineProperty(BLOCK_VIEW_PROTOTYPE, name, {
+    get(this: BlockView) {
+      return read(this.bytes)
+    },
+  })
+}
+
+defineViewField('accountBytes', bytes => field(bytes, 'account'))
+defineViewField('previousBytes', bytes => field(bytes, 'previous'))
+defineViewField('representativeBytes', bytes => field(bytes, 'representative'))
+defineViewField('balanceBytes', bytes => field(bytes, 'balance'))
+defineViewField('linkBytes', bytes => field(bytes, 'link'))
+defineViewField('signatureBytes', bytes => field(bytes, 'signature'))
+defineViewField('workBytes', bytes => field(bytes, 'work'))
+defineViewField('account', bytes =>
+  unsafeDeriveCachedAddress(byteArrayToHex(field(bytes, 'account')))
+)
+defineViewField('previous', bytes => byteArrayToHex(field(bytes, 'previous')))
+defineViewField('representative', bytes =>
+  unsafeDeriveCachedAddress(byteArrayToHex(field(bytes, 'representative')))
+)
+defineViewField('balance', bytes =>
+  convert(byteArrayToHex(field(bytes, 'balance')), {
+    from: Unit.hex,
+    to: Unit.raw,
+  })
+)
+defineViewField('link', bytes => byteArrayToHex(field(bytes, 'link')))
+defineViewField('signature', bytes => byteArrayToHex(field(bytes, 'signature')))
+defineViewField('work', bytes =>
+  byteArrayToHex(field(bytes, 'work')).toLowerCase()
+)
+
+/**
+ * View the state block encoded at an offset of a buffer, without copying
+ * nor decoding it.
+ *
+ * @param buffer - The buffer holding the encoded block, see [[encodeBlock]]
+ * @param offset - The offset of the block in the buffer. Defaults to `0`
+ * @returns View
+ */
+export function viewBlock(buffer: Uint8Array, offset = 0): BlockView {
+  if (!(buffer instanceof Uint8Array)) throw new Error('Buffer is not valid')
+  if (
+    !Number.isInteger(offset) ||
+    offset < 0 ||
+    offset + STATE_BLOCK_LENGTH > buffer.length
+  ) {
+    throw new Error('Offset is not valid')
+  }
+
+  const view = Object.create(BLOCK_VIEW_PROTOTYPE)
+  view.bytes = buffer.subarray(offset, offset + STATE_BLOCK_LENGTH)
+
+  return view
+}
+
+/**
+ * Encode a state block into its 216 bytes binary layout: account,
+ * previous, representative, balance, link, signature and work, all
+ * big-endian. A `null` work is encoded as zeroes.
+ *
+ * @param block - The block to encode
+ * @param buffer - The buffer to encode the block to. Defaults to a new buffer
+ * @param offset - The offset to encode the block at. Defaults to `0`
+ * @returns Buffer
+ */
+export function encodeBlock(
+  block: BlockRepresentation,
+  buffer: Uint8Array = new Uint8Array(STATE_BLOCK_LENGTH),
+  offset = 0
+): Uint8Array {
+  if (typeof block !== 'object' || block === null) {
+    throw new Error('Block is not valid')
+  }
+  if (!checkAddress(block.account)) throw new Error('Account is not valid')
+  if (!checkHash(block.previous)) throw new Error('Previous is not valid')
+  if (!checkAddress(block.representative)) {
+    throw new Error('Representative is not valid')
+  }
+  if (!checkAmount(block.balance)) throw new Error('Balance is not valid')
+  if (!checkHash(block.link)) throw new Error('Link is not valid')
+  if (!checkSignature(block.signature)) {
+    throw new Error('Signature is not valid')
+  }
+  if (block.work !== null && !checkWork(block.work)) {
+    throw new Error('Work is not valid')
+  }
+  if (!(buffer instanceof Uint8Array)) throw new Error('Buffer is not valid')
+  if (
+    !Number.isInteger(offset) ||
+    offset < 0 ||
+    offset + STATE_BLOCK_LENGTH > buffer.length
+  ) {
+    throw new Error('Offset is not valid')
+  }
+
+  const bytes = buffer.subarray(offset, offset + STATE_BLOCK_LENGTH)
+  const balanceHex = convert(block.balance, { from: Unit.raw, to: Unit.hex })
+
+  field(bytes, 'account').set(
+    parseAddress(block.account).publicKeyBytes as Uint8Array
+  )
+  field(bytes, 'previous').set(hexToByteArray(block.previous))
+  field(bytes, 'representative').set(
+    parseAddress(block.representative).publicKeyBytes as Uint8Array
+  )
+  field(bytes, 'balance').set(hexToByteArray(balanceHex))
+  field(bytes, 'link').set(hexToByteArray(block.link))
+  field(bytes, 'signature').set(hexToByteArray(block.signature))
+  if (block.work === null) field(bytes, 'work').fill(0)
+  else field(bytes, 'work').set(hexToByteArray(block.work))
+
+  return buffer
+}
+
+/**
+ * Decode a state block from its binary layout, see [[encodeBlock]].
+ *
+ * @param buffer - The buffer holding the encoded block
+ * @param offset - The offset of the block in the buffer. Defaults to `0`
+ * @returns Block representation
+ */
+export function decodeBlock(
+  buffer: Uint8Array,
+  offset = 0
+): BlockRepresentation {
+  return viewBlock(buffer, offset).toRepresentation()
+}
+
+/**
+ * Whole blocks out of a stream of encoded blocks split anywhere, see
+ * [[createBlockAligner]].
+ *
+ * @hidden
+ */
+export interface BlockAligner {
+  /** The length of the block cut at the end of the last chunk */
+  readonly pendingLength: number
+  /**
+   * @param chunk - Encoded blocks, split anywhere
+   * @returns Up to two runs of whole blocks: the block cut by the previous
+   * chunk, valid until the next update, then the blocks of this chunk
+   */
+  update(chunk: Uint8Array): Uint8Array[]
+}
+
+/**
+ * Create an aligner of encoded blocks on whole blocks. Only the tail of a
+ * block cut between two chunks is copied, the chunks being viewed as is.
+ *
+ * @hidden
+ * @returns Aligner
+ */
+export function createBlockAligner(): BlockAligner {
+  // the completed block is handed out while the next one fills the other
+  let pending = new Uint8Array(STATE_BLOCK_LENGTH)
+  let completed = new Uint8Array(STATE_BLOCK_LENGTH)
+  let pendingLength = 0
+
+  return {
+    get pendingLength(): number {
+      return pendingLength
+    },
+    update: chunk => {
+      const runs: Uint8Array[] = []
+      let offset = 0
+      if (pendingLength > 0) {
+        offset = Math.min(STATE_BLOCK_LENGTH - pendingLength, chunk.length)
+        pending.set(chunk.subarray(0, offset), pendingLength)
+        pendingLength += offset
+        if (pendingLength < STATE_BLOCK_LENGTH) return runs
+
+        const block = pending
+        pending = completed
+        completed = block
+        runs.push(block)
+      }
+
+      const end = chunk.length - ((chunk.length - offset) % STATE_BLOCK_LENGTH)
+      if (end > offset) runs.push(chunk.subarray(offset, end))
+      pending.set(chunk.subarray(end))
+      pendingLength = chunk.length - end
+
+      return runs
+    },
+  }
+}
@@ -3,7 +3,13 @@
  * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
  * Licensed under GPL-3.0 (https://git.io/vAZsK)
  */
-import { blake2bFinal, blake2bInit, blake2bUpdate } from 'blakejs'
+import { blake2b } from 'blakejs'
+
+import {
+  STATE_BLOCK_HASH_LENGTH,
+  STATE_BLOCK_PREIMAGE_LENGTH,
+  unsafeHashBlockPreimage,
+} from './accelerated'
 
 import { checkAddress, checkAmount, checkHash } from './check'
 
@@ -11,7 +17,7 @@ import { convert, Unit } from './conversion'
 
 import { byteArrayToHex, hexToByteArray } from './utils'
 
-import { derivePublicKey } from './keys'
+import { parseAddress } from './parse'
 
 const STATE_BLOCK_PREAMBLE_BYTES = new Uint8Array(32)
 STATE_BLOCK_PREAMBLE_BYTES[31] = 6
@@ -38,41 +44,49 @@ export interface HashBlockParams {
   link: string
 }
 
+function publicKeyBytes(address: string): Uint8Array {
+  return parseAddress(address).publicKeyBytes as Uint8Array
+}
+
 /** @hidden */
-export function unsafeHashBlock(params: HashBlockParams): string {
-  const accountBytes = hexToByteArray(derivePublicKey(params.account))
-  const previousBytes = hexToByteArray(params.previous)
-  const representativeBytes = hexToByteArray(
-    derivePublicKey(params.representative)
-  )
+export function unsafeCreateBlockPreimage(params: HashBlockParams): Uint8Array {
+  const preimage = new Uint8Array(STATE_BLOCK_PREIMAGE_LENGTH)
   const balanceHex = convert(params.balance, { from: Unit.raw, to: Unit.hex })
-  const balanceBytes = hexToByteArray(balanceHex)
-  let linkBytes: Uint8Array
-  if (checkAddress(params.link)) {
-    linkBytes = hexToByteArray(derivePublicKey(params.link))
-  } else {
-    linkBytes = hexToByteArray(params.link)
-  }
+  // addresses are decoded through the address cache, straight to bytes
+  const linkAsAddress = parseAddress(params.link)
 
-  const context = blake2bInit(32)
-  blake2bUpdate(context, STATE_BLOCK_PREAMBLE_BYTES)
-  blake2bUpdate(context, accountBytes)
-  blake2bUpdate(context, previousBytes)
-  blake2bUpdate(context, representativeBytes)
-  blake2bUpdate(context, balanceBytes)
-  blake2bUpdate(context, linkBytes)
-  const hashBytes = blake2bFinal(context)
+  preimage.set(STATE_BLOCK_PREAMBLE_BYTES, 0)
+  preimage.set(publicKeyBytes(params.account), 32)
+  preimage.set(hexToByteArray(params.previous), 64)
+  preimage.set(publicKeyBytes(params.representative), 96)
+  preimage.set(hexToByteArray(balanceHex), 128)
+  preimage.set(linkAsAddress.publicKeyBytes ?? hexToByteArray(params.link), 144)
 
-  return byteArrayToHex(hashBytes)
+  return preimage
 }
 
 /**
- * Hash a state block.
+ * Hash a state block, packed into its preimage.
  *
- * @param params - Parameters
- * @returns Hash, in hexadecimal format
+ * **Unchecked:** the preimage is not validated, use [[hashBlockPreimage]]
+ * unless it already is, as when made by [[createBlockPreimage]].
+ *
+ * @param preimage - The 176 bytes preimage
+ * @returns 32 bytes hash
  */
-export function hashBlock(params: HashBlockParams): string {
+export function unsafeHashBlockBytes(preimage: Uint8Array): Uint8Array {
+  return (
+    unsafeHashBlockPreimage(preimage) ??
+    blake2b(preimage, null, STATE_BLOCK_HASH_LENGTH)
+  )
+}
+
+/** @hidden */
+export function unsafeHashBlock(params: HashBlockParams): string {
+  return byteArrayToHex(unsafeHashBlockBytes(unsafeCreateBlockPreimage(params)))
+}
+
+function checkHashBlockParams(params: HashBlockParams): void {
   if (!checkAddress(params.account)) throw new Error('Account is not valid')
   if (!checkHash(params.previous)) throw new Error('Previous is not valid')
   if (!checkAddress(params.representative)) {
@@ -82,6 +96,29 @@ export function hashBlock(params: HashBlockParams): string {
   if (!checkAddress(params.link) && !checkHash(params.link)) {
     throw new Error('Link is not valid')
   }
+}
+
+/**
+ * Pack a state block into its 176 bytes hash preimage: preamble, account,
+ * previous, representative, balance and link.
+ *
+ * @param params - Parameters
+ * @returns Preimage, to be hashed with [[hashBlockPreimage]]
+ */
+export function createBlockPreimage(params: HashBlockParams): Uint8Array {
+  checkHashBlockParams(params)
+
+  return unsafeCreateBlockPreimage(params)
+}
+
+/**
+ * Hash a state block.
+ *
+ * @param params - Parameters
+ * @returns Hash, in hexadecimal format
+ */
+export function hashBlock(params: HashBlockParams): string {
+  checkHashBlockParams(params)
 
   return unsafeHashBlock(params)
 }
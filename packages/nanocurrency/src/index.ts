@@ -6,7 +6,40 @@
 /**
  * @module NanoCurrency
  */
-export { computeWork, ComputeWorkParams } from './accelerated'
+export {
+  blake2bMulti,
+  BlockColumns,
+  BlockParser,
+  computeWork,
+  ComputeWorkParams,
+  createBlockMidstate,
+  createBlockParser,
+  hashBlockPreimage,
+  hashBlocks,
+  hashBlockSuffixes,
+  HashBlocksParams,
+  WorkProgress,
+} from './accelerated'
+export {
+  blake2bp,
+  Blake2bContext,
+  Blake2bpLeaf,
+  blake2bpRoot,
+  createBlake2bContext,
+  createBlake2bpLeaf,
+} from './blake2b'
+export {
+  AddressCacheStats,
+  CacheStats,
+  clearAddressCaches,
+  getAddressCacheStats,
+} from './cache'
+export {
+  AccountChain,
+  AccountChainBlockData,
+  AccountChainParams,
+  createAccountChain,
+} from './chain'
 export {
   Block,
   BlockData,
@@ -14,6 +47,9 @@ export {
   ChangeBlockData,
   CommonBlockData,
   createBlock,
+  createBlocks,
+  CreateBlocksItem,
+  CreateBlocksParams,
   OpenBlockData,
   ReceiveBlockData,
   SendBlockData,
@@ -29,19 +65,78 @@ export {
   checkThreshold,
   checkWork,
 } from './check'
+export {
+  BlockView,
+  decodeBlock,
+  encodeBlock,
+  STATE_BLOCK_LENGTH,
+  viewBlock,
+} from './codec'
 export { convert, ConvertParams, Unit } from './conversion'
-export { hashBlock, HashBlockParams } from './hash'
+export {
+  createBlockPreimage,
+  hashBlock,
+  HashBlockParams,
+  unsafeHashBlockBytes,
+} from './hash'
 export {
   deriveAddress,
   DeriveAddressParams,
   derivePublicKey,
   deriveSecretKey,
   generateSeed,
+  unsafeDeriveAddress,
+  unsafeDerivePublicKey,
+  unsafeDeriveSecretKey,
 } from './keys'
+export {
+  createLedgerVerifier,
+  LedgerFailure,
+  LedgerFailureReason,
+  LedgerReport,
+  LedgerThresholds,
+  LedgerVerifier,
+  LedgerVerifierParams,
+  verifyAccountChain,
+  VerifyAccountChainParams,
+  verifyBlocks,
+  VerifyBlocksParams,
+} from './ledger'
+export {
+  createReceivableScanner,
+  Receivable,
+  ReceivableScanner,
+} from './receivable'
 export {
   signBlock,
   SignBlockParams,
+  unsafeSignBlock,
+  unsafeVerifyBlock,
   verifyBlock,
   VerifyBlockParams,
 } from './signature'
-export { validateWork, ValidateWorkParams } from './work'
+export {
+  createSnapshotReader,
+  createSnapshotWriter,
+  SnapshotReader,
+  SnapshotSegment,
+  SnapshotWriter,
+  SnapshotWriterParams,
+} from './snapshot'
+export {
+  BlockStore,
+  createBlockStoreIndex,
+  openBlockStore,
+} from './store'
+export {
+  createWeightAggregator,
+  RepresentativeWeight,
+  WeightAggregator,
+  WeightAggregatorParams,
+  WeightReport,
+} from './weights'
+export {
+  unsafeValidateWork,
+  validateWork,
+  ValidateWorkParams,
+} from './work'
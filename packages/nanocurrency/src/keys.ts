@@ -8,6 +8,7 @@ import { checkIndex, checkKey, checkSeed } from './check'
 import { derivePublicFromSecret } from './nacl'
 import { encodeNanoBase32 } from './nano-base32'
 import { parseAddress } from './parse'
+import { ADDRESS_CACHE } from './cache'
 import { byteArrayToHex, getRandomBytes, hexToByteArray } from './utils'
 
 /**
@@ -29,6 +30,32 @@ export function generateSeed(): Promise<string> {
   })
 }
 
+/**
+ * Derive a secret key from a seed, given an index.
+ *
+ * **Unchecked:** the seed and the index are not validated, use
+ * [[deriveSecretKey]] unless they already are.
+ *
+ * @param seedBytes - The 32 bytes seed
+ * @param index - The index, between 0 and 2^32 - 1
+ * @returns 32 bytes secret key
+ */
+export function unsafeDeriveSecretKey(
+  seedBytes: Uint8Array,
+  index: number
+): Uint8Array {
+  const indexBuffer = new ArrayBuffer(4)
+  const indexView = new DataView(indexBuffer)
+  indexView.setUint32(0, index)
+  const indexBytes = new Uint8Array(indexBuffer)
+
+  const context = blake2bInit(32)
+  blake2bUpdate(context, seedBytes)
+  blake2bUpdate(context, indexBytes)
+
+  return blake2bFinal(context)
+}
+
 /**
  * Derive a secret key from a seed, given an index.
  *
@@ -42,18 +69,20 @@ export function deriveSecretKey(seed: string, index: number): string {
     throw new Error('Index is not valid')
   }
 
-  const seedBytes = hexToByteArray(seed)
-  const indexBuffer = new ArrayBuffer(4)
-  const indexView = new DataView(indexBuffer)
-  indexView.setUint32(0, index)
-  const indexBytes = new Uint8Array(indexBuffer)
-
-  const context = blake2bInit(32)
-  blake2bUpdate(context, seedBytes)
-  blake2bUpdate(context, indexBytes)
-  const secretKeyBytes = blake2bFinal(context)
+  return byteArrayToHex(unsafeDeriveSecretKey(hexToByteArray(seed), index))
+}
 
-  return byteArrayToHex(secretKeyBytes)
+/**
+ * Derive a public key from a secret key.
+ *
+ * **Unchecked:** the secret key is not validated, use [[derivePublicKey]]
+ * unless it already is.
+ *
+ * @param secretKeyBytes - The 32 bytes secret key
+ * @returns 32 bytes public key
+ */
+export function unsafeDerivePublicKey(secretKeyBytes: Uint8Array): Uint8Array {
+  return derivePublicFromSecret(secretKeyBytes)
 }
 
 /**
@@ -63,23 +92,18 @@ export function deriveSecretKey(seed: string, index: number): string {
  * @returns Public key, in hexadecimal format
  */
 export function derivePublicKey(secretKeyOrAddress: string): string {
-  const isSecretKey = checkKey(secretKeyOrAddress)
-  const addressParseResult = parseAddress(secretKeyOrAddress)
-  const isAddress = addressParseResult.valid
-  if (!isSecretKey && !isAddress) {
-    throw new Error('Secret key or address is not valid')
+  if (checkKey(secretKeyOrAddress)) {
+    const secretKeyBytes = hexToByteArray(secretKeyOrAddress)
+
+    return byteArrayToHex(unsafeDerivePublicKey(secretKeyBytes))
   }
 
-  let publicKeyBytes: Uint8Array
-  if (isSecretKey) {
-    const secretKeyBytes = hexToByteArray(secretKeyOrAddress)
-    publicKeyBytes = derivePublicFromSecret(secretKeyBytes)
-  } else {
-    // isAddress
-    publicKeyBytes = addressParseResult.publicKeyBytes as Uint8Array
+  const addressParseResult = parseAddress(secretKeyOrAddress)
+  if (!addressParseResult.valid) {
+    throw new Error('Secret key or address is not valid')
   }
 
-  return byteArrayToHex(publicKeyBytes)
+  return byteArrayToHex(addressParseResult.publicKeyBytes as Uint8Array)
 }
 
 /** Derive address params. */
@@ -91,23 +115,21 @@ export interface DeriveAddressParams {
 /**
  * Derive address from a public key.
  *
- * @param publicKey - The public key to generate the address from, in hexadecimal format
+ * **Unchecked:** the public key is not validated, use [[deriveAddress]]
+ * unless it already is.
+ *
+ * @param publicKeyBytes - The 32 bytes public key
  * @param params - Parameters
  * @returns Address
  */
-export function deriveAddress(
-  publicKey: string,
+export function unsafeDeriveAddress(
+  publicKeyBytes: Uint8Array,
   params: DeriveAddressParams = {}
 ): string {
-  if (!checkKey(publicKey)) throw new Error('Public key is not valid')
-
-  const publicKeyBytes = hexToByteArray(publicKey)
-  const paddedPublicKeyBytes = hexToByteArray(publicKey)
-
   let prefix = 'xrb_'
   if (params.useNanoPrefix === true) prefix = 'nano_'
 
-  const encodedPublicKey = encodeNanoBase32(paddedPublicKeyBytes)
+  const encodedPublicKey = encodeNanoBase32(publicKeyBytes)
 
   const checksum = blake2b(publicKeyBytes, null, 5).reverse()
 
@@ -115,3 +137,40 @@ export function deriveAddress(
 
   return prefix + encodedPublicKey + encodedChecksum
 }
+
+/**
+ * Derive address from a public key in hexadecimal format, through the
+ * address cache. The public key is not validated.
+ *
+ * @hidden
+ */
+export function unsafeDeriveCachedAddress(
+  publicKey: string,
+  params: DeriveAddressParams = {}
+): string {
+  const cacheKey =
+    (params.useNanoPrefix === true ? 'nano_' : 'xrb_') + publicKey
+  const cachedAddress = ADDRESS_CACHE.get(cacheKey)
+  if (cachedAddress) return cachedAddress
+
+  const address = unsafeDeriveAddress(hexToByteArray(publicKey), params)
+  ADDRESS_CACHE.set(cacheKey, address)
+
+  return address
+}
+
+/**
+ * Derive address from a public key.
+ *
+ * @param publicKey - The public key to generate the address from, in hexadecimal format
+ * @param params - Parameters
+ * @returns Address
+ */
+export function deriveAddress(
+  publicKey: string,
+  params: DeriveAddressParams = {}
+): string {
+  if (!checkKey(publicKey)) throw new Error('Public key is not valid')
+
+  return unsafeDeriveCachedAddress(publicKey, params)
+}
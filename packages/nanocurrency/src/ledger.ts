@@ -0,0 +1,633 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import {
+  hashBlocks,
+  STATE_BLOCK_HASH_LENGTH,
+  STATE_BLOCK_PREIMAGE_LENGTH,
+} from './accelerated'
+
+import { BlockRepresentation } from './block'
+
+import { createLruCache } from './cache'
+
+import { checkAmount, checkHash, checkKey, checkThreshold } from './check'
+
+import { createBlockAligner, encodeBlock, STATE_BLOCK_LENGTH } from './codec'
+
+import { convert, Unit } from './conversion'
+
+import { unsafeHashBlockBytes } from './hash'
+
+import { unsafeVerifyBlock } from './signature'
+
+import { byteArrayToHex, compareArrays, hexToByteArray } from './utils'
+
+import { DEFAULT_WORK_THRESHOLD, unsafeValidateWork } from './work'
+
+/** Count of blocks verified by a single batch. */
+const DEFAULT_BATCH_LENGTH = 4096
+/** Count of batches being verified at once. */
+const DEFAULT_CONCURRENCY = 4
+/**
+ * Count of accounts whose last balance is kept to tell receive blocks apart,
+ * far more than the accounts interleaved in a ledger export.
+ */
+const BALANCE_CACHE_CAPACITY = 65536
+/** Count of blocks of an account chain verified by a single chunk. */
+const DEFAULT_CHUNK_LENGTH = 256
+
+/** The links of epoch blocks, "epoch v1 block" and "epoch v2 block". */
+const EPOCH_LINKS = [
+  '65706F636820763120626C6F636B000000000000000000000000000000000000',
+  '65706F636820763220626C6F636B000000000000000000000000000000000000',
+].map(hexToByteArray)
+/** The signers of the epoch v1 and v2 blocks of the live network. */
+const DEFAULT_EPOCH_SIGNERS = [
+  'E89208DD038FBB269987689621D52292AE9C35941A7484756ECCED92A65093BA',
+  'DD24A9200D4BF8247981E4AC63DBDE38FD2319386970A26D02ECC98C79975DB1',
+]
+
+/**
+ * Why a block failed the verification: its signature or its work is not
+ * valid, or within an account chain, it belongs to another account, it does
+ * not follow the previous block, or its balance does not match its link.
+ */
+export type LedgerFailureReason =
+  | 'signature'
+  | 'work'
+  | 'account'
+  | 'previous'
+  | 'balance'
+
+/** A block failing the verification, see [[createLedgerVerifier]]. */
+export interface LedgerFailure {
+  /** The index of the block in the ledger */
+  index: number
+  /** The block hash, in hexadecimal format */
+  hash: string
+  /** Why the block failed */
+  reason: LedgerFailureReason
+}
+
+/** Work thresholds of the blocks, depending on their subtype. */
+export interface LedgerThresholds {
+  /** The threshold of send and change blocks. Defaults to ffffffc000000000 */
+  threshold?: string
+  /** The threshold of open and receive blocks. Defaults to `threshold` */
+  receiveThreshold?: string
+}
+
+/** The rules the blocks are verified against. */
+export interface LedgerRules extends LedgerThresholds {
+  /**
+   * The public keys signing epoch blocks, in hexadecimal format. Defaults to
+   * the signers of the epoch v1 and v2 blocks of the live network
+   */
+  epochSigners?: string[]
+}
+
+/** Verify blocks parameters. */
+export interface VerifyBlocksParams extends LedgerRules {
+  /**
+   * One byte per block, non-zero for a receive block. `open` blocks are
+   * always receive blocks. Defaults to none
+   */
+  receives?: Uint8Array
+  /** The 32 bytes hashes of the blocks, back to back, if already computed. Defaults to hashing the blocks */
+  hashes?: Uint8Array
+  /** The index in the ledger of the first block, to number the failures. Defaults to `0` */
+  firstIndex?: number
+  /** The current worker index, starting at 0 */
+  workerIndex?: number
+  /** The count of worker */
+  workerCount?: number
+}
+
+/** Ledger verifier parameters. */
+export interface LedgerVerifierParams extends LedgerRules {
+  /** The count of blocks of a batch. Defaults to `4096` */
+  batchLength?: number
+  /** The count of batches verified at once, which bounds the memory used. Defaults to `4` */
+  concurrency?: number
+  /**
+   * Verify a batch of blocks. Defaults to [[verifyBlocks]] on the calling
+   * thread: give a function handing the batch to a worker to verify the
+   * batches in parallel
+   */
+  verifyBatch?: (
+    blocks: Uint8Array,
+    params: VerifyBlocksParams
+  ) => Promise<LedgerFailure[]>
+  /**
+   * Called once a batch is verified, in the order of the ledger, with the
+   * failures of the batch: they are not kept by the verifier
+   */
+  onProgress?: (report: LedgerReport, failures: LedgerFailure[]) => void
+}
+
+/** Streaming verification of a ledger, see [[createLedgerVerifier]]. */
+export interface LedgerVerifier {
+  /**
+   * Feed encoded blocks to the verifier. Wait for it before feeding the next
+   * chunk: it waits itself for the oldest batch once enough are in flight.
+   *
+   * @param chunk - Encoded blocks, see [[encodeBlock]], split anywhere
+   */
+  update(chunk: Uint8Array): Promise<void>
+  /**
+   * Verify the last blocks fed, and wait for every batch.
+   *
+   * @returns Report
+   */
+  finish(): Promise<LedgerReport>
+}
+
+/** The outcome of a ledger verification. */
+export interface LedgerReport {
+  /** The count of blocks verified */
+  blockCount: number
+  /** The count of blocks failing the verification */
+  failureCount: number
+}
+
+function isZero(bytes: Uint8Array): boolean {
+  for (let i = 0; i < bytes.length; i++) {
+    if (bytes[i] !== 0) return false
+  }
+
+  return true
+}
+
+function isEpochLink(link: Uint8Array): boolean {
+  return EPOCH_LINKS.some(epochLink => compareArrays(link, epochLink))
+}
+
+function checkEpochSigners(params: LedgerRules): Uint8Array[] {
+  const { epochSigners = DEFAULT_EPOCH_SIGNERS } = params
+
+  if (
+    !Array.isArray(epochSigners) ||
+    !epochSigners.every(epochSigner => checkKey(epochSigner))
+  ) {
+    throw new Error('Epoch signers are not valid')
+  }
+
+  return epochSigners.map(hexToByteArray)
+}
+
+function checkThresholds(params: LedgerThresholds): [Uint8Array, Uint8Array] {
+  const threshold = params.threshold ?? DEFAULT_WORK_THRESHOLD
+  const receiveThreshold = params.receiveThreshold ?? threshold
+
+  if (!checkThreshold(threshold) || !checkThreshold(receiveThreshold)) {
+    throw new Error('Threshold is not valid')
+  }
+
+  return [hexToByteArray(threshold), hexToByteArray(receiveThreshold)]
+}
+
+/**
+ * Verify encoded state blocks: recompute the hash of each block, and check
+ * its signature against its account, or against the epoch signers for an
+ * epoch block, and its work against the threshold of its subtype.
+ *
+ * The work can be spread across workers, each one verifying its own slice
+ * of the blocks.
+ *
+ * @param blocks - The blocks, encoded back to back, see [[encodeBlock]]
+ * @param params - Parameters
+ * @returns Failures, in the order of the blocks
+ */
+export function verifyBlocks(
+  blocks: Uint8Array,
+  params: VerifyBlocksParams = {}
+): LedgerFailure[] {
+  const {
+    receives = new Uint8Array(0),
+    hashes = null,
+    firstIndex = 0,
+    workerIndex = 0,
+    workerCount = 1,
+  } = params
+
+  if (
+    !(blocks instanceof Uint8Array) ||
+    blocks.length % STATE_BLOCK_LENGTH !== 0
+  ) {
+    throw new Error('Blocks are not valid')
+  }
+  if (
+    !Number.isInteger(workerIndex) ||
+    !Number.isInteger(workerCount) ||
+    workerIndex < 0 ||
+    workerCount < 1 ||
+    workerIndex > workerCount - 1
+  ) {
+    throw new Error('Worker parameters are not valid')
+  }
+  if (!(receives instanceof Uint8Array)) {
+    throw new Error('Receives are not valid')
+  }
+  if (!Number.isInteger(firstIndex) || firstIndex < 0) {
+    throw new Error('First index is not valid')
+  }
+  const [thresholdBytes, receiveThresholdBytes] = checkThresholds(params)
+  const epochSigners = checkEpochSigners(params)
+
+  const count = blocks.length / STATE_BLOCK_LENGTH
+  if (
+    hashes !== null &&
+    (!(hashes instanceof Uint8Array) ||
+      hashes.length < count * STATE_BLOCK_HASH_LENGTH)
+  ) {
+    throw new Error('Hashes are not valid')
+  }
+  const start = Math.floor((count * workerIndex) / workerCount)
+  const end = Math.floor((count * (workerIndex + 1)) / workerCount)
+
+  // the preamble is written once, and every block copied after it
+  const preimage = new Uint8Array(STATE_BLOCK_PREIMAGE_LENGTH)
+  preimage[31] = 6
+  const failures: LedgerFailure[] = []
+
+  for (let i = start; i < end; i++) {
+    const block = blocks.subarray(
+      i * STATE_BLOCK_LENGTH,
+      (i + 1) * STATE_BLOCK_LENGTH
+    )
+    const account = block.subarray(0, 32)
+    const previous = block.subarray(32, 64)
+
+    let hash: Uint8Array
+    if (hashes !== null) {
+      hash = hashes.subarray(
+        i * STATE_BLOCK_HASH_LENGTH,
+        (i + 1) * STATE_BLOCK_HASH_LENGTH
+      )
+    } else {
+      preimage.set(block.subarray(0, STATE_BLOCK_PREIMAGE_LENGTH - 32), 32)
+      hash = unsafeHashBlockBytes(preimage)
+    }
+
+    const signature = block.subarray(144, 208)
+    const signed = isEpochLink(block.subarray(112, 144))
+      ? epochSigners.some(signer => unsafeVerifyBlock(hash, signature, signer))
+      : unsafeVerifyBlock(hash, signature, account)
+
+    let reason: LedgerFailureReason | null = null
+    if (!signed) {
+      reason = 'signature'
+    } else {
+      // the work of an open block is computed on the account public key
+      const open = isZero(previous)
+      const root = open ? account : previous
+      const threshold =
+        open || receives[i] ? receiveThresholdBytes : thresholdBytes
+
+      if (!unsafeValidateWork(root, block.subarray(208, 216), threshold)) {
+        reason = 'work'
+      }
+    }
+
+    if (reason !== null) {
+      failures.push({
+        index: firstIndex + i,
+        hash: byteArrayToHex(hash),
+        reason,
+      })
+    }
+  }
+
+  return failures
+}
+
+/**
+ * Create a verifier of a whole ledger, streamed as encoded state blocks: the
+ * stream is split into batches, a few of them verified at once, so that the
+ * memory used stays bounded whatever the size of the ledger.
+ *
+ * A block raising the balance of its account since the previous block of
+ * that account in the ledger is a receive block, validated against the
+ * receive threshold. The failures are handed to `onProgress` batch by
+ * batch, and only counted in the report.
+ *
+ * @param params - Parameters
+ * @returns Ledger verifier
+ */
+export function createLedgerVerifier(
+  params: LedgerVerifierParams = {}
+): LedgerVerifier {
+  const {
+    batchLength = DEFAULT_BATCH_LENGTH,
+    concurrency = DEFAULT_CONCURRENCY,
+    verifyBatch = async (blocks: Uint8Array, params: VerifyBlocksParams) =>
+      verifyBlocks(blocks, params),
+    onProgress,
+  } = params
+
+  if (!Number.isInteger(batchLength) || batchLength < 1) {
+    throw new Error('Batch length is not valid')
+  }
+  if (!Number.isInteger(concurrency) || concurrency < 1) {
+    throw new Error('Concurrency is not valid')
+  }
+  checkThresholds(params)
+  checkEpochSigners(params)
+
+  const balances = createLruCache<string>(BALANCE_CACHE_CAPACITY)
+  const report: LedgerReport = { blockCount: 0, failureCount: 0 }
+  const pending: Promise<LedgerFailure[]>[] = []
+  const pendingCounts: number[] = []
+
+  const settleOldest = async (): Promise<void> => {
+    const failures = await (pending.shift() as Promise<LedgerFailure[]>)
+    report.blockCount += pendingCounts.shift() as number
+    report.failureCount += failures.length
+    if (onProgress) onProgress(report, failures)
+  }
+
+  let firstIndex = 0
+  let batch = new Uint8Array(batchLength * STATE_BLOCK_LENGTH)
+  let receives = new Uint8Array(batchLength)
+  let batchOffset = 0
+  const aligner = createBlockAligner()
+
+  const flush = async (): Promise<void> => {
+    const count = batchOffset / STATE_BLOCK_LENGTH
+    if (count === 0) return
+
+    // the oldest batch is awaited first, so that failures stay in order
+    if (pending.length === concurrency) await settleOldest()
+    const failures = verifyBatch(batch.subarray(0, batchOffset), {
+      threshold: params.threshold,
+      receiveThreshold: params.receiveThreshold,
+      epochSigners: params.epochSigners,
+      receives: receives.subarray(0, count),
+      firstIndex,
+    })
+    // the error is thrown once the batch is settled, not left unhandled
+    failures.catch(() => undefined)
+    pending.push(failures)
+    pendingCounts.push(count)
+
+    firstIndex += count
+    batch = new Uint8Array(batchLength * STATE_BLOCK_LENGTH)
+    receives = new Uint8Array(batchLength)
+    batchOffset = 0
+  }
+
+  // the subtype depends on the blocks before, so it is told here, in order
+  const classify = (index: number): void => {
+    const block = batch.subarray(
+      index * STATE_BLOCK_LENGTH,
+      (index + 1) * STATE_BLOCK_LENGTH
+    )
+    const account = byteArrayToHex(block.subarray(0, 32))
+    const balance = byteArrayToHex(block.subarray(96, 112))
+    const lastBalance = balances.get(account)
+
+    // balances are fixed length hexadecimal, compared as strings
+    if (typeof lastBalance !== 'undefined' && balance > lastBalance) {
+      receives[index] = 1
+    }
+    balances.set(account, balance)
+  }
+
+  return {
+    update: async chunk => {
+      if (!(chunk instanceof Uint8Array)) throw new Error('Chunk is not valid')
+
+      for (const blocks of aligner.update(chunk)) {
+        let blocksOffset = 0
+        while (blocksOffset < blocks.length) {
+          const length = Math.min(
+            blocks.length - blocksOffset,
+            batch.length - batchOffset
+          )
+          batch.set(
+            blocks.subarray(blocksOffset, blocksOffset + length),
+            batchOffset
+          )
+
+          const blockEnd = (batchOffset + length) / STATE_BLOCK_LENGTH
+          for (
+            let index = batchOffset / STATE_BLOCK_LENGTH;
+            index < blockEnd;
+            index++
+          ) {
+            classify(index)
+          }
+
+          blocksOffset += length
+          batchOffset += length
+          if (batchOffset === batch.length) await flush()
+        }
+      }
+    },
+    finish: async () => {
+      // a truncated ledger
+      if (aligner.pendingLength !== 0) throw new Error('Ledger is not valid')
+
+      await flush()
+      while (pending.length > 0) await settleOldest()
+
+      return report
+    },
+  }
+}
+
+/** Verify account chain parameters. */
+export interface VerifyAccountChainParams extends LedgerRules {
+  /** The hash of the block before the first one, or `null` if the first one opens the account. Defaults to `null` */
+  frontier?: string | null
+  /** The balance before the first block, in raw. Defaults to `0` when the first block opens the account, to unknown otherwise */
+  balance?: string
+  /** The count of blocks of a chunk. Defaults to `256` */
+  chunkLength?: number
+  /** The count of chunks verified at once. Defaults to `4` */
+  concurrency?: number
+  /**
+   * Verify a chunk of blocks. Defaults to [[verifyBlocks]] on the calling
+   * thread: give a function handing the chunk to a worker to verify the
+   * chunks in parallel
+   */
+  verifyChunk?: (
+    blocks: Uint8Array,
+    params: VerifyBlocksParams
+  ) => Promise<LedgerFailure[]>
+}
+
+/** Compare two big-endian balances of the same length. */
+function compareBalances(balance1: Uint8Array, balance2: Uint8Array): number {
+  for (let i = 0; i < balance1.length; i++) {
+    if (balance1[i] !== balance2[i]) return balance1[i] - balance2[i]
+  }
+
+  return 0
+}
+
+/**
+ * Verify the chain of blocks of an account, in order. Every block is hashed
+ * in a single batch, then the links are followed from block to block: each
+ * block must belong to the account, follow the previous one, and have a
+ * balance matching its link, a receive needing a source and a change or an
+ * epoch block no balance change. The signatures and the works, far costlier, are then
+ * verified by chunks, a few of them at once. The verification stops on the
+ * first failure. Require WebAssembly support.
+ *
+ * @param blocks - The blocks, either as representations or encoded back to back, see [[encodeBlock]]
+ * @param params - Parameters
+ * @returns The first failure, or `null` if the chain is valid
+ */
+export async function verifyAccountChain(
+  blocks: BlockRepresentation[] | Uint8Array,
+  params: VerifyAccountChainParams = {}
+): Promise<LedgerFailure | null> {
+  const {
+    frontier = null,
+    chunkLength = DEFAULT_CHUNK_LENGTH,
+    concurrency = DEFAULT_CONCURRENCY,
+    verifyChunk = async (blocks: Uint8Array, params: VerifyBlocksParams) =>
+      verifyBlocks(blocks, params),
+  } = params
+
+  if (frontier !== null && !checkHash(frontier)) {
+    throw new Error('Frontier is not valid')
+  }
+  if (typeof params.balance !== 'undefined' && !checkAmount(params.balance)) {
+    throw new Error('Balance is not valid')
+  }
+  if (!Number.isInteger(chunkLength) || chunkLength < 1) {
+    throw new Error('Chunk length is not valid')
+  }
+  if (!Number.isInteger(concurrency) || concurrency < 1) {
+    throw new Error('Concurrency is not valid')
+  }
+  checkThresholds(params)
+  checkEpochSigners(params)
+
+  let encoded: Uint8Array
+  if (Array.isArray(blocks)) {
+    encoded = new Uint8Array(blocks.length * STATE_BLOCK_LENGTH)
+    blocks.forEach((block, index) =>
+      encodeBlock(block, encoded, index * STATE_BLOCK_LENGTH)
+    )
+  } else if (
+    blocks instanceof Uint8Array &&
+    blocks.length % STATE_BLOCK_LENGTH === 0
+  ) {
+    encoded = blocks
+  } else {
+    throw new Error('Blocks are not valid')
+  }
+  const count = encoded.length / STATE_BLOCK_LENGTH
+
+  const preimages = new Uint8Array(count * STATE_BLOCK_PREIMAGE_LENGTH)
+  for (let i = 0; i < count; i++) {
+    const offset = i * STATE_BLOCK_PREIMAGE_LENGTH
+    preimages[offset + 31] = 6
+    preimages.set(
+      encoded.subarray(
+        i * STATE_BLOCK_LENGTH,
+        i * STATE_BLOCK_LENGTH + STATE_BLOCK_PREIMAGE_LENGTH - 32
+      ),
+      offset + 32
+    )
+  }
+  const hashes = await hashBlocks(preimages)
+
+  // the links are cheap to follow, and tell the subtype of every block
+  const receives = new Uint8Array(count)
+  let lastHash =
+    frontier === null ? new Uint8Array(32) : hexToByteArray(frontier)
+  let lastBalance: Uint8Array | null = null
+  if (typeof params.balance !== 'undefined') {
+    const balanceHex = convert(params.balance, { from: Unit.raw, to: Unit.hex })
+    lastBalance = hexToByteArray(balanceHex)
+  } else if (frontier === null) {
+    lastBalance = new Uint8Array(16)
+  }
+  let linkFailure: LedgerFailure | null = null
+
+  for (let i = 0; i < count; i++) {
+    const block = encoded.subarray(
+      i * STATE_BLOCK_LENGTH,
+      (i + 1) * STATE_BLOCK_LENGTH
+    )
+    const hash = hashes.subarray(
+      i * STATE_BLOCK_HASH_LENGTH,
+      (i + 1) * STATE_BLOCK_HASH_LENGTH
+    )
+    const balance = block.subarray(96, 112)
+    const link = block.subarray(112, 144)
+    const delta =
+      lastBalance === null ? null : compareBalances(balance, lastBalance)
+
+    let reason: LedgerFailureReason | null = null
+    if (!compareArrays(block.subarray(0, 32), encoded.subarray(0, 32))) {
+      reason = 'account'
+    } else if (!compareArrays(block.subarray(32, 64), lastHash)) {
+      reason = 'previous'
+    } else if (isEpochLink(link)) {
+      // an epoch block, signed by the epoch signer, only keeps the balance
+      if (delta !== null && delta !== 0) reason = 'balance'
+    } else if (
+      // an open block receives, a change block keeps the balance
+      (isZero(lastHash) && delta !== null && delta <= 0) ||
+      (delta !== null && delta > 0 && isZero(link)) ||
+      (delta === 0 && !isZero(link))
+    ) {
+      reason = 'balance'
+    }
+
+    if (reason !== null) {
+      linkFailure = { index: i, hash: byteArrayToHex(hash), reason }
+      break
+    }
+
+    if (delta !== null && delta > 0) receives[i] = 1
+    lastHash = hash
+    lastBalance = balance
+  }
+
+  // only the blocks before a broken link can fail earlier
+  const end = linkFailure === null ? count : linkFailure.index
+  const pending: Promise<LedgerFailure[]>[] = []
+  let next = 0
+
+  const dispatch = (): void => {
+    const start = next
+    next = Math.min(start + chunkLength, end)
+
+    const failures = verifyChunk(
+      encoded.subarray(start * STATE_BLOCK_LENGTH, next * STATE_BLOCK_LENGTH),
+      {
+        threshold: params.threshold,
+        receiveThreshold: params.receiveThreshold,
+        epochSigners: params.epochSigners,
+        receives: receives.subarray(start, next),
+        hashes: hashes.subarray(
+          start * STATE_BLOCK_HASH_LENGTH,
+          next * STATE_BLOCK_HASH_LENGTH
+        ),
+        firstIndex: start,
+      }
+    )
+    // the error is thrown once the chunk is settled, not left unhandled
+    failures.catch(() => undefined)
+    pending.push(failures)
+  }
+
+  while (next < end && pending.length < concurrency) dispatch()
+  while (pending.length > 0) {
+    const failures = await (pending.shift() as Promise<LedgerFailure[]>)
+    // the chunks still in flight are left to settle, and ignored
+    if (failures.length > 0) return failures[0]
+    if (next < end) dispatch()
+  }
+
+  return linkFailure
+}
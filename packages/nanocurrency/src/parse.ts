@@ -5,6 +5,7 @@
  */
 import { blake2b } from 'blakejs'
 
+import { PUBLIC_KEY_CACHE } from './cache'
 import { compareArrays } from './utils'
 import { checkString } from './check'
 import { decodeNanoBase32 } from './nano-base32'
@@ -25,6 +26,13 @@ export function parseAddress(address: {}): ParseAddressResult {
     return invalid
   }
 
+  // only valid addresses are cached, so a hit needs no checksum. The cache
+  // keeps its own copy, which a caller writing into its result cannot change
+  const cachedPublicKeyBytes = PUBLIC_KEY_CACHE.get(address as string)
+  if (cachedPublicKeyBytes) {
+    return { publicKeyBytes: cachedPublicKeyBytes.slice(), valid: true }
+  }
+
   let prefixLength
   if ((address as string).startsWith('xrb_')) {
     prefixLength = 4
@@ -46,6 +54,8 @@ export function parseAddress(address: {}): ParseAddressResult {
 
   if (!valid) return invalid
 
+  PUBLIC_KEY_CACHE.set(address as string, publicKeyBytes.slice())
+
   return {
     publicKeyBytes,
     valid: true,
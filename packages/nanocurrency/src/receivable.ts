@@ -0,0 +1,231 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import { checkKey } from './check'
+
+import { createBlockAligner, STATE_BLOCK_LENGTH, viewBlock } from './codec'
+
+import { unsafeDeriveCachedAddress } from './keys'
+
+import { createKeyTable } from './table'
+
+import {
+  compareU128,
+  subtractU128,
+  U128_LENGTH,
+  u128ToString,
+} from './u128'
+
+import { byteArrayToHex, hexToByteArray } from './utils'
+
+/**
+ * A blocked Bloom filter: a key sets 8 bits of a single 512 bits block, a
+ * cache line, picked by its first bytes, and the bits by the next ones, keys
+ * being uniform.
+ */
+const BLOOM_BLOCK_WORDS = 16
+const BLOOM_BITS_PER_KEY = 16
+const BLOOM_BIT_COUNT = 8
+
+const ACCOUNT_OFFSET = 0
+const PREVIOUS_OFFSET = 32
+const BALANCE_OFFSET = 96
+const LINK_OFFSET = 112
+
+interface BloomFilter {
+  add(bytes: Uint8Array, offset: number): void
+  mayContain(bytes: Uint8Array, offset: number): boolean
+}
+
+function createBloomFilter(keyCount: number): BloomFilter {
+  let blockCount = 1
+  while (blockCount * BLOOM_BLOCK_WORDS * 32 < keyCount * BLOOM_BITS_PER_KEY) {
+    blockCount *= 2
+  }
+  const words = new Uint32Array(blockCount * BLOOM_BLOCK_WORDS)
+  const mask = blockCount - 1
+
+  const block = (bytes: Uint8Array, offset: number): number =>
+    ((bytes[offset] |
+      (bytes[offset + 1] << 8) |
+      (bytes[offset + 2] << 16) |
+      (bytes[offset + 3] << 24)) &
+      mask) *
+    BLOOM_BLOCK_WORDS
+  // the bit of the block, on 9 bits
+  const bit = (bytes: Uint8Array, offset: number, index: number): number =>
+    (bytes[offset + 4 + 2 * index] | (bytes[offset + 5 + 2 * index] << 8)) &
+    511
+
+  return {
+    add: (bytes, offset) => {
+      const first = block(bytes, offset)
+      for (let i = 0; i < BLOOM_BIT_COUNT; i++) {
+        const position = bit(bytes, offset, i)
+        words[first + (position >> 5)] |= 1 << (position & 31)
+      }
+    },
+    mayContain: (bytes, offset) => {
+      const first = block(bytes, offset)
+      for (let i = 0; i < BLOOM_BIT_COUNT; i++) {
+        const position = bit(bytes, offset, i)
+        if ((words[first + (position >> 5)] & (1 << (position & 31))) === 0) {
+          return false
+        }
+      }
+
+      return true
+    },
+  }
+}
+
+/** A block sending to one of the scanned accounts. */
+export interface Receivable {
+  /** The index of the send block in the stream */
+  index: number
+  /** The hash of the send block, in hexadecimal format */
+  hash: string
+  /** The sending account address */
+  account: string
+  /** The destination address */
+  destination: string
+  /** The amount sent in raw, or `null` when the previous block of the sending account was not scanned */
+  amount: string | null
+}
+
+/** Streaming detection of receivables, see [[createReceivableScanner]]. */
+export interface ReceivableScanner {
+  /**
+   * Feed encoded blocks to the scanner.
+   *
+   * @param chunk - Encoded blocks, see [[encodeBlock]], split anywhere
+   * @returns The blocks sending to the scanned accounts, in order
+   */
+  update(chunk: Uint8Array): Receivable[]
+  /** Check that the blocks fed ended on a whole block. */
+  finish(): void
+}
+
+/**
+ * Create a scanner of the blocks sending to a set of accounts, such as the
+ * accounts of a wallet. The link of every block is tested against a blocked
+ * Bloom filter of the public keys, which rules out almost every block with a
+ * single cache line read, then looked up in a hash set of the public keys.
+ *
+ * A block is a send when its balance is lower than the one of the previous
+ * block of its account: the scanner keeps the last balance of every account
+ * it has seen, so the blocks are expected in the order of each account
+ * chain, as in a ledger export or a snapshot.
+ *
+ * @param publicKeys - The public keys of the accounts, in hexadecimal format
+ * @returns Scanner
+ */
+export function createReceivableScanner(
+  publicKeys: string[]
+): ReceivableScanner {
+  if (!Array.isArray(publicKeys)) throw new Error('Public keys are not valid')
+
+  const filter = createBloomFilter(publicKeys.length)
+  const wallet = createKeyTable(0, publicKeys.length)
+  for (const publicKey of publicKeys) {
+    if (!checkKey(publicKey)) throw new Error('Public key is not valid')
+
+    const bytes = hexToByteArray(publicKey)
+    filter.add(bytes, 0)
+    wallet.insert(bytes, 0)
+  }
+
+  // the last balance of every account, and whether it is known
+  const accounts = createKeyTable(U128_LENGTH + 1)
+  const amount = new Uint8Array(U128_LENGTH)
+  let blockCount = 0
+  const aligner = createBlockAligner()
+
+  const scan = (blocks: Uint8Array, offset: number): Receivable | null => {
+    const slot = accounts.insert(blocks, offset + ACCOUNT_OFFSET)
+    const balances = accounts.values
+    const balanceOffset = slot * (U128_LENGTH + 1)
+    const linkOffset = offset + LINK_OFFSET
+
+    let receivable: Receivable | null = null
+    if (
+      filter.mayContain(blocks, linkOffset) &&
+      wallet.find(blocks, linkOffset) !== -1
+    ) {
+      let open = true
+      for (let i = 0; open && i < 32; i++) {
+        open = blocks[offset + PREVIOUS_OFFSET + i] === 0
+      }
+      const known = balances[balanceOffset + U128_LENGTH] !== 0
+
+      // an `open` block, or a block with a higher balance, is a receive
+      if (
+        !open &&
+        (!known ||
+          compareU128(
+            blocks,
+            offset + BALANCE_OFFSET,
+            balances,
+            balanceOffset
+          ) < 0)
+      ) {
+        let sent: string | null = null
+        if (known) {
+          amount.set(
+            balances.subarray(balanceOffset, balanceOffset + U128_LENGTH)
+          )
+          subtractU128(amount, 0, blocks, offset + BALANCE_OFFSET)
+          sent = u128ToString(amount)
+        }
+
+        const view = viewBlock(blocks, offset)
+        receivable = {
+          index: blockCount,
+          hash: view.hash(),
+          account: view.account,
+          destination: unsafeDeriveCachedAddress(
+            byteArrayToHex(blocks.subarray(linkOffset, linkOffset + 32))
+          ),
+          amount: sent,
+        }
+      }
+    }
+
+    balances.set(
+      blocks.subarray(
+        offset + BALANCE_OFFSET,
+        offset + BALANCE_OFFSET + U128_LENGTH
+      ),
+      balanceOffset
+    )
+    balances[balanceOffset + U128_LENGTH] = 1
+    blockCount++
+
+    return receivable
+  }
+
+  return {
+    update: chunk => {
+      if (!(chunk instanceof Uint8Array)) throw new Error('Chunk is not valid')
+
+      const receivables: Receivable[] = []
+      for (const blocks of aligner.update(chunk)) {
+        for (
+          let offset = 0;
+          offset < blocks.length;
+          offset += STATE_BLOCK_LENGTH
+        ) {
+          const receivable = scan(blocks, offset)
+          if (receivable !== null) receivables.push(receivable)
+        }
+      }
+
+      return receivables
+    },
+    finish: () => {
+      if (aligner.pendingLength !== 0) throw new Error('Blocks are not valid')
+    },
+  }
+}
@@ -17,6 +17,23 @@ export interface SignBlockParams {
   secretKey: string
 }
 
+/**
+ * Sign a block.
+ *
+ * **Unchecked:** the hash and the secret key are not validated, use
+ * [[signBlock]] unless they already are.
+ *
+ * @param hashBytes - The 32 bytes hash of the block to sign
+ * @param secretKeyBytes - The 32 bytes secret key to sign the block with
+ * @returns 64 bytes signature
+ */
+export function unsafeSignBlock(
+  hashBytes: Uint8Array,
+  secretKeyBytes: Uint8Array
+): Uint8Array {
+  return signDetached(hashBytes, secretKeyBytes)
+}
+
 /**
  * Sign a block.
  *
@@ -27,10 +44,10 @@ export function signBlock(params: SignBlockParams): string {
   if (!checkHash(params.hash)) throw new Error('Hash is not valid')
   if (!checkKey(params.secretKey)) throw new Error('Secret key is not valid')
 
-  const blockHashBytes = hexToByteArray(params.hash)
-  const secretKeyBytes = hexToByteArray(params.secretKey)
-
-  const signatureBytes = signDetached(blockHashBytes, secretKeyBytes)
+  const signatureBytes = unsafeSignBlock(
+    hexToByteArray(params.hash),
+    hexToByteArray(params.secretKey)
+  )
 
   return byteArrayToHex(signatureBytes)
 }
@@ -45,6 +62,25 @@ export interface VerifyBlockParams {
   publicKey: string
 }
 
+/**
+ * Verify a block against a public key.
+ *
+ * **Unchecked:** the hash, the signature and the public key are not
+ * validated, use [[verifyBlock]] unless they already are.
+ *
+ * @param hashBytes - The 32 bytes hash of the block to verify
+ * @param signatureBytes - The 64 bytes signature of the block to verify
+ * @param publicKeyBytes - The 32 bytes public key to verify the block against
+ * @returns Valid
+ */
+export function unsafeVerifyBlock(
+  hashBytes: Uint8Array,
+  signatureBytes: Uint8Array,
+  publicKeyBytes: Uint8Array
+): boolean {
+  return verifyDetached(hashBytes, signatureBytes, publicKeyBytes)
+}
+
 /**
  * Verify a block against a public key.
  *
@@ -57,9 +93,9 @@ export function verifyBlock(params: VerifyBlockParams): boolean {
     throw new Error('Signature is not valid')
   if (!checkKey(params.publicKey)) throw new Error('Public key is not valid')
 
-  const blockHashBytes = hexToByteArray(params.hash)
-  const signatureBytes = hexToByteArray(params.signature)
-  const publicKeyBytes = hexToByteArray(params.publicKey)
-
-  return verifyDetached(blockHashBytes, signatureBytes, publicKeyBytes)
+  return unsafeVerifyBlock(
+    hexToByteArray(params.hash),
+    hexToByteArray(params.signature),
+    hexToByteArray(params.publicKey)
+  )
 }
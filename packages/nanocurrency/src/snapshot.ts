@@ -0,0 +1,720 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import { BlockColumns } from './accelerated'
+
+import { createBlockAligner, STATE_BLOCK_LENGTH } from './codec'
+
+import { createKeyTable } from './table'
+
+import { concatArrays } from './utils'
+
+/**
+ * A snapshot is a header ("NBSS" and a version), then segments of blocks,
+ * each one a header of 7 counts then one column per field:
+ *
+ * - the public keys first seen in the segment, 32 bytes each, appended to a
+ *   dictionary shared by accounts, representatives and send links
+ * - a flags byte per block, see below
+ * - the account of every block, as a key
+ * - the representative of the blocks changing it, as a key
+ * - the previous block hash of the blocks not opening an account
+ * - the link of send blocks, as a key
+ * - the link of the other blocks, but for zero ones
+ * - the balance of every block, as the LEB128 difference with the previous
+ *   block of its account in the snapshot (or with zero)
+ * - the signature and the work of every block, as is
+ *
+ * Every count and key is 4 bytes, little endian.
+ */
+const MAGIC = [0x4e, 0x42, 0x53, 0x53]
+const VERSION = 1
+const HEADER_LENGTH = 8
+const SEGMENT_HEADER_LENGTH = 28
+const KEY_LENGTH = 32
+/** 128 bits, by 7 bits groups. */
+const MAX_VARINT_LENGTH = 19
+/** Count of blocks of a segment. */
+const DEFAULT_SEGMENT_LENGTH = 4096
+
+const FLAG_PREVIOUS_ZERO = 1
+const FLAG_REPRESENTATIVE_SAME = 2
+const FLAG_BALANCE_DECREASE = 4
+const FLAG_LINK_ZERO = 8
+const FLAG_LINK_KEY = 16
+const FLAGS = 31
+
+/** The fields of an encoded state block, and their offset. */
+const ACCOUNT_OFFSET = 0
+const PREVIOUS_OFFSET = 32
+const REPRESENTATIVE_OFFSET = 64
+const BALANCE_OFFSET = 96
+const LINK_OFFSET = 112
+const SIGNATURE_OFFSET = 144
+const WORK_OFFSET = 208
+
+function isZero(bytes: Uint8Array, offset: number, length: number): boolean {
+  for (let i = offset; i < offset + length; i++) {
+    if (bytes[i] !== 0) return false
+  }
+
+  return true
+}
+
+/**
+ * The last balance and representative of every account, by key, growing
+ * with the dictionary.
+ */
+interface ChainStates {
+  /** 16 bytes per key, big endian */
+  balances: Uint8Array
+  /** 1 + the representative key per key, or 0 for an account not seen yet */
+  representatives: Uint32Array
+}
+
+function reserveChainStates(states: ChainStates, keyCount: number): void {
+  if (states.representatives.length >= keyCount) return
+
+  const capacity = Math.max(keyCount, 2 * states.representatives.length)
+  const balances = new Uint8Array(capacity * 16)
+  balances.set(states.balances)
+  const representatives = new Uint32Array(capacity)
+  representatives.set(states.representatives)
+  states.balances = balances
+  states.representatives = representatives
+}
+
+/**
+ * Write the difference of two 128 bits big endian balances as LEB128.
+ *
+ * @returns Whether the balance decreased
+ */
+function writeBalanceDelta(
+  balance: Uint8Array,
+  balanceOffset: number,
+  last: Uint8Array,
+  lastOffset: number,
+  out: Uint8Array,
+  outOffset: number,
+  delta: Uint8Array
+): [boolean, number] {
+  let decrease = false
+  for (let i = 0; i < 16; i++) {
+    if (balance[balanceOffset + i] !== last[lastOffset + i]) {
+      decrease = balance[balanceOffset + i] < last[lastOffset + i]
+      break
+    }
+  }
+
+  // the larger minus the smaller
+  let borrow = 0
+  for (let i = 15; i >= 0; i--) {
+    const difference =
+      (balance[balanceOffset + i] - last[lastOffset + i]) *
+        (decrease ? -1 : 1) -
+      borrow
+    borrow = difference < 0 ? 1 : 0
+    delta[i] = difference & 0xff
+  }
+
+  let bits = 128
+  for (let i = 0; i < 16 && delta[i] === 0; i++) bits -= 8
+  if (bits > 0) bits -= Math.clz32(delta[16 - bits / 8]) - 24
+
+  // 7 bits at a time, from the least significant one
+  let offset = outOffset
+  let position = 0
+  do {
+    const byte = 15 - (position >> 3)
+    const shift = position & 7
+    let group = delta[byte] >> shift
+    if (shift > 1 && byte > 0) group |= delta[byte - 1] << (8 - shift)
+    position += 7
+    out[offset++] = (group & 0x7f) | (position < bits ? 0x80 : 0)
+  } while (position < bits)
+
+  return [decrease, offset - outOffset]
+}
+
+/**
+ * Read a LEB128 balance difference, and apply it to the last balance.
+ *
+ * @returns The length read, or -1 if the difference or the balance is not valid
+ */
+function readBalanceDelta(
+  input: Uint8Array,
+  offset: number,
+  end: number,
+  decrease: boolean,
+  balance: Uint8Array,
+  balanceOffset: number,
+  delta: Uint8Array
+): number {
+  delta.fill(0)
+
+  let position = 0
+  let length = 0
+  for (;;) {
+    if (offset + length === end || length === MAX_VARINT_LENGTH) return -1
+    const group = input[offset + length++]
+    const value = group & 0x7f
+    const byte = 15 - (position >> 3)
+    const shift = position & 7
+
+    delta[byte] |= (value << shift) & 0xff
+    if (shift > 1) {
+      if (byte > 0) delta[byte - 1] |= value >> (8 - shift)
+      else if (value >> (8 - shift) !== 0) return -1
+    }
+
+    position += 7
+    if ((group & 0x80) === 0) break
+  }
+
+  let carry = 0
+  for (let i = 15; i >= 0; i--) {
+    const sum = decrease
+      ? balance[balanceOffset + i] - delta[i] - carry
+      : balance[balanceOffset + i] + delta[i] + carry
+    carry = decrease ? (sum < 0 ? 1 : 0) : sum >> 8
+    balance[balanceOffset + i] = sum & 0xff
+  }
+
+  return carry === 0 ? length : -1
+}
+
+/** Snapshot writer parameters. */
+export interface SnapshotWriterParams {
+  /** The count of blocks of a segment, read as a whole. Defaults to `4096` */
+  segmentLength?: number
+}
+
+/** Streaming writing of a snapshot, see [[createSnapshotWriter]]. */
+export interface SnapshotWriter {
+  /**
+   * Feed encoded blocks to the writer.
+   *
+   * @param chunk - Encoded blocks, see [[encodeBlock]], split anywhere
+   * @returns The bytes of the snapshot completed by this chunk
+   */
+  update(chunk: Uint8Array): Uint8Array
+  /**
+   * Write the last blocks fed.
+   *
+   * @returns The last bytes of the snapshot
+   */
+  finish(): Uint8Array
+}
+
+/**
+ * Create a writer of a ledger snapshot, a columnar and far smaller form of
+ * encoded state blocks: the public keys are written once in a dictionary,
+ * and referred to by 4 bytes keys, the balances are written as their
+ * difference along each account chain, and `open` blocks, blocks keeping
+ * their representative and zero links take no room for them. The blocks
+ * are written by segments, each one read as a whole by
+ * [[createSnapshotReader]].
+ *
+ * @param params - Parameters
+ * @returns Snapshot writer
+ */
+export function createSnapshotWriter(
+  params: SnapshotWriterParams = {}
+): SnapshotWriter {
+  const { segmentLength = DEFAULT_SEGMENT_LENGTH } = params
+
+  if (!Number.isInteger(segmentLength) || segmentLength < 1) {
+    throw new Error('Segment length is not valid')
+  }
+
+  // the dictionary key of every public key, 4 bytes little endian
+  const keys = createKeyTable(4)
+  const states: ChainStates = {
+    balances: new Uint8Array(0),
+    representatives: new Uint32Array(0),
+  }
+  const delta = new Uint8Array(16)
+  let headerWritten = false
+  const aligner = createBlockAligner()
+
+  // the columns of the current segment
+  const newKeys: Uint8Array[] = []
+  const flags = new Uint8Array(segmentLength)
+  const accounts = new DataView(new ArrayBuffer(segmentLength * 4))
+  const representatives = new DataView(new ArrayBuffer(segmentLength * 4))
+  const previous = new Uint8Array(segmentLength * 32)
+  const linkKeys = new DataView(new ArrayBuffer(segmentLength * 4))
+  const links = new Uint8Array(segmentLength * 32)
+  const balances = new Uint8Array(segmentLength * MAX_VARINT_LENGTH)
+  const signatures = new Uint8Array(segmentLength * 64)
+  const works = new Uint8Array(segmentLength * 8)
+  let blockCount = 0
+  let representativeCount = 0
+  let previousCount = 0
+  let linkKeyCount = 0
+  let linkCount = 0
+  let balancesLength = 0
+
+  const intern = (block: Uint8Array, offset: number): number => {
+    const keyCount = keys.size
+    const slot = keys.insert(block, offset)
+    const values = keys.values
+    const valueOffset = slot * 4
+    if (keys.size === keyCount) {
+      return (
+        (values[valueOffset] |
+          (values[valueOffset + 1] << 8) |
+          (values[valueOffset + 2] << 16) |
+          (values[valueOffset + 3] << 24)) >>>
+        0
+      )
+    }
+
+    // truncated to a byte each
+    values[valueOffset] = keyCount
+    values[valueOffset + 1] = keyCount >>> 8
+    values[valueOffset + 2] = keyCount >>> 16
+    values[valueOffset + 3] = keyCount >>> 24
+    newKeys.push(block.slice(offset, offset + KEY_LENGTH))
+    reserveChainStates(states, keys.size)
+
+    return keyCount
+  }
+
+  const append = (block: Uint8Array): void => {
+    const account = intern(block, ACCOUNT_OFFSET)
+    const representative = intern(block, REPRESENTATIVE_OFFSET)
+    let blockFlags = 0
+
+    accounts.setUint32(blockCount * 4, account, true)
+
+    if (isZero(block, PREVIOUS_OFFSET, 32)) {
+      blockFlags |= FLAG_PREVIOUS_ZERO
+    } else {
+      previous.set(
+        block.subarray(PREVIOUS_OFFSET, REPRESENTATIVE_OFFSET),
+        previousCount++ * 32
+      )
+    }
+
+    if (states.representatives[account] === representative + 1) {
+      blockFlags |= FLAG_REPRESENTATIVE_SAME
+    } else {
+      representatives.setUint32(representativeCount++ * 4, representative, true)
+      states.representatives[account] = representative + 1
+    }
+
+    const [decrease, length] = writeBalanceDelta(
+      block,
+      BALANCE_OFFSET,
+      states.balances,
+      account * 16,
+      balances,
+      balancesLength,
+      delta
+    )
+    balancesLength += length
+    states.balances.set(
+      block.subarray(BALANCE_OFFSET, LINK_OFFSET),
+      account * 16
+    )
+    if (decrease) blockFlags |= FLAG_BALANCE_DECREASE
+
+    // the link of a send block is the destination account
+    if (isZero(block, LINK_OFFSET, 32)) {
+      blockFlags |= FLAG_LINK_ZERO
+    } else if (decrease) {
+      blockFlags |= FLAG_LINK_KEY
+      linkKeys.setUint32(linkKeyCount++ * 4, intern(block, LINK_OFFSET), true)
+    } else {
+      links.set(block.subarray(LINK_OFFSET, SIGNATURE_OFFSET), linkCount++ * 32)
+    }
+
+    signatures.set(
+      block.subarray(SIGNATURE_OFFSET, WORK_OFFSET),
+      blockCount * 64
+    )
+    works.set(block.subarray(WORK_OFFSET, STATE_BLOCK_LENGTH), blockCount * 8)
+    flags[blockCount++] = blockFlags
+  }
+
+  const writeSegment = (): Uint8Array => {
+    const columns: Uint8Array[] = [
+      new Uint8Array(SEGMENT_HEADER_LENGTH),
+      ...newKeys,
+      flags.subarray(0, blockCount),
+      new Uint8Array(accounts.buffer, 0, blockCount * 4),
+      new Uint8Array(representatives.buffer, 0, representativeCount * 4),
+      previous.subarray(0, previousCount * 32),
+      new Uint8Array(linkKeys.buffer, 0, linkKeyCount * 4),
+      links.subarray(0, linkCount * 32),
+      balances.subarray(0, balancesLength),
+      signatures.subarray(0, blockCount * 64),
+      works.subarray(0, blockCount * 8),
+    ]
+    const header = new DataView(columns[0].buffer)
+    const counts = [
+      blockCount,
+      newKeys.length,
+      representativeCount,
+      previousCount,
+      linkKeyCount,
+      linkCount,
+      balancesLength,
+    ]
+    counts.forEach((count, index) => header.setUint32(index * 4, count, true))
+
+    const segment = concatArrays(columns)
+
+    newKeys.length = 0
+    blockCount = 0
+    representativeCount = 0
+    previousCount = 0
+    linkKeyCount = 0
+    linkCount = 0
+    balancesLength = 0
+
+    return segment
+  }
+
+  const write = (chunk: Uint8Array, last: boolean): Uint8Array => {
+    if (!(chunk instanceof Uint8Array)) throw new Error('Chunk is not valid')
+
+    const runs = aligner.update(chunk)
+    if (last && aligner.pendingLength !== 0) {
+      throw new Error('Blocks are not valid')
+    }
+
+    const output: Uint8Array[] = []
+    if (!headerWritten) {
+      const header = new Uint8Array(HEADER_LENGTH)
+      header.set(MAGIC, 0)
+      new DataView(header.buffer).setUint32(4, VERSION, true)
+      output.push(header)
+      headerWritten = true
+    }
+
+    for (const blocks of runs) {
+      for (
+        let offset = 0;
+        offset < blocks.length;
+        offset += STATE_BLOCK_LENGTH
+      ) {
+        append(blocks.subarray(offset, offset + STATE_BLOCK_LENGTH))
+        if (blockCount === segmentLength) output.push(writeSegment())
+      }
+    }
+    if (last && blockCount > 0) output.push(writeSegment())
+
+    return concatArrays(output)
+  }
+
+  return {
+    update: chunk => write(chunk, false),
+    finish: () => write(new Uint8Array(0), true),
+  }
+}
+
+/** A segment of blocks read from a snapshot, see [[createSnapshotReader]]. */
+export interface SnapshotSegment {
+  /** The index of the first block of the segment in the snapshot */
+  firstIndex: number
+  /** The count of blocks */
+  blockCount: number
+  /** The hashed fields of the blocks, as given to [[hashBlocks]] */
+  columns: BlockColumns
+  /** The signatures, 64 bytes each */
+  signatures: Uint8Array
+  /** The works, 8 bytes each, big endian */
+  works: Uint8Array
+  /**
+   * Encode the blocks, as given to [[verifyBlocks]] or a ledger verifier.
+   *
+   * @returns Blocks, encoded back to back, see [[encodeBlock]]
+   */
+  encode(): Uint8Array
+}
+
+/** Streaming reading of a snapshot, see [[createSnapshotReader]]. */
+export interface SnapshotReader {
+  /**
+   * Feed a snapshot to the reader.
+   *
+   * @param chunk - Snapshot bytes, split anywhere
+   * @returns The segments completed by this chunk
+   */
+  update(chunk: Uint8Array): SnapshotSegment[]
+  /** Check that the snapshot ended on a whole segment. */
+  finish(): void
+}
+
+function encodeSegment(segment: SnapshotSegment): Uint8Array {
+  const { columns, signatures, works } = segment
+  const blocks = new Uint8Array(segment.blockCount * STATE_BLOCK_LENGTH)
+
+  for (let i = 0; i < segment.blockCount; i++) {
+    const offset = i * STATE_BLOCK_LENGTH
+    blocks.set(columns.accounts.subarray(i * 32, (i + 1) * 32), offset)
+    blocks.set(
+      columns.previous.subarray(i * 32, (i + 1) * 32),
+      offset + PREVIOUS_OFFSET
+    )
+    blocks.set(
+      columns.representatives.subarray(i * 32, (i + 1) * 32),
+      offset + REPRESENTATIVE_OFFSET
+    )
+    blocks.set(
+      columns.balances.subarray(i * 16, (i + 1) * 16),
+      offset + BALANCE_OFFSET
+    )
+    blocks.set(
+      columns.links.subarray(i * 32, (i + 1) * 32),
+      offset + LINK_OFFSET
+    )
+    blocks.set(
+      signatures.subarray(i * 64, (i + 1) * 64),
+      offset + SIGNATURE_OFFSET
+    )
+    blocks.set(works.subarray(i * 8, (i + 1) * 8), offset + WORK_OFFSET)
+  }
+
+  return blocks
+}
+
+/**
+ * Create a reader of a snapshot written by [[createSnapshotWriter]]. Every
+ * segment is decoded into columns, ready to be hashed by [[hashBlocks]], or
+ * encoded back into blocks to be verified.
+ *
+ * @returns Snapshot reader
+ */
+export function createSnapshotReader(): SnapshotReader {
+  let keys = new Uint8Array(0)
+  let keyCount = 0
+  const states: ChainStates = {
+    balances: new Uint8Array(0),
+    representatives: new Uint32Array(0),
+  }
+  const delta = new Uint8Array(16)
+  let headerRead = false
+  let firstIndex = 0
+  let remainder = new Uint8Array(0)
+
+  const invalid = (): never => {
+    throw new Error('Snapshot is not valid')
+  }
+
+  /** Decode a segment, given its counts, or return null if incomplete. */
+  const readSegment = (
+    input: Uint8Array,
+    offset: number
+  ): [SnapshotSegment, number] | null => {
+    if (input.length - offset < SEGMENT_HEADER_LENGTH) return null
+    const header = new DataView(
+      input.buffer,
+      input.byteOffset + offset,
+      SEGMENT_HEADER_LENGTH
+    )
+    const [
+      blockCount,
+      newKeyCount,
+      representativeCount,
+      previousCount,
+      linkKeyCount,
+      linkCount,
+      balancesLength,
+    ] = [0, 1, 2, 3, 4, 5, 6].map(index => header.getUint32(index * 4, true))
+
+    // the offsets of the columns, in order
+    const sizes = [
+      newKeyCount * KEY_LENGTH,
+      blockCount,
+      blockCount * 4,
+      representativeCount * 4,
+      previousCount * 32,
+      linkKeyCount * 4,
+      linkCount * 32,
+      balancesLength,
+      blockCount * 64,
+      blockCount * 8,
+    ]
+    const starts: number[] = []
+    let end = offset + SEGMENT_HEADER_LENGTH
+    for (const size of sizes) {
+      starts.push(end)
+      end += size
+    }
+    if (input.length < end) return null
+
+    const [
+      keysStart,
+      flagsStart,
+      accountsStart,
+      representativesStart,
+      previousStart,
+      linkKeysStart,
+      linksStart,
+      balancesStart,
+      signaturesStart,
+      worksStart,
+    ] = starts
+    const view = new DataView(input.buffer, input.byteOffset, input.length)
+
+    if (keys.length < (keyCount + newKeyCount) * KEY_LENGTH) {
+      const grown = new Uint8Array(
+        Math.max(keyCount + newKeyCount, 2 * keyCount) * KEY_LENGTH
+      )
+      grown.set(keys)
+      keys = grown
+    }
+    keys.set(input.subarray(keysStart, flagsStart), keyCount * KEY_LENGTH)
+    keyCount += newKeyCount
+    reserveChainStates(states, keyCount)
+
+    const readKey = (start: number, index: number): number => {
+      const key = view.getUint32(start + index * 4, true)
+      return key < keyCount ? key : invalid()
+    }
+    const copyKey = (key: number, dst: Uint8Array, index: number): void =>
+      dst.set(
+        keys.subarray(key * KEY_LENGTH, (key + 1) * KEY_LENGTH),
+        index * 32
+      )
+
+    const columns: BlockColumns = {
+      accounts: new Uint8Array(blockCount * 32),
+      previous: new Uint8Array(blockCount * 32),
+      representatives: new Uint8Array(blockCount * 32),
+      balances: new Uint8Array(blockCount * 16),
+      links: new Uint8Array(blockCount * 32),
+    }
+    let representativeIndex = 0
+    let previousIndex = 0
+    let linkKeyIndex = 0
+    let linkIndex = 0
+    let balancesOffset = balancesStart
+
+    for (let i = 0; i < blockCount; i++) {
+      const blockFlags = input[flagsStart + i]
+      if ((blockFlags & ~FLAGS) !== 0) invalid()
+
+      const account = readKey(accountsStart, i)
+      copyKey(account, columns.accounts, i)
+
+      if ((blockFlags & FLAG_PREVIOUS_ZERO) === 0) {
+        if (previousIndex === previousCount) invalid()
+        columns.previous.set(
+          input.subarray(
+            previousStart + previousIndex * 32,
+            previousStart + ++previousIndex * 32
+          ),
+          i * 32
+        )
+      }
+
+      if ((blockFlags & FLAG_REPRESENTATIVE_SAME) === 0) {
+        if (representativeIndex === representativeCount) invalid()
+        states.representatives[account] =
+          readKey(representativesStart, representativeIndex++) + 1
+      } else if (states.representatives[account] === 0) {
+        invalid()
+      }
+      copyKey(states.representatives[account] - 1, columns.representatives, i)
+
+      const length = readBalanceDelta(
+        input,
+        balancesOffset,
+        signaturesStart,
+        (blockFlags & FLAG_BALANCE_DECREASE) !== 0,
+        states.balances,
+        account * 16,
+        delta
+      )
+      if (length === -1) invalid()
+      balancesOffset += length
+      columns.balances.set(
+        states.balances.subarray(account * 16, (account + 1) * 16),
+        i * 16
+      )
+
+      if ((blockFlags & FLAG_LINK_KEY) !== 0) {
+        if (linkKeyIndex === linkKeyCount) invalid()
+        copyKey(readKey(linkKeysStart, linkKeyIndex++), columns.links, i)
+      } else if ((blockFlags & FLAG_LINK_ZERO) === 0) {
+        if (linkIndex === linkCount) invalid()
+        columns.links.set(
+          input.subarray(
+            linksStart + linkIndex * 32,
+            linksStart + ++linkIndex * 32
+          ),
+          i * 32
+        )
+      }
+    }
+
+    if (
+      representativeIndex !== representativeCount ||
+      previousIndex !== previousCount ||
+      linkKeyIndex !== linkKeyCount ||
+      linkIndex !== linkCount ||
+      balancesOffset !== signaturesStart
+    ) {
+      invalid()
+    }
+
+    const segment: SnapshotSegment = {
+      firstIndex,
+      blockCount,
+      columns,
+      signatures: input.slice(signaturesStart, worksStart),
+      works: input.slice(worksStart, end),
+      encode: () => encodeSegment(segment),
+    }
+    firstIndex += blockCount
+
+    return [segment, end]
+  }
+
+  return {
+    update: chunk => {
+      if (!(chunk instanceof Uint8Array)) throw new Error('Chunk is not valid')
+
+      const input =
+        remainder.length === 0 ? chunk : concatArrays([remainder, chunk])
+      let offset = 0
+      if (!headerRead) {
+        if (input.length < HEADER_LENGTH) {
+          remainder = input.slice()
+          return []
+        }
+        if (
+          MAGIC.some((byte, i) => input[i] !== byte) ||
+          new DataView(input.buffer, input.byteOffset).getUint32(4, true) !==
+            VERSION
+        ) {
+          invalid()
+        }
+        headerRead = true
+        offset = HEADER_LENGTH
+      }
+
+      const segments: SnapshotSegment[] = []
+      for (
+        let read = readSegment(input, offset);
+        read !== null;
+        read = readSegment(input, offset)
+      ) {
+        segments.push(read[0])
+        offset = read[1]
+      }
+      remainder = input.slice(offset)
+
+      return segments
+    },
+    finish: () => {
+      if (!headerRead || remainder.length !== 0) invalid()
+    },
+  }
+}
@@ -0,0 +1,360 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import {
+  hashBlocks,
+  STATE_BLOCK_HASH_LENGTH,
+  STATE_BLOCK_PREIMAGE_LENGTH,
+} from './accelerated'
+
+import { checkHash } from './check'
+
+import { BlockView, STATE_BLOCK_LENGTH, viewBlock } from './codec'
+
+import { byteArrayToHex, hexToByteArray } from './utils'
+
+/**
+ * The index of a block store, also written and read by the native
+ * `block-store` tool (see `src/assembly/store.h`): a header ("NBSI",
+ * version, block count and slot count), the hash of every block, the
+ * successor of every block in its account chain, then an open addressing
+ * table of blocks by hash. Every integer is 4 bytes, little endian, and a
+ * block is stored as 1 + its index, 0 meaning none.
+ */
+const HEADER_LENGTH = 16
+const VERSION = 1
+const MAGIC = [0x4e, 0x42, 0x53, 0x49]
+/** So that the slots, at least twice as many, are counted on 32 bits. */
+const MAX_BLOCK_COUNT = 0x40000000
+/** Count of blocks hashed by a single call into WebAssembly. */
+const HASH_BATCH_LENGTH = 4096
+
+/** The offsets of the sections of an index, and its length. */
+interface IndexLayout {
+  blockCount: number
+  slotCount: number
+  successorsOffset: number
+  slotsOffset: number
+  length: number
+}
+
+function computeLayout(blockCount: number): IndexLayout {
+  let slotCount = 1
+  while (slotCount < 2 * blockCount) slotCount *= 2
+
+  const successorsOffset = HEADER_LENGTH + blockCount * STATE_BLOCK_HASH_LENGTH
+  const slotsOffset = successorsOffset + blockCount * 4
+
+  return {
+    blockCount,
+    slotCount,
+    successorsOffset,
+    slotsOffset,
+    length: slotsOffset + slotCount * 4,
+  }
+}
+
+function checkBlocks(blocks: Uint8Array): number {
+  if (
+    !(blocks instanceof Uint8Array) ||
+    blocks.length % STATE_BLOCK_LENGTH !== 0 ||
+    blocks.length / STATE_BLOCK_LENGTH > MAX_BLOCK_COUNT
+  ) {
+    throw new Error('Blocks are not valid')
+  }
+
+  return blocks.length / STATE_BLOCK_LENGTH
+}
+
+/**
+ * Find a block by hash, probing from the slot given by the first 4 bytes of
+ * the hash, block hashes being uniform.
+ *
+ * @returns The index of the block, or -1
+ */
+function findBlock(
+  index: Uint8Array,
+  view: DataView,
+  layout: IndexLayout,
+  hash: Uint8Array,
+  hashOffset: number
+): number {
+  const mask = layout.slotCount - 1
+  let slot =
+    (hash[hashOffset] |
+      (hash[hashOffset + 1] << 8) |
+      (hash[hashOffset + 2] << 16) |
+      (hash[hashOffset + 3] << 24)) &
+    mask
+
+  for (;;) {
+    const entry = view.getUint32(layout.slotsOffset + slot * 4, true)
+    if (entry === 0) return -1
+
+    const entryOffset = HEADER_LENGTH + (entry - 1) * STATE_BLOCK_HASH_LENGTH
+    let i = 0
+    while (
+      i < STATE_BLOCK_HASH_LENGTH &&
+      index[entryOffset + i] === hash[hashOffset + i]
+    ) {
+      i++
+    }
+    if (i === STATE_BLOCK_HASH_LENGTH) return entry - 1
+
+    slot = (slot + 1) & mask
+  }
+}
+
+/**
+ * Index encoded state blocks by hash, for [[openBlockStore]]. The blocks
+ * are hashed in WebAssembly, and the index takes 36 bytes per block, plus
+ * 8 to 16 bytes per block of hash table. When blocks share a hash, or a
+ * previous block, the first one wins.
+ * Require WebAssembly support.
+ *
+ * @param blocks - The blocks, encoded back to back, see [[encodeBlock]]
+ * @returns Index
+ */
+export async function createBlockStoreIndex(
+  blocks: Uint8Array
+): Promise<Uint8Array> {
+  const blockCount = checkBlocks(blocks)
+  const layout = computeLayout(blockCount)
+  const index = new Uint8Array(layout.length)
+  const view = new DataView(index.buffer)
+
+  index.set(MAGIC, 0)
+  view.setUint32(4, VERSION, true)
+  view.setUint32(8, blockCount, true)
+  view.setUint32(12, layout.slotCount, true)
+
+  // the preamble is written once, and every block copied after it
+  const preimages = new Uint8Array(
+    Math.min(blockCount, HASH_BATCH_LENGTH) * STATE_BLOCK_PREIMAGE_LENGTH
+  )
+  for (let i = 31; i < preimages.length; i += STATE_BLOCK_PREIMAGE_LENGTH) {
+    preimages[i] = 6
+  }
+  for (let first = 0; first < blockCount; first += HASH_BATCH_LENGTH) {
+    const count = Math.min(HASH_BATCH_LENGTH, blockCount - first)
+    for (let i = 0; i < count; i++) {
+      const offset = (first + i) * STATE_BLOCK_LENGTH
+      preimages.set(
+        blocks.subarray(offset, offset + STATE_BLOCK_PREIMAGE_LENGTH - 32),
+        i * STATE_BLOCK_PREIMAGE_LENGTH + 32
+      )
+    }
+
+    const hashesOffset = HEADER_LENGTH + first * STATE_BLOCK_HASH_LENGTH
+    await hashBlocks(
+      preimages.subarray(0, count * STATE_BLOCK_PREIMAGE_LENGTH),
+      { hashes: index.subarray(hashesOffset) }
+    )
+  }
+
+  const mask = layout.slotCount - 1
+  for (let i = 0; i < blockCount; i++) {
+    const hashOffset = HEADER_LENGTH + i * STATE_BLOCK_HASH_LENGTH
+    // a duplicate is found instead of being inserted
+    if (findBlock(index, view, layout, index, hashOffset) !== -1) continue
+
+    let slot = view.getUint32(hashOffset, true) & mask
+    while (view.getUint32(layout.slotsOffset + slot * 4, true) !== 0) {
+      slot = (slot + 1) & mask
+    }
+    view.setUint32(layout.slotsOffset + slot * 4, i + 1, true)
+  }
+
+  // once every hash is indexed, each block is the successor of its previous
+  for (let i = 0; i < blockCount; i++) {
+    const previousOffset = i * STATE_BLOCK_LENGTH + 32
+    let zero = true
+    for (let j = 0; zero && j < STATE_BLOCK_HASH_LENGTH; j++) {
+      zero = blocks[previousOffset + j] === 0
+    }
+    if (zero) continue
+
+    const previous = findBlock(index, view, layout, blocks, previousOffset)
+    if (previous === -1) continue
+
+    const successorOffset = layout.successorsOffset + previous * 4
+    if (view.getUint32(successorOffset, true) === 0) {
+      view.setUint32(successorOffset, i + 1, true)
+    }
+  }
+
+  return index
+}
+
+/** Random access to encoded state blocks by hash, see [[openBlockStore]]. */
+export interface BlockStore {
+  /** The count of blocks */
+  readonly blockCount: number
+  /**
+   * Find a block by hash.
+   *
+   * @param hash - The block hash
+   * @returns The index of the block, or -1
+   */
+  indexOf(hash: string): number
+  /**
+   * Find a block by hash.
+   *
+   * @param hash - The block hash
+   * @returns View on the block, or `null`
+   */
+  get(hash: string): BlockView | null
+  /**
+   * @param blockIndex - The index of the block
+   * @returns View on the block
+   */
+  at(blockIndex: number): BlockView
+  /**
+   * @param blockIndex - The index of the block
+   * @returns The block hash, read from the index
+   */
+  hashAt(blockIndex: number): string
+  /**
+   * @param blockIndex - The index of the block
+   * @returns The index of the previous block of its account chain, or -1 for an `open` block or a previous block not in the store
+   */
+  previousOf(blockIndex: number): number
+  /**
+   * @param blockIndex - The index of the block
+   * @returns The index of the next block of its account chain, or -1 for a frontier
+   */
+  successorOf(blockIndex: number): number
+  /**
+   * Call a function on every block, in order.
+   *
+   * @param callback - Called with every block and its index, return `false` to stop
+   */
+  forEach(
+    callback: (block: BlockView, blockIndex: number) => boolean | void
+  ): void
+  /**
+   * Follow the account chain of a block both ways.
+   *
+   * @param hash - The hash of any block of the chain
+   * @returns The indexes of the blocks of the chain, from its `open` block (or the first block in the store) to its frontier, or an empty array if the block is not in the store
+   */
+  getAccountChain(hash: string): number[]
+}
+
+/**
+ * Open a store of encoded state blocks, indexed by [[createBlockStoreIndex]]
+ * or by the native `block-store` tool. The blocks and the index are used in
+ * place, and a lookup reads a couple of slots of the hash table.
+ *
+ * @param blocks - The blocks, encoded back to back, see [[encodeBlock]]
+ * @param index - The index of the blocks
+ * @returns Block store
+ */
+export function openBlockStore(
+  blocks: Uint8Array,
+  index: Uint8Array
+): BlockStore {
+  const blockCount = checkBlocks(blocks)
+  const layout = computeLayout(blockCount)
+  if (
+    !(index instanceof Uint8Array) ||
+    index.length !== layout.length ||
+    MAGIC.some((byte, i) => index[i] !== byte)
+  ) {
+    throw new Error('Index is not valid')
+  }
+  const view = new DataView(index.buffer, index.byteOffset, index.length)
+  if (
+    view.getUint32(4, true) !== VERSION ||
+    view.getUint32(8, true) !== blockCount ||
+    view.getUint32(12, true) !== layout.slotCount
+  ) {
+    throw new Error('Index is not valid')
+  }
+
+  const find = (hash: string): number => {
+    if (!checkHash(hash)) throw new Error('Hash is not valid')
+
+    return findBlock(index, view, layout, hexToByteArray(hash), 0)
+  }
+  const checkBlockIndex = (blockIndex: number): void => {
+    if (
+      !Number.isInteger(blockIndex) ||
+      blockIndex < 0 ||
+      blockIndex >= blockCount
+    ) {
+      throw new Error('Block index is not valid')
+    }
+  }
+  const previousOf = (blockIndex: number): number => {
+    checkBlockIndex(blockIndex)
+
+    return findBlock(
+      index,
+      view,
+      layout,
+      blocks,
+      blockIndex * STATE_BLOCK_LENGTH + 32
+    )
+  }
+  const successorOf = (blockIndex: number): number => {
+    checkBlockIndex(blockIndex)
+
+    return view.getUint32(layout.successorsOffset + blockIndex * 4, true) - 1
+  }
+
+  return {
+    blockCount,
+    indexOf: find,
+    get: hash => {
+      const blockIndex = find(hash)
+
+      return blockIndex === -1
+        ? null
+        : viewBlock(blocks, blockIndex * STATE_BLOCK_LENGTH)
+    },
+    at: blockIndex => {
+      checkBlockIndex(blockIndex)
+
+      return viewBlock(blocks, blockIndex * STATE_BLOCK_LENGTH)
+    },
+    hashAt: blockIndex => {
+      checkBlockIndex(blockIndex)
+      const offset = HEADER_LENGTH + blockIndex * STATE_BLOCK_HASH_LENGTH
+
+      return byteArrayToHex(
+        index.subarray(offset, offset + STATE_BLOCK_HASH_LENGTH)
+      )
+    },
+    previousOf,
+    successorOf,
+    forEach: callback => {
+      for (let i = 0; i < blockCount; i++) {
+        if (callback(viewBlock(blocks, i * STATE_BLOCK_LENGTH), i) === false) {
+          return
+        }
+      }
+    },
+    getAccountChain: hash => {
+      let blockIndex = find(hash)
+      if (blockIndex === -1) return []
+
+      for (
+        let previous = previousOf(blockIndex);
+        previous !== -1;
+        previous = previousOf(blockIndex)
+      ) {
+        blockIndex = previous
+      }
+
+      const chain: number[] = []
+      for (; blockIndex !== -1; blockIndex = successorOf(blockIndex)) {
+        chain.push(blockIndex)
+      }
+
+      return chain
+    },
+  }
+}
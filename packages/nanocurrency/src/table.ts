@@ -0,0 +1,161 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+const KEY_LENGTH = 32
+const MIN_CAPACITY = 16
+
+/**
+ * An open addressing table of 32 bytes keys, such as public keys or block
+ * hashes, each one with a fixed length value, held in typed arrays rather
+ * than in a `Map` of strings. It grows as keys are inserted.
+ *
+ * @hidden
+ */
+export interface KeyTable {
+  /** The count of keys */
+  readonly size: number
+  /** The count of slots, a power of 2 */
+  readonly capacity: number
+  /** The keys, 32 bytes per slot */
+  readonly keys: Uint8Array
+  /** The values, of the given length per slot */
+  readonly values: Uint8Array
+  /**
+   * @param bytes - The key bytes
+   * @param offset - The offset of the key
+   * @returns The slot of the key, or -1
+   */
+  find(bytes: Uint8Array, offset: number): number
+  /**
+   * Insert a key, its value zeroed, unless already there.
+   *
+   * @param bytes - The key bytes
+   * @param offset - The offset of the key
+   * @returns The slot of the key, which stays valid until the next insertion
+   */
+  insert(bytes: Uint8Array, offset: number): number
+  /**
+   * Call a function on every slot holding a key.
+   *
+   * @param callback - Called with the slot
+   */
+  forEach(callback: (slot: number) => void): void
+}
+
+/**
+ * The slot of a key is given by its bytes 24 to 27, uniform for public keys
+ * and block hashes, and left to other filters to use the first bytes.
+ */
+function home(bytes: Uint8Array, offset: number, mask: number): number {
+  return (
+    (bytes[offset + 24] |
+      (bytes[offset + 25] << 8) |
+      (bytes[offset + 26] << 16) |
+      (bytes[offset + 27] << 24)) &
+    mask
+  )
+}
+
+/**
+ * Create a key table.
+ *
+ * @hidden
+ * @param valueLength - The length of the value of each key
+ * @param expectedSize - The count of keys to make room for
+ */
+export function createKeyTable(
+  valueLength: number,
+  expectedSize = 0
+): KeyTable {
+  let capacity = MIN_CAPACITY
+  while (capacity < 2 * expectedSize) capacity *= 2
+
+  let size = 0
+  let used = new Uint8Array(capacity)
+  let keys = new Uint8Array(capacity * KEY_LENGTH)
+  let values = new Uint8Array(capacity * valueLength)
+
+  // linear probing, up to an empty slot or the key
+  const probe = (bytes: Uint8Array, offset: number): number => {
+    const mask = capacity - 1
+    let slot = home(bytes, offset, mask)
+
+    for (; used[slot] !== 0; slot = (slot + 1) & mask) {
+      const keyOffset = slot * KEY_LENGTH
+      let i = 0
+      while (i < KEY_LENGTH && keys[keyOffset + i] === bytes[offset + i]) i++
+      if (i === KEY_LENGTH) return slot
+    }
+
+    return slot
+  }
+
+  const grow = (): void => {
+    const oldCapacity = capacity
+    const oldUsed = used
+    const oldKeys = keys
+    const oldValues = values
+
+    capacity *= 2
+    used = new Uint8Array(capacity)
+    keys = new Uint8Array(capacity * KEY_LENGTH)
+    values = new Uint8Array(capacity * valueLength)
+
+    for (let oldSlot = 0; oldSlot < oldCapacity; oldSlot++) {
+      if (oldUsed[oldSlot] === 0) continue
+
+      const slot = probe(oldKeys, oldSlot * KEY_LENGTH)
+      used[slot] = 1
+      keys.set(
+        oldKeys.subarray(oldSlot * KEY_LENGTH, (oldSlot + 1) * KEY_LENGTH),
+        slot * KEY_LENGTH
+      )
+      values.set(
+        oldValues.subarray(oldSlot * valueLength, (oldSlot + 1) * valueLength),
+        slot * valueLength
+      )
+    }
+  }
+
+  return {
+    get size(): number {
+      return size
+    },
+    get capacity(): number {
+      return capacity
+    },
+    get keys(): Uint8Array {
+      return keys
+    },
+    get values(): Uint8Array {
+      return values
+    },
+    find: (bytes, offset) => {
+      const slot = probe(bytes, offset)
+
+      return used[slot] === 0 ? -1 : slot
+    },
+    insert: (bytes, offset) => {
+      let slot = probe(bytes, offset)
+      if (used[slot] !== 0) return slot
+
+      // at most half full, so that probes stay short
+      if (2 * (size + 1) > capacity) {
+        grow()
+        slot = probe(bytes, offset)
+      }
+      used[slot] = 1
+      keys.set(bytes.subarray(offset, offset + KEY_LENGTH), slot * KEY_LENGTH)
+      size++
+
+      return slot
+    },
+    forEach: callback => {
+      for (let slot = 0; slot < capacity; slot++) {
+        if (used[slot] !== 0) callback(slot)
+      }
+    },
+  }
+}
@@ -0,0 +1,139 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+
+/*
+ * Raw amounts as 16 bytes big endian integers, the way blocks encode
+ * balances, computed on in place rather than through `BigNumber` objects.
+ */
+/** @hidden */
+export const U128_LENGTH = 16
+
+/**
+ * Compare two amounts.
+ *
+ * @hidden
+ * @returns A negative number, zero or a positive number
+ */
+export function compareU128(
+  a: Uint8Array,
+  aOffset: number,
+  b: Uint8Array,
+  bOffset: number
+): number {
+  for (let i = 0; i < U128_LENGTH; i++) {
+    const difference = a[aOffset + i] - b[bOffset + i]
+    if (difference !== 0) return difference
+  }
+
+  return 0
+}
+
+/**
+ * Add an amount to another one, in place.
+ *
+ * @hidden
+ * @returns Whether the sum overflowed, the amount then wrapping around
+ */
+export function addU128(
+  dst: Uint8Array,
+  dstOffset: number,
+  a: Uint8Array,
+  aOffset: number
+): boolean {
+  let carry = 0
+  for (let i = U128_LENGTH - 1; i >= 0; i--) {
+    const sum = dst[dstOffset + i] + a[aOffset + i] + carry
+    dst[dstOffset + i] = sum & 0xff
+    carry = sum >> 8
+  }
+
+  return carry !== 0
+}
+
+/**
+ * Subtract an amount from another one, in place.
+ *
+ * @hidden
+ * @returns Whether the difference underflowed, the amount then wrapping around
+ */
+export function subtractU128(
+  dst: Uint8Array,
+  dstOffset: number,
+  a: Uint8Array,
+  aOffset: number
+): boolean {
+  let borrow = 0
+  for (let i = U128_LENGTH - 1; i >= 0; i--) {
+    const difference = dst[dstOffset + i] - a[aOffset + i] - borrow
+    dst[dstOffset + i] = difference & 0xff
+    borrow = difference < 0 ? 1 : 0
+  }
+
+  return borrow !== 0
+}
+
+/**
+ * Format a big endian unsigned integer of an even count of bytes, such as a
+ * sum of amounts wider than 128 bits, as a decimal string.
+ *
+ * @hidden
+ */
+export function uintToString(
+  bytes: Uint8Array,
+  offset: number,
+  length: number
+): string {
+  // 16 bits limbs, so that a limb and a remainder below 1e9 fit in a double
+  const limbs: number[] = []
+  for (let i = 0; i < length; i += 2) {
+    limbs.push((bytes[offset + i] << 8) | bytes[offset + i + 1])
+  }
+
+  let digits = ''
+  for (;;) {
+    let remainder = 0
+    let zero = true
+    for (let i = 0; i < limbs.length; i++) {
+      const value = remainder * 0x10000 + limbs[i]
+      limbs[i] = Math.floor(value / 1e9)
+      remainder = value % 1e9
+      if (limbs[i] !== 0) zero = false
+    }
+
+    if (zero) return remainder.toString() + digits
+    digits = ('00000000' + remainder).slice(-9) + digits
+  }
+}
+
+/**
+ * Format an amount in raw, as a decimal string.
+ *
+ * @hidden
+ */
+export function u128ToString(bytes: Uint8Array, offset = 0): string {
+  return uintToString(bytes, offset, U128_LENGTH)
+}
+
+/**
+ * Parse an amount in raw, checked with `checkAmount`.
+ *
+ * @hidden
+ */
+export function u128FromString(amount: string): Uint8Array {
+  const bytes = new Uint8Array(U128_LENGTH)
+
+  // multiply by 10 and add each digit
+  for (let i = 0; i < amount.length; i++) {
+    let carry = amount.charCodeAt(i) - 48
+    for (let j = U128_LENGTH - 1; j >= 0; j--) {
+      const value = bytes[j] * 10 + carry
+      bytes[j] = value & 0xff
+      carry = value >> 8
+    }
+  }
+
+  return bytes
+}
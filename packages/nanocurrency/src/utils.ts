@@ -72,3 +72,48 @@ export function compareArrays(array1: Uint8Array, array2: Uint8Array): boolean {
 
   return true
 }
+
+/** @hidden */
+export function concatArrays(arrays: Uint8Array[]): Uint8Array {
+  if (arrays.length === 1) return arrays[0]
+
+  const length = arrays.reduce((sum, array) => sum + array.length, 0)
+  const concatenated = new Uint8Array(length)
+  let offset = 0
+  for (const array of arrays) {
+    concatenated.set(array, offset)
+    offset += array.length
+  }
+
+  return concatenated
+}
+
+/**
+ * Define an enumerable property computed on first access only, and kept
+ * afterwards. It can still be assigned, as a plain property.
+ *
+ * @hidden
+ */
+export function defineLazyProperty<T, K extends keyof T>(
+  object: T,
+  key: K,
+  compute: () => T[K]
+): void {
+  const define = (value: T[K]): T[K] => {
+    Object.defineProperty(object, key, {
+      value,
+      configurable: true,
+      enumerable: true,
+      writable: true,
+    })
+
+    return value
+  }
+
+  Object.defineProperty(object, key, {
+    configurable: true,
+    enumerable: true,
+    get: () => define(compute()),
+    set: define,
+  })
+}
@@ -0,0 +1,227 @@
+/*!
+ * nanocurrency-js: A toolkit for the Nano cryptocurrency.
+ * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
+ * Licensed under GPL-3.0 (https://git.io/vAZsK)
+ */
+import { checkAmount } from './check'
+
+import { createBlockAligner, STATE_BLOCK_LENGTH } from './codec'
+
+import { unsafeDeriveCachedAddress } from './keys'
+
+import { createKeyTable } from './table'
+
+import {
+  addU128,
+  subtractU128,
+  U128_LENGTH,
+  u128FromString,
+  u128ToString,
+  uintToString,
+} from './u128'
+
+import { byteArrayToHex } from './utils'
+
+/** The whole supply, held by the genesis account at first. */
+const DEFAULT_SUPPLY = '340282366920938463463374607431768211455'
+
+/** The representative and the balance, next to each other in a block. */
+const REPRESENTATIVE_OFFSET = 64
+const STATE_LENGTH = 48
+
+/**
+ * Sums of balances are 4 bytes wider than a balance, so that they cannot
+ * overflow whatever the ledger holds.
+ */
+const SUM_LENGTH = 20
+const SUM_HIGH_LENGTH = SUM_LENGTH - U128_LENGTH
+
+function addToSum(
+  sum: Uint8Array,
+  sumOffset: number,
+  amount: Uint8Array,
+  amountOffset: number
+): void {
+  if (!addU128(sum, sumOffset + SUM_HIGH_LENGTH, amount, amountOffset)) return
+
+  for (let i = sumOffset + SUM_HIGH_LENGTH - 1; i >= sumOffset; i--) {
+    sum[i] = (sum[i] + 1) & 0xff
+    if (sum[i] !== 0) return
+  }
+}
+
+/** Compare big endian integers, or keys, of the same length. */
+function compareBytes(
+  a: Uint8Array,
+  aOffset: number,
+  b: Uint8Array,
+  bOffset: number,
+  length: number
+): number {
+  for (let i = 0; i < length; i++) {
+    const difference = a[aOffset + i] - b[bOffset + i]
+    if (difference !== 0) return difference
+  }
+
+  return 0
+}
+
+/** Weight aggregator parameters. */
+export interface WeightAggregatorParams {
+  /** The supply the balances are checked against, in raw. Defaults to the whole supply, `340282366920938463463374607431768211455` */
+  supply?: string
+}
+
+/** The voting weight of a representative. */
+export interface RepresentativeWeight {
+  /** The representative address */
+  representative: string
+  /** The sum of the balances of the accounts choosing it, in raw */
+  weight: string
+}
+
+/** The outcome of a weight aggregation. */
+export interface WeightReport {
+  /** The count of blocks aggregated */
+  blockCount: number
+  /** The count of accounts */
+  accountCount: number
+  /** The sum of the balances of every account, in raw */
+  total: string
+  /** The supply the total is checked against, in raw */
+  supply: string
+  /** Whether the total exceeds the supply, which a valid ledger never does */
+  exceedsSupply: boolean
+  /** The supply held by no account, receivable or burned, in raw, or `0` when the total exceeds the supply */
+  unaccounted: string
+  /** The representatives with a weight, from the heaviest one */
+  weights: RepresentativeWeight[]
+}
+
+/** Streaming aggregation of a ledger, see [[createWeightAggregator]]. */
+export interface WeightAggregator {
+  /**
+   * Feed encoded blocks to the aggregator.
+   *
+   * @param chunk - Encoded blocks, see [[encodeBlock]], split anywhere
+   */
+  update(chunk: Uint8Array): void
+  /**
+   * Aggregate the latest block of every account.
+   *
+   * @returns Report
+   */
+  finish(): WeightReport
+}
+
+/**
+ * Create an aggregator of the voting weight of every representative, and
+ * of the total of the balances checked against the supply. The latest block
+ * of an account, the last one fed, sets its balance and its representative:
+ * the blocks are expected in the order of each account chain, as in a ledger
+ * export or a snapshot, or as a list of frontiers.
+ *
+ * The representative and the balance of every account are kept in a table
+ * of typed arrays, and the sums computed on 128 bits integers, rather than
+ * with an object per account or per amount.
+ *
+ * @param params - Parameters
+ * @returns Aggregator
+ */
+export function createWeightAggregator(
+  params: WeightAggregatorParams = {}
+): WeightAggregator {
+  const { supply = DEFAULT_SUPPLY } = params
+
+  if (!checkAmount(supply)) throw new Error('Supply is not valid')
+  const supplyBytes = u128FromString(supply)
+  const supplySum = new Uint8Array(SUM_LENGTH)
+  supplySum.set(supplyBytes, SUM_HIGH_LENGTH)
+
+  const accounts = createKeyTable(STATE_LENGTH)
+  let blockCount = 0
+  const aligner = createBlockAligner()
+
+  return {
+    update: chunk => {
+      if (!(chunk instanceof Uint8Array)) throw new Error('Chunk is not valid')
+
+      for (const blocks of aligner.update(chunk)) {
+        for (
+          let offset = 0;
+          offset < blocks.length;
+          offset += STATE_BLOCK_LENGTH
+        ) {
+          const slot = accounts.insert(blocks, offset)
+          accounts.values.set(
+            blocks.subarray(
+              offset + REPRESENTATIVE_OFFSET,
+              offset + REPRESENTATIVE_OFFSET + STATE_LENGTH
+            ),
+            slot * STATE_LENGTH
+          )
+        }
+        blockCount += blocks.length / STATE_BLOCK_LENGTH
+      }
+    },
+    finish: () => {
+      if (aligner.pendingLength !== 0) throw new Error('Blocks are not valid')
+
+      const states = accounts.values
+      const total = new Uint8Array(SUM_LENGTH)
+      const weights = createKeyTable(SUM_LENGTH)
+      accounts.forEach(slot => {
+        const balanceOffset = slot * STATE_LENGTH + 32
+        addToSum(total, 0, states, balanceOffset)
+        const weight = weights.insert(states, slot * STATE_LENGTH)
+        addToSum(weights.values, weight * SUM_LENGTH, states, balanceOffset)
+      })
+
+      const slots: number[] = []
+      const sums = weights.values
+      weights.forEach(slot => {
+        for (let i = 0; i < SUM_LENGTH; i++) {
+          if (sums[slot * SUM_LENGTH + i] !== 0) {
+            slots.push(slot)
+            return
+          }
+        }
+      })
+      const keys = weights.keys
+      // the heaviest first, then by public key
+      slots.sort(
+        (a, b) =>
+          compareBytes(
+            sums,
+            b * SUM_LENGTH,
+            sums,
+            a * SUM_LENGTH,
+            SUM_LENGTH
+          ) || compareBytes(keys, a * 32, keys, b * 32, 32)
+      )
+
+      const exceedsSupply =
+        compareBytes(total, 0, supplySum, 0, SUM_LENGTH) > 0
+      const unaccounted = new Uint8Array(U128_LENGTH)
+      if (!exceedsSupply) {
+        unaccounted.set(supplyBytes)
+        subtractU128(unaccounted, 0, total, SUM_HIGH_LENGTH)
+      }
+
+      return {
+        blockCount,
+        accountCount: accounts.size,
+        total: uintToString(total, 0, SUM_LENGTH),
+        supply,
+        exceedsSupply,
+        unaccounted: u128ToString(unaccounted),
+        weights: slots.map(slot => ({
+          representative: unsafeDeriveCachedAddress(
+            byteArrayToHex(keys.subarray(slot * 32, (slot + 1) * 32))
+          ),
+          weight: uintToString(sums, slot * SUM_LENGTH, SUM_LENGTH),
+        })),
+      }
+    },
+  }
+}
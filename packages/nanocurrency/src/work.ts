@@ -3,10 +3,9 @@
  * Copyright (c) 2019 Marvin ROGER <dev at marvinroger dot fr>
  * Licensed under GPL-3.0 (https://git.io/vAZsK)
  */
-import BigNumber from 'bignumber.js'
-import { blake2bFinal, blake2bInit, blake2bUpdate } from 'blakejs'
+import { blake2b } from 'blakejs'
 import { checkHash, checkThreshold, checkWork } from './check'
-import { byteArrayToHex, hexToByteArray } from './utils'
+import { hexToByteArray } from './utils'
 
 export const DEFAULT_WORK_THRESHOLD = 'ffffffc000000000'
 
@@ -20,6 +19,37 @@ export interface ValidateWorkParams {
   threshold?: string
 }
 
+/**
+ * Validate whether or not the work value meets the difficulty for the given
+ * hash.
+ *
+ * **Unchecked:** the parameters are not validated, use [[validateWork]]
+ * unless they already are.
+ *
+ * @param blockHashBytes - The 32 bytes block hash to validate the work against
+ * @param workBytes - The 8 bytes work to validate, big-endian
+ * @param thresholdBytes - The 8 bytes threshold to validate against, big-endian
+ * @returns Valid
+ */
+export function unsafeValidateWork(
+  blockHashBytes: Uint8Array,
+  workBytes: Uint8Array,
+  thresholdBytes: Uint8Array
+): boolean {
+  const input = new Uint8Array(8 + blockHashBytes.length)
+  for (let i = 0; i < 8; i++) input[i] = workBytes[7 - i]
+  input.set(blockHashBytes, 8)
+  const output = blake2b(input, null, 8)
+
+  // the output is little-endian, compare it from its most significant byte
+  for (let i = 0; i < 8; i++) {
+    const byte = output[7 - i]
+    if (byte !== thresholdBytes[i]) return byte > thresholdBytes[i]
+  }
+
+  return true
+}
+
 /**
  * Validate whether or not the work value meets the difficulty for the given hash.
  *
@@ -33,16 +63,9 @@ export function validateWork(params: ValidateWorkParams): boolean {
   if (!checkWork(params.work)) throw new Error('Work is not valid')
   if (!checkThreshold(thresholdHex)) throw new Error('Threshold is not valid')
 
-  const threshold = new BigNumber(`0x${thresholdHex}`)
-  const hashBytes = hexToByteArray(params.blockHash)
-  const workBytes = hexToByteArray(params.work).reverse()
-
-  const context = blake2bInit(8)
-  blake2bUpdate(context, workBytes)
-  blake2bUpdate(context, hashBytes)
-  const output = blake2bFinal(context).reverse()
-  const outputHex = byteArrayToHex(output)
-  const outputBigNumber = new BigNumber(`0x${outputHex}`)
-
-  return outputBigNumber.isGreaterThanOrEqualTo(threshold)
+  return unsafeValidateWork(
+    hexToByteArray(params.blockHash),
+    hexToByteArray(params.work),
+    hexToByteArray(thresholdHex)
+  )
 }